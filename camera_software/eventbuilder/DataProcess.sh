@@ -41,43 +41,18 @@ Path_reload () {
 	LOGFILE="${CTRLSFWR}/fcutils/test/LOGS/FileProcess.log"
 }
 
-Search_for_files () {
-	echo "Searching in: ${SEARCH_DIR}"
-	FILE_NAME_1=( $(find $SEARCH_DIR -maxdepth 1 -not -path '*/\.*' -type f -name "*AsAd0*.graw" -cmin -5 | sed 's/^\.\///g' | sort -n) )
-	FILE_NAME_2=( $(find $SEARCH_DIR -maxdepth 1 -not -path '*/\.*' -type f -name "*TB*.bin" -cmin -5 | sed 's/^\.\///g' | sort -n) )
-	len=${#FILE_NAME_1[*]}
-
-	FILE1=( ${FILE_NAME_1[*]##*/} )	# this removes the path from filename
-	FILE2=( ${FILE_NAME_2[*]##*/} )
-
-	FILENOEXT1=( ${FILE1[*]%.*} )		# this removes the extension from filename
-	FILENOEXT2=( ${FILE2[*]%.*} )
-	i=$((0))
-
-	while [ $i -lt $len ]
-	do
-		printf "FILE SEARCH: Here is the list of found files for processing ...\n"
-		echo "FILE SEARCH: ${FILE_NAME_1}"
-
-		INPUTFILERAW="${SEARCH_DIR}${FILENOEXT1[$((i))]}"
-		INPUTFILETB="${SEARCH_DIR}${FILENOEXT2[$((i))]}"
-
-		echo "FILE SEARCH: Event Builder Started"
-		echo ${EVENTBUILDER} ${COBOFORMAT} ${INPUTFILERAW} ${INPUTFILETB} ${OUTMRG}
-		${EVENTBUILDER} ${COBOFORMAT} ${INPUTFILERAW} ${INPUTFILETB} ${OUTMRG}
-
-		echo "FILE SEARCH: Moving Files"
-		sleep 1s
-		mv ${INPUTFILERAW}.graw ${RAW_FILES_DIR}${FILE1[$((i))]}
-		mv ${INPUTFILETB}.bin ${RAW_FILES_DIR}
-		i=$(($i+1))
-	done
+Seconds_to_midnight () {
+	echo $(( $(date -d 'tomorrow 00:00' +%s) - $(date +%s) ))
 }
 
+# EventBuilder runs as a service watching SEARCH_DIR: runs are built as soon as their
+# files are complete, a .done marker is written to OUTMRG and the raw files are moved
+# to RAW_FILES_DIR. The service is restarted at midnight to follow the dated RUNDIR.
 while true; do
 	LT=`date "+%y-%m-%d %H:%M:%S"`
-	printf "[${LT}] FILE SEARCH: Searching for new files ...\n"
 	Path_reload
-	Search_for_files
-	sleep 60s
+	printf "[${LT}] FILE SEARCH: Watching ${SEARCH_DIR} for new files ...\n"
+	echo ${EVENTBUILDER} ${COBOFORMAT} --watch ${SEARCH_DIR} ${OUTMRG} --archive ${RAW_FILES_DIR}
+	timeout --signal=TERM $(Seconds_to_midnight) ${EVENTBUILDER} ${COBOFORMAT} --watch ${SEARCH_DIR} ${OUTMRG} --archive ${RAW_FILES_DIR}
+	sleep 1s
 done
@@ -0,0 +1,72 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <sys/types.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class EventBuilder;
+
+/**
+ * Reprocessing of many runs with a bounded pool of EventBuilder processes.
+ * -----------------------------------------
+ * Usage:
+ * The runs are read from a list file, one run per line as on the EventBuilder command
+ * line ("CoBo prefixes" "TB prefix", '#' starts a comment), or from a directory, where the
+ * CoBo0_AsAd0_*.graw files, with the files of their other AsAds, and the TB*.bin files are
+ * paired in name order as DataProcess.sh pairs them.
+ * Run() builds up to SetJobs() runs at once, each in a child process forked from the
+ * loaded EventBuilder, so the frame formats and pixel map are read once. A child may use
+ * SetMemoryLimit() MB of heap (RLIMIT_DATA, the read-only mapped input files are not
+ * counted); a run exceeding it fails alone. The output of every run goes to
+ * <outDir>/<AsAd0 file name>.log.
+ * A built run gets the .done marker of the watch mode (see RunFiles.h). Runs listed in a
+ * marker are skipped, so an interrupted batch resumes where it stopped. Stop() (also called
+ * on SIGINT/SIGTERM) launches no further run and lets the running ones finish; a second
+ * Stop() terminates them, and they are built again on the next start.
+ * -----------------------------------------
+ */
+class BatchRunner {
+public:
+    BatchRunner(EventBuilder &builder, std::string input, std::string outDir);
+
+    void SetJobs(int nJobs);
+    void SetMemoryLimit(long megabytes);
+    int Run();
+    static void Stop();
+
+private:
+    // a run as given to EventBuilder::mainFlow, and its file names for the marker
+    struct BatchRun {
+        std::string coboPrefixes;
+        std::string tbPrefix;
+        std::vector<std::string> asadFiles;
+        std::string tbName;
+    };
+
+    void ReadList();
+    void ReadDirectory();
+    void AddRun(const std::vector<std::string> &coboPrefixes, const std::string &tbPrefix);
+    void Launch(const BatchRun &run);
+    void BuildRun(const BatchRun &run);
+    void WaitChild();
+
+    EventBuilder &builder;
+    std::string input;
+    std::string outDir;
+    int nJobs;
+    long memoryLimit;
+
+    std::vector<BatchRun> runs;
+    std::set<std::string> processedFiles;
+    // running children and the AsAd0 file of their run
+    std::map<pid_t, std::string> children;
+    bool terminated;
+    std::vector<std::string> failedRuns;
+    int nBuilt;
+};
+
+#endif
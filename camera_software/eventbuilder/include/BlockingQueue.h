@@ -0,0 +1,55 @@
+#ifndef BLOCKINGQUEUE_H
+#define BLOCKINGQUEUE_H
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+/**
+ * Minimal thread safe FIFO used between the stages of the EventBuilder pipeline.
+ * -----------------------------------------
+ * pop() blocks until an element is available. Once close() has been called and
+ * the queue is drained, pop() returns false so consumers know to stop.
+ * -----------------------------------------
+ */
+template <class T>
+class BlockingQueue {
+public:
+    BlockingQueue() : closed(false) {}
+
+    void push(const T &value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            items.push(value);
+        }
+        cond.notify_one();
+    }
+
+    bool pop(T &value)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this]{ return !items.empty() || closed; });
+        if(items.empty()) return false;
+        value = items.front();
+        items.pop();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        cond.notify_all();
+    }
+
+private:
+    std::queue<T> items;
+    std::mutex mtx;
+    std::condition_variable cond;
+    bool closed;
+};
+
+#endif
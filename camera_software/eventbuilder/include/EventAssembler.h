@@ -0,0 +1,53 @@
+#ifndef EVENTASSEMBLER_H
+#define EVENTASSEMBLER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <vector>
+
+#include "GrawReader.h"
+
+/**
+ * Frames of one event across all CoBo/AsAd streams.
+ * frames[s] is the frame index in stream s, -1 if that stream has no frame for the event.
+ */
+struct AssembledEvent {
+    uint32_t eventIdx;
+    std::vector<int> frames;
+    int nMissing;
+};
+
+/**
+ * Joins the frames of several .graw streams on the CoBo header eventIdx.
+ * -----------------------------------------
+ * Usage:
+ * assemble() works only on the frame indices built by GrawReader, no frame data is read.
+ * Every stream is walked once and its frames are merged into a table sorted by eventIdx,
+ * so streams do not need to be in lockstep. Events with missing fragments are kept and
+ * counted, frames found out of eventIdx order and repeated eventIdx are counted as well;
+ * printReport() lists them instead of aborting the run.
+ * -----------------------------------------
+ */
+class EventAssembler {
+public:
+    EventAssembler();
+
+    void assemble(const std::vector<GrawReader*> &streams);
+    void clear();
+
+    size_t getEventCount() const;
+    const AssembledEvent &getEvent(size_t indx) const;
+
+    size_t getMissingFragmentCount() const;
+    size_t getOutOfOrderCount() const;
+    size_t getDuplicateCount() const;
+    void printReport(std::ostream &out, const std::vector<GrawReader*> &streams) const;
+
+private:
+    std::vector<AssembledEvent> events;
+    size_t missingFragments;
+    size_t outOfOrderFrames;
+    size_t duplicateFrames;
+};
+
+#endif
@@ -7,6 +7,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 
 #include <mfm/Frame.h>
@@ -30,6 +34,16 @@
 #include <TFile.h>
 #include "TBDecoder.cpp"
 #include "PixelMap.h"
+#include "GrawReader.h"
+#include "GrawIndex.h"
+#include "EventAssembler.h"
+#include "FrameDecoder.h"
+#include "BlockingQueue.h"
+#include "OutputConfiguration.h"
+#include "TriggerJoiner.h"
+#include "RunLog.h"
+#include "RunStatistics.h"
+#include "PulseExtractor.h"
 
 #define Bifocal     1
 #define DiscTest    2
@@ -43,6 +57,13 @@
 #define ASAD2       2
 #define ASAD3       3
 
+#define TreeBiFocal     0
+#define TreeForced      1
+#define TreeHLED        2
+#define TreeTest        3
+#define NofTrees        4
+
+#define MaxNofAsads             2
 #define MaxNofChannels			256
 #define MaxChannelsPerAget		68
 #define ROIMaxNofChannels       36
@@ -50,6 +71,9 @@
 #define HLEDMaxTimeBucket       512
 #define BiPedestalTimeBucket    10
 
+// events written between two releases of the mapped CoBo pages
+#define ReleaseInterval         1000
+
 using mfm::Frame;
 
 struct STRUCT_Bifocal
@@ -80,6 +104,32 @@ struct STRUCT_Hled
     UInt_t SignalValue[MaxNofChannels][HLEDMaxTimeBucket];
 };
 
+/**
+ * One event on its way through the EventBuilder pipeline: filled with the trigger board record by the
+ * reader, decoded by a worker and written to its tree by the writer. Slots are reused between events.
+ */
+struct EventSlot
+{
+    int eventIndex;             // position in the output, events are written in this order
+    int coboIndex;              // event index in the EventAssembler
+    int treeID;                 // TreeBiFocal, TreeForced, TreeHLED or TreeTest
+    const char *triggerName;    // printed by the writer
+    std::string error;          // set by the worker if the event could not be built
+
+    // trigger board record
+    int32_t eventNumber_TB;
+    uint64_t eventTime_TB;
+    uint8_t triggerSource_TB;
+    uint32_t FirstTrigMusic_TB;
+
+    uint32_t eventIdx_CoBo;     // eventIdx shared by the frames of all AsAds
+    int nMissing;               // number of AsAds without a frame for this event
+    double decodeSeconds;       // time the worker spent building the event
+
+    Event *event;
+    std::vector<ExtractedData> extracted;   // pulse extraction of the event, when enabled
+};
+
 // Class Definition
 class EventBuilder{
 private: //member variables
@@ -87,10 +137,20 @@ private: //member variables
 	// pointer to TBDecoder object for accessing triggerboard data
 	//TBDecoder *TBEvents;
 
-	// var containing filename
-	std::ifstream f_raw;
-	std::ifstream f_raw_0;
-	std::ifstream f_raw_1;
+	// read-only mappings of the CoBo files, one per AsAd, indexed once per file
+	std::vector<GrawReader*> grawReaders;
+	// frames of all AsAds joined on eventIdx
+	EventAssembler eventAssembler;
+	// trigger board records joined with the assembled events on the event counters
+	TriggerJoiner triggerJoiner;
+
+	// compiled decoder for frame types 1 and 2, generic decoding is used when disabled
+	FrameDecoder *frameDecoder;
+	bool fastDecoding;
+
+	// number of decode/ROI worker threads, and lock for the generic decoding (shared frame/item/field members)
+	int nThreads;
+	std::mutex genericMutex;
 
 	// vectors for storing the order of events in a file for each asadID
 	// necessary because events are stored sequentially for each asad but not for the file as a whole.
@@ -109,13 +169,6 @@ private: //member variables
     uint64_t eventTime_CoBo;
     uint32_t eventIdx_CoBo;
     uint8_t asadIdx_CoBo;
-    uint32_t eventIdx_CoBo_asad0; //used to confirm data from asad0 and asad1 are paired properly.
-
-    // current event variables from trigger board
-    int32_t eventNumber_TB;
-    uint64_t eventTime_TB;
-    uint8_t triggerSource_TB;
-    uint32_t FirstTrigMusic_TB;
 
 	// pointers to TTrees and TFile for storing data
 	/*
@@ -125,8 +178,20 @@ private: //member variables
     */
 
     // pixelMapDecoder Variables
-    uint16_t sipmID;
     int **pixelMapArray; //stores csv data in heap
+    PixelMapLUT pixelMapLUT; //dense channel <-> pixel tables, built once from pixelMapArray
+
+    // per tree ROOT output settings
+    OutputConfiguration outputConfig;
+    // ExACT pulse extraction of the events as they are built, NULL when not enabled
+    PulseExtractor *pulseExtractor;
+    // ROOT files written by the last run
+    std::vector<std::string> outputFiles;
+
+    // counters of the current run, written as JSON records to statsFileName (or <run>_stats.json)
+    RunStatistics stats;
+    std::string statsFileName;
+    int statsInterval;
 
 	const size_t numChips = 4u;
 	const size_t numChannels = 68u;
@@ -137,24 +202,48 @@ public:
 	// Destructor
 	~EventBuilder();
 private:
-	void logTBevent(int eventID, TBDecoder *TBEvents);
+	void logTBevent(int eventID, TBDecoder *TBEvents, EventSlot &slot);
+	int JoinTriggerBoard(TBDecoder *TBEvents, std::string TB_filename, int nCoboEvents, std::string Out_filename);
 	uint16_t FindTrigSource(int eventID);
 	int FindPixel(int nx, int ny);
 	void FindBin(int iPix,int *nx, int *ny);
-	vector<int> FindNeighborPixels(int FirstTrigMusic);
-	int FrameCounter(std::string CoBo_filename, int asadIdx);
+	vector<int> FindNeighborPixels(int FirstTrigMusic, int halo = 0);
+	void KeepROITraces(EventSlot &slot);
+	void ExtractPulses(EventSlot &slot);
+	int FrameCounter(std::vector<std::string> CoBo_filenames);
+	void CloseStreams();
 	void logCoBoEvent(std::auto_ptr<mfm::Frame> &tempFrame);
+	void DecodeFrame(int asadIdx, int frameIdx, Event *event);
+	void DecodeEvent(EventSlot &slot);
+	void DecodeGenericFrame(int asadIdx, Event *event);
 	/*void Set_Branch_Bifocal(Event *eventBifocal);
 	void Set_Branch_Background(Event *eventForced);
 	void Set_Branch_Hled(Event *eventHled);*/
-	void Write_BifocalEvent(std::string CoBo_filename, Event *eventBifocal, int asadIdx, int event_index, std::vector<std::vector<Int_t>> &signalValue, long startTime);
-	void Write_BackgroundEvent(std::string CoBo_filename, Event *eventForced, int asadIdx, int event_index,std::vector<std::vector<Int_t>> &signalValue,long startTime);
-	void Write_HledEvent(std::string CoBo_filename, Event *eventHled, int asadIdx, int event_index,std::vector<std::vector<Int_t>> &signalValue,long startTime);
-	void Write_TestEvent(std::string CoBo_filename, Event *eventHled, int asadIdx, int event_index,std::vector<std::vector<Int_t>> &signalValue,long startTime);
+	void SetEventHeader(EventSlot &slot, long startTime);
+	void Write_BifocalEvent(EventSlot &slot, long startTime);
+	void Write_BackgroundEvent(EventSlot &slot, long startTime);
+	void Write_HledEvent(EventSlot &slot, long startTime);
+	void Write_TestEvent(EventSlot &slot, long startTime);
+	void SelectTree(EventSlot &slot);
+	void BuildEvent(EventSlot &slot, long startTime);
+	void ReportOutput(TTree **trees, std::chrono::steady_clock::time_point runStart);
+	TFile *OpenOutput(std::string fileName, TTree **trees, Event **treeEvents);
+	TFile *OpenExtractedOutput(std::string fileName, TTree **trees);
+	bool KeepRawEvent(int treeID, Long64_t *treeCounters);
+	void CloseOutput(TFile *f, TTree **trees, std::chrono::steady_clock::time_point fileStart);
+	void ReleaseFrames(int coboIndex);
 	//void Write_Tree_to_file();
 
 public:
 	// member function definitions
-	void mainFlow(std::string CoBo_filename,  std::string filename_tb, std::string outDir);
+	void SetFastDecoding(bool enable);
+	void SetThreads(int nThreads);
+	bool ReadOutputConfig(std::string cfgFile);
+	bool SetPulseExtraction(std::string cfgFile);
+	void SetStatsFile(std::string fileName);
+	void SetStatsInterval(int seconds);
+	const RunStatistics &GetStatistics() const;
+	const std::vector<std::string> &GetOutputFiles() const;
+	std::string mainFlow(std::string CoBo_filename,  std::string filename_tb, std::string outDir);
 
 };
@@ -0,0 +1,53 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include <Rtypes.h>
+
+#include "GrawReader.h"
+#include "PixelMap.h"
+
+#define DecoderNofAsads         PixelMapNofAsads
+#define DecoderNofAgets         PixelMapNofAgets
+#define DecoderChannelsPerAget  PixelMapChannelsPerAget
+#define DecoderPartialReadout   1
+#define DecoderFullReadout      2
+
+/**
+ * Fixed-layout decoder for CoBo frames of type 1 (partial readout) and 2 (full readout, compact).
+ * -----------------------------------------
+ * Usage:
+ * The header of a frame is validated once with isSupported(), then decode() unpacks every item
+ * directly from the mapped frame bytes into the flat trace array of an Event, using the dense
+ * channel lookup table of the pixel map. FPN channels (11, 22, 45, 56) and channels missing
+ * from the pixel map are skipped.
+ * Frames whose layout is not recognised are left untouched and decode() returns false, the
+ * caller is then expected to use the generic mfm::Frame field access instead.
+ * Type 1 frames only carry the samples kept by the zero suppression: decode() clears the pixels
+ * of the AsAd first with clear(), so that a reused trace buffer keeps nothing of an earlier event.
+ *
+ * Type 1 items (4 bytes): agetIdx bits 30-31, chanIdx bits 23-29, buckIdx bits 14-22, sample bits 0-11.
+ * Type 2 items (2 bytes): agetIdx bits 14-15, sample bits 0-11. Channels come in order for each aget,
+ * the bucket index is incremented every 68 channels.
+ * -----------------------------------------
+ */
+class FrameDecoder {
+public:
+    FrameDecoder(const PixelMapLUT &pixelMap);
+
+    bool isSupported(const GrawFrame &frame, int asadIdx) const;
+    bool decode(const GrawFrame &frame, int asadIdx, UShort_t *traces, int nPixels, int nSamples, size_t maxItems) const;
+    void clear(int asadIdx, UShort_t *traces, int nPixels, int nSamples) const;
+
+private:
+    void decodePartialReadout(const GrawFrame &frame, const int16_t (*lut)[DecoderChannelsPerAget], UShort_t *traces, int nSamples, size_t nItems) const;
+    void decodeFullReadout(const GrawFrame &frame, const int16_t (*lut)[DecoderChannelsPerAget], UShort_t *traces, int nSamples, size_t nItems) const;
+
+    // pixel map owned by the caller, negative sipmID for FPN and unmapped channels
+    const PixelMapLUT &pixelMap;
+    int maxSipmID[DecoderNofAsads];
+};
+
+#endif
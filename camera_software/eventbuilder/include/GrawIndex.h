@@ -0,0 +1,38 @@
+#ifndef GRAWINDEX_H
+#define GRAWINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Sidecar frame index of a .graw file, written by GetBench FrameStorage or by GrawIndexer.
+ * -----------------------------------------
+ * The index of CoBo0_AsAd0_<timestamp>_0000.graw is CoBo0_AsAd0_<timestamp>_0000.gidx.
+ * All values are little endian.
+ * Header, 16 bytes: "GIDX", version (uint32), record size (uint32), reserved (uint32).
+ * Records, 24 bytes each, one per frame in file order:
+ *   offset (uint64), frame size in bytes (uint32), eventIdx (uint32),
+ *   frameType (uint16), coboIdx (uint8), asadIdx (uint8), reserved (uint32).
+ * Records are appended while the run is taken, a trailing partial record is ignored.
+ * -----------------------------------------
+ */
+
+#define GrawIndexVersion        1
+#define GrawIndexHeaderSize     16
+#define GrawIndexRecordSize     24
+
+struct GrawIndexRecord {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t eventIdx;
+    uint16_t frameType;
+    uint8_t coboIdx;
+    uint8_t asadIdx;
+};
+
+std::string grawIndexFileName(const std::string &grawFileName);
+bool readGrawIndex(const std::string &indexFileName, std::vector<GrawIndexRecord> &records);
+bool writeGrawIndex(const std::string &indexFileName, const std::vector<GrawIndexRecord> &records);
+
+#endif
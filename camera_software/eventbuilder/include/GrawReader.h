@@ -0,0 +1,98 @@
+#ifndef GRAWREADER_H
+#define GRAWREADER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mfm/Frame.h>
+
+/**
+ * Location and header summary of a single CoBo frame inside a memory-mapped .graw file.
+ * -----------------------------------------
+ * data points directly into the read-only mapping, nothing is copied.
+ * Only the header fields needed to build events are decoded, the items are
+ * left in place for the decoders.
+ * -----------------------------------------
+ */
+struct GrawFrame {
+    const char *data;       // first byte of the frame (primary header)
+    uint64_t offset;        // byte offset of the frame from the start of the file
+    uint32_t size;          // total frame size in bytes
+    uint16_t frameType;     // 1: partial readout, 2: full readout (compact)
+    uint8_t revision;
+    bool bigEndian;
+    uint32_t headerSize;    // header size in bytes, items start here
+    uint16_t itemSize;      // item size in bytes
+    uint32_t itemCount;
+    uint64_t eventTime;
+    uint32_t eventIdx;
+    uint8_t coboIdx;
+    uint8_t asadIdx;
+};
+
+/**
+ * Read-only, mmap backed frame source for a single .graw file.
+ * -----------------------------------------
+ * Usage:
+ * open() maps the file and walks the MFM primary headers once, recording the
+ * position of every CoBo data frame (frame types 1 and 2). Frames of other
+ * types are skipped. The number of frames is then known without reading any
+ * item data, and frames can be accessed in any order through getFrame().
+ * readFrame() builds an mfm::Frame for code that still needs the generic
+ * field access.
+ * When a sidecar .gidx index (see GrawIndex.h) exists it replaces the scan:
+ * frame positions and eventIdx come from the index and the rest of a frame
+ * header is only decoded on first access through getFrame(). Frames appended
+ * after the last indexed one are still found by scanning.
+ * releasePages() gives back the mapped pages before a frame once the caller is
+ * done with them, so the resident memory of a long run stays bounded.
+ * -----------------------------------------
+ */
+class GrawReader {
+public:
+    GrawReader();
+    ~GrawReader();
+
+    void open(const std::string &fileName, bool useIndex = true);
+    void close();
+    bool isOpen() const;
+    bool isIndexed() const;
+
+    size_t getFrameCount() const;
+    size_t getSkippedFrameCount() const;
+    uint32_t getEventIdx(size_t indx) const;
+    const GrawFrame &getFrame(size_t indx) const;
+    std::auto_ptr<mfm::Frame> readFrame(size_t indx) const;
+    const std::string &getFileName() const;
+    size_t getFileSize() const;
+    void releasePages(size_t indx) const;
+
+private:
+    GrawReader(const GrawReader &);
+    GrawReader &operator=(const GrawReader &);
+
+    bool loadIndex(uint64_t &indexedEnd);
+    void scanHeaders(uint64_t offset);
+    bool decodeHeader(uint64_t offset, GrawFrame &frame) const;
+
+    std::string fileName;
+    int fd;
+    const char *mapBegin;
+    size_t mapSize;
+    size_t skippedFrames;
+    bool indexed;
+
+    // frames read from an index get their full header on first access, the flags are
+    // checked without the lock so that decoded frames do not serialise the workers
+    mutable std::vector<GrawFrame> frames;
+    mutable std::deque<std::atomic<uint8_t> > headerDecoded;
+    mutable std::mutex headerMutex;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef OUTPUTCONFIGURATION_H
+#define OUTPUTCONFIGURATION_H
+
+#include <string>
+
+#include <Rtypes.h>
+
+#define OutputNofTrees      4
+
+/**
+ * ROOT output settings of one event tree.
+ * compressionSettings follows the ROOT convention, 100 * algorithm + level,
+ * -1 keeps the compression of the output file.
+ */
+struct TreeOutputConfig {
+    Int_t basketSize;
+    Int_t splitLevel;
+    Int_t compressionSettings;
+    Long64_t autoFlush;     // entries if > 0, bytes if < 0, ROOT default if 0
+    Long64_t autoSave;      // same convention as autoFlush
+    Int_t roiHalo;          // ROI-only storage halo in pixels, -1 stores all traces
+    Long64_t rawPrescale;   // with pulse extraction, raw events kept: one in n, 0 for none
+};
+
+/**
+ * Per tree ROOT output layout of the EventBuilder, read from EventBuilder.cfg.
+ * -----------------------------------------
+ * Usage:
+ * Lines starting with '*' are read, in the format of ExACT.cfg:
+ *   * BASKETSIZE <TREE> <bytes>
+ *   * SPLITLEVEL <TREE> <level>
+ *   * COMPRESSION <TREE> <ZLIB|LZMA|LZ4|ZSTD|NONE> <level>
+ *   * AUTOFLUSH <TREE> <n>
+ *   * AUTOSAVE <TREE> <n>
+ *   * ROISTORAGE <TREE> <halo>
+ *   * RAWTRACES <TREE> <n>
+ *   * SPLITEVENTS <n>
+ *   * SPLITSIZE <MB>
+ * <TREE> is BIFOCAL, FORCED, HLED, TEST or ALL, in the order of the EventBuilder tree IDs.
+ * ROISTORAGE keeps full traces only for the region of interest grown by <halo> pixels
+ * on each side, the other pixels keep the mean and RMS of their trace (Event::KeepPixels).
+ * It applies to the events that have a region of interest (BIFOCAL and TEST).
+ * RAWTRACES only applies when the EventBuilder extracts the pulses itself: every event
+ * goes to the extracted trees, and one event in <n> of the tree is also written with its
+ * traces, 1 for all of them, 0 for none.
+ * SPLITEVENTS and SPLITSIZE apply to the whole output: a new ROOT file is started once
+ * the current one holds n events or reaches the given size, 0 writes a single file.
+ * Settings that are not given keep the values EventBuilder always used:
+ * basket size 64000, split level 0, the TFile compression, the ROOT default
+ * autoflush and autosave, and all traces of all events stored.
+ * -----------------------------------------
+ */
+class OutputConfiguration {
+public:
+    OutputConfiguration();
+
+    bool Read(std::string cfgFile);
+    const TreeOutputConfig &GetTreeConfig(int treeID) const;
+    Long64_t GetSplitEvents() const;
+    Long64_t GetSplitSize() const;
+    void Print() const;
+
+private:
+    void ReadLine(std::string iline);
+
+    TreeOutputConfig trees[OutputNofTrees];
+    Long64_t splitEvents;   // events per output file, 0 for no limit
+    Long64_t splitSize;     // bytes per output file, 0 for no limit
+};
+
+#endif
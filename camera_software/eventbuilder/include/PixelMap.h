@@ -1,13 +1,40 @@
-#ifndef PIXELMPAP_H
+#ifndef PIXELMAP_H
 #define PIXELMAP_H
 
 #include<iostream>
+#include<stdint.h>
 using namespace std;
 
+#define PixelMapNofAsads         2
+#define PixelMapNofAgets         4
+#define PixelMapChannelsPerAget  68
+#define PixelMapNofSipms         512
+#define PixelMapSipmsPerMusic    8
+
+// PixelMapLUT::sipmID of channels without a pixel
+#define PixelMapUnmapped         -1
+#define PixelMapFPN              -2
+
+/**
+ * Dense two way lookup tables built once from the csv pixel map, so that the decoding
+ * loops only index an array.
+ * sipmID[asad][aget][channel] is the pixel of a channel, PixelMapFPN for the FPN channels
+ * 11, 22, 45 and 56 and PixelMapUnmapped for channels not listed in the csv.
+ * asadID, agetID, channelID and musicID give the position of a pixel, -1 if it is not listed.
+ */
+struct PixelMapLUT {
+	int16_t sipmID[PixelMapNofAsads][PixelMapNofAgets][PixelMapChannelsPerAget];
+	int8_t asadID[PixelMapNofSipms];
+	int8_t agetID[PixelMapNofSipms];
+	int8_t channelID[PixelMapNofSipms];
+	int16_t musicID[PixelMapNofSipms];
+};
+
 void pixelMapDecoder(int **pixelMapArray, uint16_t sipmID, uint16_t *asadID, uint16_t *agetID, uint16_t *channelID);
 void pixelMapEncoder(int **pixelMapArray, uint16_t *sipmID, uint16_t asadID, uint16_t agetID, uint16_t channelID);
 int** openPixelMap(string pixelMapCSV);
 void closePixelMap(int **pixelMapArray);
+void buildPixelMapLUT(int **pixelMapArray, PixelMapLUT *lut);
 int myMain(int argc, char *argv[]);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef PULSEEXTRACTOR_H
+#define PULSEEXTRACTOR_H
+
+#include <string>
+#include <vector>
+
+#include <TTree.h>
+
+#include <Event.h>
+#include <ExtractedData.h>
+#include <IExtractedTree.h>
+#include <ReadConfiguration.h>
+
+#define ExtractorNofTrees   4
+
+/**
+ * Pulse extraction of ExACT run on the events as they are built.
+ * -----------------------------------------
+ * Usage:
+ * Extract() reduces every pixel of a decoded Event to its ExtractedData with PulseBatch
+ * and the ExACT.cfg settings, as PulseExtraction() of ExACT does when it reads the
+ * ROOT file back. It only reads the configuration and may run on several workers at once.
+ * Branch() sets up a tree in the layout of <name>_Extracted.root with IExtractedTree: one
+ * Pixel[i] branch per camera pixel, or one array branch per quantity with COLUMNAREXTRACTED,
+ * TriggerTime and, for BiFocal and Test, TriggerRegion. Fill() copies the extracted values
+ * of an event to the branches of its tree and fills it, on the writer thread only.
+ * -----------------------------------------
+ */
+class PulseExtractor {
+public:
+    PulseExtractor(std::string cfgFile);
+    ~PulseExtractor();
+
+    int GetNofPixels() const;
+    void Extract(Event *event, std::vector<ExtractedData> &pixels) const;
+    void Branch(TTree *tree, int treeID, bool withTriggerRegion);
+    void Fill(int treeID, Event *event, std::vector<ExtractedData> &pixels);
+
+private:
+    ReadConfiguration *readConf;
+
+    // branches of each tree, NULL until Branch()
+    IExtractedTree *extractedTree[ExtractorNofTrees];
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef RUNFILES_H
+#define RUNFILES_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Raw file names of a run and the .done markers of built runs, shared by the watch and
+ * batch modes.
+ * -----------------------------------------
+ * A run is a CoBo0_AsAd0_<timestamp>_0000.graw file, the files of the other AsAds with the
+ * same name and AsAd<n>, and a TB*.bin trigger board file.
+ * Once a run is built, <outDir>/<AsAd0 file without extension>.done lists its files, one
+ * per line: "input <raw file name>" for the raw files, names without directory, then
+ * "output <ROOT file>" for every file written. The marker is written under a temporary
+ * name and renamed, so a marker that exists is complete.
+ * -----------------------------------------
+ */
+
+bool endsWith(const std::string &name, const std::string &suffix);
+bool isAsAd0File(const std::string &name);
+bool isTBFile(const std::string &name);
+std::string asadFileName(const std::string &name, int asadIdx);
+std::string stripExtension(const std::string &name);
+std::string stripDirectory(const std::string &path);
+
+void readRunMarkers(const std::string &outDir, std::set<std::string> &inputFiles);
+bool writeRunMarker(const std::string &outDir, const std::vector<std::string> &asadFiles, const std::string &tbName,
+                    const std::vector<std::string> &outputFiles);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef RUNLOG_H
+#define RUNLOG_H
+
+#include <iostream>
+#include <string>
+
+#define LogError    0
+#define LogWarning  1
+#define LogInfo     2
+#define LogEvent    3
+#define LogDebug    4
+
+/**
+ * Verbosity of the EventBuilder messages.
+ * -----------------------------------------
+ * Usage:
+ * EB_LOG(LogEvent) << "Event " << n << endl;
+ * The message is only formatted and written when its level is enabled. The default
+ * level, LogInfo, prints the run summaries but none of the per event lines, which
+ * cost more than the decoding at high event rates.
+ * Levels: LogError, LogWarning, LogInfo (run summaries), LogEvent (one block per
+ * event), LogDebug.
+ * -----------------------------------------
+ */
+class RunLog {
+public:
+    static void SetLevel(int level);
+    static int GetLevel();
+    static int ParseLevel(const std::string &name);
+
+    static bool Enabled(int level)
+    {
+        return level <= currentLevel;
+    }
+
+private:
+    static int currentLevel;
+};
+
+// the else branch keeps the macro safe inside an unbraced if/else
+#define EB_LOG(level) if(!RunLog::Enabled(level)) ; else std::cout
+
+#endif
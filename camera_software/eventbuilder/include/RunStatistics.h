@@ -0,0 +1,55 @@
+#ifndef RUNSTATISTICS_H
+#define RUNSTATISTICS_H
+
+#include <stdint.h>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define StatsNofTrees   4
+
+/**
+ * Counters and timers of one EventBuilder run.
+ * -----------------------------------------
+ * Usage:
+ * mainFlow() fills the counters as the run goes, WriteJSON() writes them as one JSON
+ * object per line so that monitoring can read the file record by record. A "progress"
+ * record can be written at any time, the "run" record is written once the output is
+ * closed. Rates are computed from the wall time since Start().
+ * scanSeconds is the time to map the CoBo files and join their frames, joinSeconds the
+ * time to read the trigger board file and join it with the CoBo events.
+ * decodeSeconds is the sum over the worker threads of the time spent building events,
+ * writeSeconds the time of the writer thread in Fill() and in closing the files.
+ * -----------------------------------------
+ */
+struct RunStatistics {
+    std::string runName;
+    std::vector<std::string> inputFiles;
+    std::vector<std::string> outputFiles;
+    std::chrono::steady_clock::time_point start;
+
+    uint64_t events;                    // events written
+    uint64_t treeEvents[StatsNofTrees]; // events written per tree, in tree ID order
+    uint64_t failedEvents;              // events that could not be built
+    uint64_t frames;                    // CoBo frames decoded
+    uint64_t missingFragments;
+    uint64_t outOfOrderFrames;
+    uint64_t repeatedEventIdx;
+    uint64_t tbOrphans;
+    uint64_t coboOrphans;
+    uint64_t inputBytes;                // CoBo and trigger board files
+    uint64_t outputBytes;               // compressed tree bytes
+    uint64_t outputRawBytes;            // uncompressed tree bytes
+    double scanSeconds;
+    double joinSeconds;
+    double decodeSeconds;
+    double writeSeconds;
+
+    RunStatistics();
+    void Start(const std::string &name);
+    double ElapsedSeconds() const;
+    void WriteJSON(std::ostream &out, const char *recordType) const;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef RUNWATCHER_H
+#define RUNWATCHER_H
+
+#include <time.h>
+
+#include <deque>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class EventBuilder;
+
+/**
+ * Long running EventBuilder service, replacing the polling loop of DataProcess.sh.
+ * -----------------------------------------
+ * Usage:
+ * Run() watches the input directory with inotify and builds a run as soon as its files
+ * have been closed by the writers: the CoBo0_AsAd0_*.graw file, the files of the other
+ * AsAds of the same run (same name with AsAd<n>) if they exist, and the next TB*.bin file.
+ * GetBench FrameStorage closes a .graw file after every frame, so a file counts as
+ * complete once it has not been closed again for the settle time (5 s by default).
+ * CoBo and TB files are paired in the order they are closed, as the poll loop paired them
+ * in name order. The EventBuilder, with its frame formats and pixel map, is loaded once
+ * and reused for every run.
+ * After a run, a <name>.done marker listing the input and output files is written to the
+ * output directory, and the raw files are moved to the archive directory if one is set.
+ * Files already present at start-up are processed unless a marker lists them.
+ * Stop() (also called on SIGINT/SIGTERM) ends Run() once the current run is written.
+ * -----------------------------------------
+ */
+class RunWatcher {
+public:
+    RunWatcher(EventBuilder &builder, std::string inputDir, std::string outDir);
+
+    void SetArchiveDirectory(std::string dir);
+    void SetSettleTime(int seconds);
+    void Run();
+    static void Stop();
+
+private:
+    void ReadMarkers();
+    void ScanExisting();
+    void FileClosed(const std::string &name, time_t closeTime);
+    bool FileSettled(const std::string &name, time_t now);
+    bool RunReady(const std::string &grawName, time_t now, std::vector<std::string> &asadFiles);
+    void ProcessReadyRuns();
+    void WriteMarker(const std::vector<std::string> &asadFiles, const std::string &tbName);
+    void Archive(const std::string &name);
+
+    EventBuilder &builder;
+    std::string inputDir;
+    std::string outDir;
+    std::string archiveDir;
+    int settleTime;
+
+    // last close time of the files of the input directory (names without directory),
+    // and the files already built according to the markers
+    std::map<std::string, time_t> closeTimes;
+    std::set<std::string> processedFiles;
+    // AsAd0 .graw and TB .bin files waiting to be paired, in closing order
+    std::deque<std::string> pendingGraw;
+    std::deque<std::string> pendingTB;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TRIGGERJOINER_H
+#define TRIGGERJOINER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "EventAssembler.h"
+
+// number of orphans listed individually by default by printReport
+#define MaxReportedOrphans  20
+
+/**
+ * One trigger board record and the CoBo event with the matching event counter.
+ */
+struct JoinedEvent {
+    int tbIndex;        // record index in the trigger board file
+    int coboIndex;      // event index in the EventAssembler
+};
+
+/**
+ * Joins trigger board records and assembled CoBo events on their event counters.
+ * -----------------------------------------
+ * Usage:
+ * The trigger board numbers its records from 1 while the CoBo eventIdx may start from 0,
+ * so join() first takes the most frequent difference between the counters of the first
+ * records paired by position. Every CoBo event is then looked up by eventIdx + offset in
+ * a hash table of the trigger board event numbers. Records found only on one side are
+ * skipped and counted, and the run goes on with the others.
+ * If no offset is shared by at least half of the first pairs, the counters are not
+ * trusted and the records are paired by position as before.
+ * printReport() lists the offset, the orphans of both sides and repeated event numbers.
+ * -----------------------------------------
+ */
+class TriggerJoiner {
+public:
+    TriggerJoiner();
+
+    void join(const std::vector<uint32_t> &tbEventNumbers, const EventAssembler &assembler, size_t nCoboEvents);
+    void clear();
+
+    size_t getEventCount() const;
+    const JoinedEvent &getEvent(size_t indx) const;
+
+    bool isPositional() const;
+    int64_t getOffset() const;
+    size_t getTBOrphanCount() const;
+    size_t getCoboOrphanCount() const;
+    void printReport(std::ostream &out, size_t maxListed = MaxReportedOrphans) const;
+
+private:
+    int64_t detectOffset(const std::vector<uint32_t> &tbEventNumbers, const EventAssembler &assembler, size_t nCoboEvents);
+
+    std::vector<JoinedEvent> events;
+    // event counters without a partner, as read from their own stream
+    std::vector<uint32_t> tbOrphans;
+    std::vector<uint32_t> coboOrphans;
+    size_t repeatedTBNumbers;
+    int64_t offset;
+    bool positional;
+};
+
+#endif
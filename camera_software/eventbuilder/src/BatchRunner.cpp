@@ -0,0 +1,291 @@
+#include "BatchRunner.h"
+#include "EventBuilder.h"
+#include "RunFiles.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// number of stop requests: the first one drains the pool, the second one terminates it
+static volatile sig_atomic_t stopRequests = 0;
+
+static void stopHandler(int)
+{
+    stopRequests++;
+}
+
+/**
+ * @return path without the .graw or .bin extension, as the EventBuilder takes it
+ */
+static string runPrefix(const string &path)
+{
+    if(endsWith(path, ".graw") || endsWith(path, ".bin")) return stripExtension(path);
+    return path;
+}
+
+/**
+ * @param input list file of runs, or directory of raw files
+ * @param outDir directory of the ROOT files, logs and .done markers
+ */
+BatchRunner::BatchRunner(EventBuilder &builder, string input, string outDir)
+    : builder(builder), input(input), outDir(outDir), nJobs(1), memoryLimit(0), terminated(false), nBuilt(0)
+{
+}
+
+/**
+ * @param nJobs number of runs built at once, at least 1
+ */
+void BatchRunner::SetJobs(int nJobs)
+{
+    this->nJobs = (nJobs < 1) ? 1 : nJobs;
+}
+
+/**
+ * @param megabytes heap limit of every run, 0 for no limit
+ */
+void BatchRunner::SetMemoryLimit(long megabytes)
+{
+    memoryLimit = (megabytes < 0) ? 0 : megabytes;
+}
+
+/**
+ * Requests Run() to launch no further run. A second request terminates the running ones.
+ * Only sets a flag, so it can be called from a signal handler.
+ */
+void BatchRunner::Stop()
+{
+    stopRequests++;
+}
+
+/**
+ * Builds every run of the input not listed in a marker of the output directory.
+ * @return number of runs not built, failed or left by a stop request
+ */
+int BatchRunner::Run()
+{
+    // no SA_RESTART, so that a signal interrupts waitpid()
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopHandler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    struct stat st;
+    if(stat(input.c_str(), &st) != 0) throw runtime_error("Can not open " + input);
+    if(S_ISDIR(st.st_mode)) ReadDirectory();
+    else ReadList();
+    readRunMarkers(outDir, processedFiles);
+
+    vector<BatchRun> pending;
+    for(size_t k=0; k<runs.size(); k++){
+        if(processedFiles.count(runs[k].asadFiles[0]) == 0) pending.push_back(runs[k]);
+    }
+    cout << runs.size() << " runs in " << input << ", " << runs.size() - pending.size() << " already built, "
+         << nJobs << " jobs" << endl;
+
+    size_t nLaunched = 0;
+    for(; nLaunched<pending.size() && !stopRequests; nLaunched++){
+        while((int)children.size() >= nJobs) WaitChild();
+        if(stopRequests) break;
+        cout << "[" << nLaunched+1 << "/" << pending.size() << "] Building run " << pending[nLaunched].asadFiles[0]
+             << " with " << pending[nLaunched].tbName << endl;
+        Launch(pending[nLaunched]);
+    }
+    if(stopRequests && !children.empty()){
+        cout << "Stopping: waiting for " << children.size() << " running runs" << endl;
+    }
+    while(!children.empty()) WaitChild();
+
+    cout << "-----------------------------------------" << endl;
+    cout << "Batch " << input << ": " << runs.size() << " runs, " << runs.size() - pending.size()
+         << " already built, " << nBuilt << " built, " << failedRuns.size() << " failed" << endl;
+    for(size_t k=0; k<failedRuns.size(); k++){
+        cout << "  failed: " << failedRuns[k] << endl;
+    }
+    if(nLaunched < pending.size()){
+        cout << "Interrupted, " << pending.size() - nLaunched << " runs left for the next start" << endl;
+    }
+    return failedRuns.size() + pending.size() - nLaunched;
+}
+
+/**
+ * Reads the runs of a list file: CoBo prefixes (comma separated) and TB prefix per line.
+ */
+void BatchRunner::ReadList()
+{
+    ifstream list(input.c_str());
+    if(!list) throw runtime_error("Can not open " + input);
+    string line;
+    while(getline(list, line)){
+        size_t comment = line.find('#');
+        if(comment != string::npos) line.erase(comment);
+        istringstream fields(line);
+        string cobo, tb;
+        if(!(fields >> cobo)) continue;
+        if(!(fields >> tb)){
+            cout << "No TB file for " << cobo << " in " << input << endl;
+            continue;
+        }
+        vector<string> coboPrefixes;
+        stringstream ss(cobo);
+        string prefix;
+        while(getline(ss, prefix, ',')){
+            if(!prefix.empty()) coboPrefixes.push_back(runPrefix(prefix));
+        }
+        AddRun(coboPrefixes, runPrefix(tb));
+    }
+}
+
+/**
+ * Pairs the AsAd0 and TB files of a directory in name order.
+ */
+void BatchRunner::ReadDirectory()
+{
+    DIR *dir = opendir(input.c_str());
+    if(dir == NULL) throw runtime_error("Can not open directory " + input);
+    vector<string> grawNames, tbNames;
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL){
+        string name = entry->d_name;
+        if(isAsAd0File(name)) grawNames.push_back(name);
+        if(isTBFile(name)) tbNames.push_back(name);
+    }
+    closedir(dir);
+    sort(grawNames.begin(), grawNames.end());
+    sort(tbNames.begin(), tbNames.end());
+    if(grawNames.size() != tbNames.size()){
+        cout << input << " holds " << grawNames.size() << " CoBo runs and " << tbNames.size()
+             << " TB files, the unpaired ones are skipped" << endl;
+    }
+
+    for(size_t k=0; k<grawNames.size() && k<tbNames.size(); k++){
+        vector<string> coboPrefixes(1, input + "/" + stripExtension(grawNames[k]));
+        for(int asadIdx=1; asadIdx<MaxNofAsads; asadIdx++){
+            string sibling = asadFileName(grawNames[k], asadIdx);
+            struct stat st;
+            if(stat((input + "/" + sibling).c_str(), &st) == 0) coboPrefixes.push_back(input + "/" + stripExtension(sibling));
+        }
+        AddRun(coboPrefixes, input + "/" + stripExtension(tbNames[k]));
+    }
+}
+
+void BatchRunner::AddRun(const vector<string> &coboPrefixes, const string &tbPrefix)
+{
+    if(coboPrefixes.empty()) return;
+    BatchRun run;
+    for(size_t k=0; k<coboPrefixes.size(); k++){
+        if(k > 0) run.coboPrefixes += ",";
+        run.coboPrefixes += coboPrefixes[k];
+        run.asadFiles.push_back(stripDirectory(coboPrefixes[k]) + ".graw");
+    }
+    run.tbPrefix = tbPrefix;
+    run.tbName = stripDirectory(tbPrefix) + ".bin";
+    runs.push_back(run);
+}
+
+/**
+ * Forks a child building the run.
+ */
+void BatchRunner::Launch(const BatchRun &run)
+{
+    // nothing buffered may be written twice
+    cout.flush();
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid < 0){
+        cout << "Can not start run " << run.asadFiles[0] << ": " << strerror(errno) << endl;
+        failedRuns.push_back(run.asadFiles[0]);
+        return;
+    }
+    if(pid == 0) BuildRun(run);
+    children[pid] = run.asadFiles[0];
+}
+
+/**
+ * Builds a run in the child process and exits, with status 0 once its marker is written.
+ */
+void BatchRunner::BuildRun(const BatchRun &run)
+{
+    // Ctrl-C reaches the whole process group, the parent decides what the children do
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+
+    string logName = outDir + "/" + stripExtension(run.asadFiles[0]) + ".log";
+    int logFd = open(logName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(logFd >= 0){
+        dup2(logFd, STDOUT_FILENO);
+        dup2(logFd, STDERR_FILENO);
+        ::close(logFd);
+    }
+
+    if(memoryLimit > 0){
+        struct rlimit limit;
+        limit.rlim_cur = limit.rlim_max = (rlim_t)memoryLimit << 20;
+        if(setrlimit(RLIMIT_DATA, &limit) != 0) cout << "Can not limit the memory: " << strerror(errno) << endl;
+    }
+
+    int status = 0;
+    try{
+        builder.mainFlow(run.coboPrefixes, run.tbPrefix, outDir);
+        if(!writeRunMarker(outDir, run.asadFiles, run.tbName, builder.GetOutputFiles())){
+            cout << "Can not write marker for " << run.asadFiles[0] << endl;
+            status = 1;
+        }
+    }catch(const std::exception & e){
+        cout << "Run " << run.asadFiles[0] << " failed: " << e.what() << endl;
+        status = 1;
+    }
+    cout.flush();
+    fflush(stdout);
+    // leave the ROOT and static cleanup to the parent
+    _exit(status);
+}
+
+/**
+ * Waits for a child to end and records its result. Terminates the children on the
+ * second stop request.
+ */
+void BatchRunner::WaitChild()
+{
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid < 0){
+        if(errno != EINTR) throw runtime_error("Error waiting for the runs");
+        if(stopRequests > 1 && !terminated){
+            cout << "Terminating " << children.size() << " running runs" << endl;
+            for(map<pid_t, string>::const_iterator it = children.begin(); it != children.end(); ++it){
+                kill(it->first, SIGTERM);
+            }
+            terminated = true;
+        }
+        return;
+    }
+
+    map<pid_t, string>::iterator it = children.find(pid);
+    if(it == children.end()) return;
+    if(WIFEXITED(status) && WEXITSTATUS(status) == 0){
+        cout << "Run " << it->second << " built" << endl;
+        nBuilt++;
+    }else{
+        cout << "Run " << it->second << " failed";
+        if(WIFSIGNALED(status)) cout << " (signal " << WTERMSIG(status) << ")";
+        cout << ", see " << outDir << "/" << stripExtension(it->second) << ".log" << endl;
+        failedRuns.push_back(it->second);
+    }
+    children.erase(it);
+}
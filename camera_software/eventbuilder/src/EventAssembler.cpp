@@ -0,0 +1,125 @@
+#include "EventAssembler.h"
+
+#include <map>
+
+using namespace std;
+
+// number of incomplete events listed individually by printReport
+#define MaxReportedEvents   20
+
+EventAssembler::EventAssembler()
+{
+    clear();
+}
+
+void EventAssembler::clear()
+{
+    events.clear();
+    missingFragments = 0;
+    outOfOrderFrames = 0;
+    duplicateFrames = 0;
+}
+
+/**
+ * Builds the event table from the frame indices of all streams.
+ * @param streams opened readers, one per CoBo/AsAd file, in pixel map AsAd order
+ */
+void EventAssembler::assemble(const vector<GrawReader*> &streams)
+{
+    clear();
+    size_t nStreams = streams.size();
+
+    // eventIdx -> position in events
+    map<uint32_t, size_t> eventTable;
+
+    for(size_t s=0; s<nStreams; s++){
+        uint32_t lastEventIdx = 0;
+        for(size_t indx=0; indx<streams[s]->getFrameCount(); indx++){
+            uint32_t eventIdx = streams[s]->getEventIdx(indx);
+            if(indx > 0 && eventIdx < lastEventIdx) outOfOrderFrames++;
+            lastEventIdx = eventIdx;
+
+            map<uint32_t, size_t>::iterator it = eventTable.find(eventIdx);
+            if(it == eventTable.end()){
+                AssembledEvent event;
+                event.eventIdx = eventIdx;
+                event.frames = vector<int>(nStreams, -1);
+                event.nMissing = 0;
+                it = eventTable.insert(make_pair(eventIdx, events.size())).first;
+                events.push_back(event);
+            }
+
+            AssembledEvent &event = events[it->second];
+            if(event.frames[s] >= 0){
+                // keep the first frame seen for this eventIdx
+                duplicateFrames++;
+            }else{
+                event.frames[s] = indx;
+            }
+        }
+    }
+
+    // order events by eventIdx and count the fragments no stream delivered
+    vector<AssembledEvent> sorted;
+    sorted.reserve(events.size());
+    for(map<uint32_t, size_t>::iterator it=eventTable.begin(); it!=eventTable.end(); ++it){
+        AssembledEvent &event = events[it->second];
+        for(size_t s=0; s<nStreams; s++){
+            if(event.frames[s] < 0) event.nMissing++;
+        }
+        missingFragments += event.nMissing;
+        sorted.push_back(event);
+    }
+    events.swap(sorted);
+}
+
+size_t EventAssembler::getEventCount() const
+{
+    return events.size();
+}
+
+const AssembledEvent &EventAssembler::getEvent(size_t indx) const
+{
+    return events.at(indx);
+}
+
+size_t EventAssembler::getMissingFragmentCount() const
+{
+    return missingFragments;
+}
+
+size_t EventAssembler::getOutOfOrderCount() const
+{
+    return outOfOrderFrames;
+}
+
+size_t EventAssembler::getDuplicateCount() const
+{
+    return duplicateFrames;
+}
+
+/**
+ * Prints a summary of the join, and the first incomplete events with the streams they miss.
+ */
+void EventAssembler::printReport(ostream &out, const vector<GrawReader*> &streams) const
+{
+    out << "Assembled " << events.size() << " events from " << streams.size() << " CoBo file(s)" << endl;
+    if(missingFragments == 0 && outOfOrderFrames == 0 && duplicateFrames == 0) return;
+
+    out << "Missing fragments: " << missingFragments
+        << " | Out of order frames: " << outOfOrderFrames
+        << " | Repeated eventIdx: " << duplicateFrames << endl;
+
+    size_t nIncomplete = 0;
+    for(size_t k=0; k<events.size(); k++){
+        if(events[k].nMissing == 0) continue;
+        nIncomplete++;
+        if(nIncomplete > MaxReportedEvents) continue;
+        out << "EventIdx " << events[k].eventIdx << " has no frame in:";
+        for(size_t s=0; s<streams.size(); s++){
+            if(events[k].frames[s] < 0) out << " " << streams[s]->getFileName();
+        }
+        out << endl;
+    }
+    if(nIncomplete > MaxReportedEvents) out << "... " << nIncomplete << " incomplete events in total" << endl;
+}
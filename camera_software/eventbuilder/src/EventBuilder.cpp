@@ -2,23 +2,22 @@
 #include <fstream>
 
 /**
- * Prints out various parameters for a specified eventID in a TBDecoder object, a pointer to which
- * is stored as an EventBuilder instance variable.
- * @param TBEvents is a TBDecoder object which stores the data for N events from the TriggerBoard.
- * @param eventID is an integer specifying the event to print.
+ * Reads the trigger board record of a specified eventID from a TBDecoder object into an event slot.
+ * The event number is printed by the writer, so that the output stays in event order.
+ * @param TBEvents is a TBDecoder object which maps the TriggerBoard file and decodes its records on access.
+ * @param eventID is an integer specifying the event to read.
+ * @param slot receives the event number, clock count, trigger source and first triggered MUSIC.
  */
 
-void EventBuilder::logTBevent(int eventID, TBDecoder *TBEvents)
+void EventBuilder::logTBevent(int eventID, TBDecoder *TBEvents, EventSlot &slot)
 {
-    eventNumber_TB = TBEvents->getEventNumber(eventID);
-    eventTime_TB = TBEvents->getClockCount(eventID);
-    triggerSource_TB = TBEvents->getTriggerSource(eventID);
-    FirstTrigMusic_TB = TBEvents->getActiveSdb(eventID);
-
-    // Optional output for tracking events.
-    cout << "TB: Event number: " << eventNumber_TB << endl;
-    // cout << "TB: Clock Count: " << eventTime_TB << endl;
-    // cout << "TB: Trigger Source: " << triggerSource_TB << endl;
+    slot.eventNumber_TB = TBEvents->getEventNumber(eventID);
+    slot.eventTime_TB = TBEvents->getClockCount(eventID);
+    slot.triggerSource_TB = TBEvents->getTriggerSource(eventID);
+    slot.FirstTrigMusic_TB = TBEvents->getActiveSdb(eventID);
+
+    // cout << "TB: Clock Count: " << slot.eventTime_TB << endl;
+    // cout << "TB: Trigger Source: " << slot.triggerSource_TB << endl;
     /*cout << "TB: Confirm Event #: " << TBEvents->confirmEventNumber(eventID) << endl;
 
     if(!TBEvents->confirmEventNumber(eventID))
@@ -63,17 +62,18 @@ void EventBuilder::FindBin(int pixelID,int *nx, int *ny)
 /**
  * Given the ID of the first triggered music chip, returns a vector containing the sipm ID for each pixel
  * in the region of interest (ROI).
+ * @param halo number of extra pixel rows and columns added on each side of the 6x6 ROI
  */
-vector<int> EventBuilder::FindNeighborPixels(int FirstTrigMusic)
+vector<int> EventBuilder::FindNeighborPixels(int FirstTrigMusic, int halo)
 {
     vector<int> vNeighbor;
     int nx, ny;
     int FirstTrigPix = FirstTrigMusic * 8;
     FindBin(FirstTrigPix, &nx, &ny);
     
-    for (int j=ny-1; j<ny+5 && j<16; j++)
+    for (int j=ny-1-halo; j<ny+5+halo && j<16; j++)
     {
-        for (int i=nx-1; i<nx+5 && i<32; i++)
+        for (int i=nx-1-halo; i<nx+5+halo && i<32; i++)
         {
             if((i > -1) && (j > -1))
             {
@@ -90,62 +90,69 @@ vector<int> EventBuilder::FindNeighborPixels(int FirstTrigMusic)
 }
 
 /**
- * Function for dealing with frames not comming in event by event. Stores indices of correct order of frames in two
- * vectors (one for each asad, stored as member vars)
+ * Maps the CoBo files and joins their frames on eventIdx, from a single scan of the MFM headers
+ * of each file. The item data is not read. The mappings stay open for the Write_* functions.
+ * @param CoBo_filenames one .graw file per AsAd, in pixel map AsAd order
+ * @return number of assembled events
  */
-int EventBuilder::FrameCounter(string CoBo_filename, int asadIdx)
+int EventBuilder::FrameCounter(std::vector<std::string> CoBo_filenames)
 {
-    f_raw.open(CoBo_filename, std::ios::in | std::ios::binary);
     vAsAd0.clear();
     vAsAd1.clear();
+    CloseStreams();
 
-    size_t frameCount = 0;
-    size_t maxFrames = 5000;
-    mfm::Frame::seekFrame(f_raw, 0);
+    if (CoBo_filenames.size() > MaxNofAsads) {
+        EB_LOG(LogWarning) << "Only " << MaxNofAsads << " AsAd files can be mapped to pixels, ignoring the others." << endl;
+        CoBo_filenames.resize(MaxNofAsads);
+    }
 
-    
-    cout<<CoBo_filename<<endl;
+    for (size_t asadIdx=0; asadIdx<CoBo_filenames.size(); asadIdx++) {
+        EB_LOG(LogInfo) << CoBo_filenames[asadIdx] << endl;
 
-    try {
-        do {
-            if (frameCount >= maxFrames) 
-                break;
-            try {
-                curFrame = mfm::Frame::read(f_raw);
-            }
-            catch (const std::ifstream::failure & e) {
-                if (f_raw.rdstate() & std::ifstream::eofbit) {
-                    LOG_WARN() << "FrameCounterEOF reached.";
-                    break;
-                }
-                else {
-                    LOG_ERROR() << "Error reading frame: " << e.what();
-                }
-                return false;
-            }
-            if ((curFrame->header().frameType() !=0x1) and (curFrame->header().frameType() != 2))
-            {
-                LOG_DEBUG() << "Skipping frame #" << frameCount << "...";
-                continue;
-            }
-            else if (frameCount%50 == 1)
-            {
-                LOG_DEBUG() << "Adding frame #" << frameCount << " to tree...";
-            }
-            frameCount++;
+        GrawReader *reader = new GrawReader();
+        try {
+            reader->open(CoBo_filenames[asadIdx]);
         }
-        while (f_raw.good());
-    }
-    catch (const std::exception & e) {
-        LOG_ERROR() << e.what();
+        catch (const std::exception & e) {
+            LOG_ERROR() << e.what();
+            delete reader;
+            continue;
+        }
+        if (reader->isIndexed())
+            EB_LOG(LogInfo) << "Frame index: " << grawIndexFileName(CoBo_filenames[asadIdx]) << endl;
+        if (reader->getSkippedFrameCount() > 0)
+            LOG_DEBUG() << "Skipped " << reader->getSkippedFrameCount() << " non data frames.";
+        EB_LOG(LogInfo) << "Total Number of Frames from AsAd#" << asadIdx << ": " << reader->getFrameCount() << endl;
+        grawReaders.push_back(reader);
+        stats.inputFiles.push_back(CoBo_filenames[asadIdx]);
+        stats.inputBytes += reader->getFileSize();
     }
 
-    cout << "Total Number of Events from AsAd#" << asadIdx << ": " << frameCount << endl;
-    f_raw.close();
+    eventAssembler.assemble(grawReaders);
+    if(RunLog::Enabled(LogInfo)) eventAssembler.printReport(cout, grawReaders);
+    stats.missingFragments = eventAssembler.getMissingFragmentCount();
+    stats.outOfOrderFrames = eventAssembler.getOutOfOrderCount();
+    stats.repeatedEventIdx = eventAssembler.getDuplicateCount();
+
+    size_t frameCount = eventAssembler.getEventCount();
+
+    EB_LOG(LogInfo) << "Total Number of Events: " << frameCount << endl;
 
     return frameCount;
 }
 
+/**
+ * Unmaps all CoBo files opened by FrameCounter.
+ */
+void EventBuilder::CloseStreams()
+{
+    for (size_t k=0; k<grawReaders.size(); k++) {
+        delete grawReaders[k];
+    }
+    grawReaders.clear();
+    eventAssembler.clear();
+}
+
 
 /**
  * Extract information from the frame header
@@ -159,104 +166,63 @@ void EventBuilder::logCoBoEvent(std::auto_ptr<mfm::Frame> &tempFrame){
     eventTime_CoBo = tempFrame->headerField("eventTime").value<uint64_t>();
     eventIdx_CoBo  = tempFrame->headerField("eventIdx").value<uint32_t>();
     asadIdx_CoBo    = tempFrame->headerField("asadIdx").value<uint8_t>();
-    cout << "EventID: " << eventIdx_CoBo << " | AsAd: " << (short)asadIdx_CoBo << endl;
+    EB_LOG(LogDebug) << "EventID: " << eventIdx_CoBo << " | AsAd: " << (short)asadIdx_CoBo << endl;
 }
 
-/*
-void EventBuilder::Set_Branch_Bifocal(Event *eventBifocal){
-    Bifocal_tree->Branch("Events","Event",&eventBifocal,64000,0);
-    /*
-    Bifocal_tree->Branch("TBTime", &Bifocal_struct->tb_time, "tb_time/l");
-    Bifocal_tree->Branch("CoBoTime", &Bifocal_struct->cobo_time, "cobo_time/l");
-    Bifocal_tree->Branch("UNIXTime", &Bifocal_struct->unix_time, "unix_time/l");
-    Bifocal_tree->Branch("ROIMusicID", Bifocal_struct->ROIMusicID, "ROI_MusicID[2]/i");
-    Bifocal_tree->Branch("NofPixels", &Bifocal_struct->NofPixels, "N_Pixels/i");
-    Bifocal_tree->Branch("ROIPixelsID", Bifocal_struct->ROIPixelID, "ROI_Pixel_ID[36]/i");
-    Bifocal_tree->Branch("ROIPixelsSignalValue", Bifocal_struct->ROISignalValue, "ROI_Signal_Value[36][512]/i");
-    Bifocal_tree->Branch("Pedestal", Bifocal_struct->Pedestal, "Pedestal[512]/F");   
-}
+/**
+ * Fills the traces of the event with the samples of one frame of the AsAd stream asadIdx.
+ * Uses the compiled FrameDecoder when it is enabled and knows the frame layout,
+ * otherwise falls back to the generic mfm::Frame field access.
+ */
+void EventBuilder::DecodeFrame(int asadIdx, int frameIdx, Event *event){
+    const GrawFrame &frame = grawReaders[asadIdx]->getFrame(frameIdx);
+    size_t maxItems = ((MaxNofChannels)+16)*MaxTimeBucket;
 
-void EventBuilder::Set_Branch_Background(Event *eventForced){
-    Background_tree->Branch("Events","Event",&eventForced,64000,0);
-    /*
-    Background_tree->Branch("TBTime", &Background_struct->tb_time, "tb_time/l");
-    Background_tree->Branch("CoBoTime", &Background_struct->cobo_time, "cobo_time/l");
-    Background_tree->Branch("UNIXTime", &Background_struct->unix_time, "unix_time/l");
-    Background_tree->Branch("SignalValue", Background_struct->SignalValue, "Signal_Value[512][512]/i");
+    if(fastDecoding && frameDecoder->decode(frame, asadIdx, event->GetTraceBuffer(), event->GetNPixels(), event->GetNSamples(), maxItems)){
+        return;
+    }
+    // zero suppressed frames only carry part of the samples
+    if(frame.frameType == DecoderPartialReadout){
+        frameDecoder->clear(asadIdx, event->GetTraceBuffer(), event->GetNPixels(), event->GetNSamples());
+    }
+    // the generic decoding works on member frame/item/field objects, one worker at a time
+    std::lock_guard<std::mutex> lock(genericMutex);
+    curFrame = grawReaders[asadIdx]->readFrame(frameIdx);
+    DecodeGenericFrame(asadIdx, event);
 }
 
-void EventBuilder::Set_Branch_Hled(Event *eventHled){
-    Hled_tree->Branch("Events","Event",&eventHled,64000,0);
-    /*Hled_tree->Branch("TBTime", &Hled_struct->tb_time, "tb_time/l");
-    Hled_tree->Branch("CoBoTime", &Hled_struct->cobo_time, "cobo_time/l");
-    Hled_tree->Branch("UNIXTime", &Hled_struct->unix_time, "unix_time/l");
-    Hled_tree->Branch("SignalValue", Hled_struct->SignalValue, "Signal_Value[512][512]/i");    
-}*/
-void EventBuilder::Write_TestEvent(string CoBo_filename_0, Event *eventTest, int asadIdx, int event_index, std::vector<std::vector<Int_t>> &signalValue, long startTime){
-     if(event_index == 0){
-        if(asadIdx == 0){
-            f_raw_0.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            f_raw_1.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    // Any frame after the First event in CoBo file.
-    }else{
-        if(asadIdx == 0){
-            curFrame = mfm::Frame::read(f_raw_0);
+/**
+ * Decodes every fragment of the event in the slot. Pixels of an AsAd whose fragment
+ * is missing are zeroed, as are those of a zero suppressed fragment before it is decoded,
+ * so that they do not keep the traces of an earlier event.
+ */
+void EventBuilder::DecodeEvent(EventSlot &slot){
+    const AssembledEvent &assembled = eventAssembler.getEvent(slot.coboIndex);
+    // back to all pixels if the previous event of the slot was stored ROI-only
+    slot.event->SetTraceSize(MaxNofChannels*assembled.frames.size(), MaxTimeBucket);
+    UShort_t *traces = slot.event->GetTraceBuffer();
+    for(size_t asadIdx=0; asadIdx<assembled.frames.size(); asadIdx++){
+        if(assembled.frames[asadIdx] >= 0){
+            DecodeFrame(asadIdx, assembled.frames[asadIdx], slot.event);
         }else{
-            curFrame = mfm::Frame::read(f_raw_1);
+            std::fill(traces + asadIdx*MaxNofChannels*MaxTimeBucket, traces + (asadIdx+1)*MaxNofChannels*MaxTimeBucket, 0);
         }
     }
+}
 
-    
-    // ----------------------------------------------------------------------------------------------------------------
-    // Store timing data in Bifocal struct
-    // UNIX TIME WILL BE CHANGED IN FUTURE
-    if(asadIdx == 0)
-    {
-        eventTest->SetCoBoTime((ULong64_t)eventTime_CoBo);
-        eventTest->SetTBTime((ULong64_t)eventTime_TB+startTime);
-        //eventTest->SetTBTime(time(NULL));
-        
-        
-        eventIdx_CoBo_asad0 = eventIdx_CoBo;
-    }else { // confirm ASAD1 data corresponsds to the same event as ASAD0.
-        try{
-            if(eventIdx_CoBo != eventIdx_CoBo_asad0){
-                throw 1; //throw exception if 
-            }
-        }catch(int e){
-            cout << "Event indices of ASAD_0 and ASAD_1 do not match!";
-        }    
-    }
-
-    // PEDESTAL ----------------------------------------------------------------------------------------
-    //  Pedestals are calculated in ExACT. No need for Pedestal Calculation
-    // loop through each item in frame to store pedestal values.
+/**
+ * Generic decoding of curFrame through the frame dictionary, item by item.
+ * Works for any format described in the CoBo formats file, but is slow.
+ */
+void EventBuilder::DecodeGenericFrame(int asadIdx, Event *event){
+    UShort_t *traces = event->GetTraceBuffer();
+    size_t nPixels = event->GetNPixels();
+    size_t nSamples = event->GetNSamples();
 
     // vectors for storing channel and bucket indices
     std::vector<uint32_t> chanIdx = std::vector<uint32_t>(numChips, 0u);
     std::vector<uint32_t> buckIdx = std::vector<uint32_t>(numChips, 0u);
 
-
-    
-    // REGION OF INTEREST -----------------------------------------------------------------------------------
-
-    // store active music IDs
-    vector<int> roiMUSICs{FirstTrigMusic_TB,FirstTrigMusic_TB};
-    eventTest->SetROIMusicID(roiMUSICs);
-
-    /*
-    Bifocal_struct->ROIMusicID[0] = FirstTrigMusic_TB;
-    Bifocal_struct->ROIMusicID[1] = FirstTrigMusic_TB+1;
-    */
-
-    // find the pixels we would like to record for a bifocal event
-    vector<int> roiPixels = FindNeighborPixels(FirstTrigMusic_TB);
-    eventTest->SetROIPixelID(roiPixels);
-
     // read the first item in the frame
     item = curFrame->itemAt(0);
     field = item.field("");
@@ -264,11 +230,13 @@ void EventBuilder::Write_TestEvent(string CoBo_filename_0, Event *eventTest, int
     sampleValueField = field.bitField("sample");
     uint32_t agetIdx = agetIdxField.value<uint32_t>();
     uint32_t sampleValue = sampleValueField.value<uint32_t>();
-    pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-    signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-    //Hled_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
+    // FPN and unmapped channels have a negative sipmID
+    const int16_t (*sipmLUT)[MaxChannelsPerAget] = pixelMapLUT.sipmID[asadIdx];
+    int sipmID = sipmLUT[agetIdx][chanIdx[agetIdx]];
+    if (sipmID >= 0 && sipmID < (int)nPixels)
+        traces[sipmID*nSamples + buckIdx[agetIdx]] = sampleValue;
     chanIdx[agetIdx]++;
-    
+
     // loop through rest of the items in the frame
     for (size_t itemId=1; itemId < (((MaxNofChannels)+16)*MaxTimeBucket); ++itemId){
         //set current item
@@ -278,481 +246,219 @@ void EventBuilder::Write_TestEvent(string CoBo_filename_0, Event *eventTest, int
         sampleValueField = field.bitField(sampleValueField);
         agetIdx = agetIdxField.value<uint32_t>();
         sampleValue = sampleValueField.value<uint32_t>();
-        
+
         // increment channel index and bucket index
         if (chanIdx[agetIdx] >= MaxChannelsPerAget)
             {
                 chanIdx[agetIdx] = 0u;
                 buckIdx[agetIdx]++;
             }
-        
-        if ((chanIdx[agetIdx]!=11) && (chanIdx[agetIdx]!=22) && (chanIdx[agetIdx]!=45) && (chanIdx[agetIdx]!=56)){
-            pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-            signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
 
-            //Hled_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-        }
+        sipmID = sipmLUT[agetIdx][chanIdx[agetIdx]];
+        if (sipmID >= 0 && sipmID < (int)nPixels && buckIdx[agetIdx] < nSamples)
+            traces[sipmID*nSamples + buckIdx[agetIdx]] = sampleValue;
         chanIdx[agetIdx]++;
     }
 }
 
-void EventBuilder::Write_BifocalEvent(string CoBo_filename_0, Event *eventBifocal, int asadIdx, int event_index, std::vector<std::vector<Int_t>> &signalValue, long startTime){
-    // ----------------------------------------------------------------------------------------------------------------
-    // First event in CoBo file, load first frame.
-    if(event_index == 0){
-        if(asadIdx == 0){
-            f_raw_0.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            f_raw_1.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    // Any frame after the First event in CoBo file.
-    }else{
-        if(asadIdx == 0){
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    }
-
-    
-    // ----------------------------------------------------------------------------------------------------------------
-    // Store timing data in Bifocal struct
-    // UNIX TIME WILL BE CHANGED IN FUTURE
-    if(asadIdx == 0)
-    {
-        eventBifocal->SetCoBoTime((ULong64_t)eventTime_CoBo);
-        eventBifocal->SetTBTime((ULong64_t)eventTime_TB+startTime);
-        //eventBifocal->SetTBTime(time(NULL));
-        
-        /*
-        Bifocal_struct->tb_time = (ULong64_t)eventTime_TB;
-        Bifocal_struct->cobo_time = (ULong64_t)eventTime_CoBo;
-        Bifocal_struct->unix_time = time(NULL);*/
-        eventIdx_CoBo_asad0 = eventIdx_CoBo;
-    }else { // confirm ASAD1 data corresponsds to the same event as ASAD0.
-        try{
-            if(eventIdx_CoBo != eventIdx_CoBo_asad0){
-                throw 1; //throw exception if 
-            }
-        }catch(int e){
-            cout << "Event indices of ASAD_0 and ASAD_1 do not match!";
-        }    
-    }
-
-    // PEDESTAL ----------------------------------------------------------------------------------------
-    //  Pedestals are calculated in ExACT. No need for Pedestal Calculation
-    // loop through each item in frame to store pedestal values.
-
-    // vectors for storing channel and bucket indices
-    std::vector<uint32_t> chanIdx = std::vector<uint32_t>(numChips, 0u);
-    std::vector<uint32_t> buckIdx = std::vector<uint32_t>(numChips, 0u);
-
-
-    //Read the first item in the frame
+/*
+void EventBuilder::Set_Branch_Bifocal(Event *eventBifocal){
+    Bifocal_tree->Branch("Events","Event",&eventBifocal,64000,0);
     /*
-    item = curFrame->itemAt(0);
-    field = item.field("");
-    agetIdxField = field.bitField("agetIdx");
-    sampleValueField = field.bitField("sample");
-    uint32_t agetIdx = agetIdxField.value<uint32_t>();
-    uint32_t sampleValue = sampleValueField.value<uint32_t>();
-    //fSampleValue = (float)sampleValue; //convert sample value to float for pedestal.
-    pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-    */
-    
-    /*Bifocal_struct->Pedestal[sipmID] = fSampleValue;
-    chanIdx[agetIdx]++;
-
-    for (size_t itemId=1; itemId < (((MaxNofChannels/2)+16)*BiPedestalTimeBucket/2); ++itemId)
-    {
-        //set current item
-        item = curFrame->itemAt(itemId);
-        field = item.field(field); // contains 2 main values, agetID and sampleValue
-        agetIdxField = field.bitField(agetIdxField);
-        sampleValueField = field.bitField(sampleValueField);
-        agetIdx = agetIdxField.value<uint32_t>();
-        sampleValue = sampleValueField.value<uint32_t>();
-        // increment channel index and bucket index
-        if (chanIdx[agetIdx] >= MaxChannelsPerAget)
-            {
-                chanIdx[agetIdx] = 0u;
-                buckIdx[agetIdx]++;
-            }
-
-        // Averaging over the pedestal values for each pixel
-        if ((chanIdx[agetIdx]!=11) && (chanIdx[agetIdx]!=22) && (chanIdx[agetIdx]!=45) && (chanIdx[agetIdx]!=56)){
-            fSampleValue = (float)sampleValue; //convert sample value to float for pedestal.
-            pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-            if(buckIdx[agetIdx] == 0){
-                Bifocal_struct->Pedestal[sipmID] = fSampleValue;
-            }else if(buckIdx[agetIdx] == (BiPedestalTimeBucket-1)){
-                Bifocal_struct->Pedestal[sipmID] = (Bifocal_struct->Pedestal[sipmID] + fSampleValue) / BiPedestalTimeBucket;
-            }else{
-                Bifocal_struct->Pedestal[sipmID] = Bifocal_struct->Pedestal[sipmID] + fSampleValue;
-            }
-        }
-        chanIdx[agetIdx]++;
-    }*/
-    
-    // REGION OF INTEREST -----------------------------------------------------------------------------------
-
-    // store active music IDs
-    vector<int> roiMUSICs{FirstTrigMusic_TB, FirstTrigMusic_TB+1};
-    eventBifocal->SetROIMusicID(roiMUSICs);
+    Bifocal_tree->Branch("TBTime", &Bifocal_struct->tb_time, "tb_time/l");
+    Bifocal_tree->Branch("CoBoTime", &Bifocal_struct->cobo_time, "cobo_time/l");
+    Bifocal_tree->Branch("UNIXTime", &Bifocal_struct->unix_time, "unix_time/l");
+    Bifocal_tree->Branch("ROIMusicID", Bifocal_struct->ROIMusicID, "ROI_MusicID[2]/i");
+    Bifocal_tree->Branch("NofPixels", &Bifocal_struct->NofPixels, "N_Pixels/i");
+    Bifocal_tree->Branch("ROIPixelsID", Bifocal_struct->ROIPixelID, "ROI_Pixel_ID[36]/i");
+    Bifocal_tree->Branch("ROIPixelsSignalValue", Bifocal_struct->ROISignalValue, "ROI_Signal_Value[36][512]/i");
+    Bifocal_tree->Branch("Pedestal", Bifocal_struct->Pedestal, "Pedestal[512]/F");   
+}
 
+void EventBuilder::Set_Branch_Background(Event *eventForced){
+    Background_tree->Branch("Events","Event",&eventForced,64000,0);
     /*
-    Bifocal_struct->ROIMusicID[0] = FirstTrigMusic_TB;
-    Bifocal_struct->ROIMusicID[1] = FirstTrigMusic_TB+1;
-    */
+    Background_tree->Branch("TBTime", &Background_struct->tb_time, "tb_time/l");
+    Background_tree->Branch("CoBoTime", &Background_struct->cobo_time, "cobo_time/l");
+    Background_tree->Branch("UNIXTime", &Background_struct->unix_time, "unix_time/l");
+    Background_tree->Branch("SignalValue", Background_struct->SignalValue, "Signal_Value[512][512]/i");
+}
 
-    // find the pixels we would like to record for a bifocal event
-    vector<int> roiPixels = FindNeighborPixels(FirstTrigMusic_TB);
-    eventBifocal->SetROIPixelID(roiPixels);
-    /*for(int k=0; k<roiPixels.size(); k++){
-        Bifocal_struct->ROIPixelID[k] = roiPixels.at(k);
+void EventBuilder::Set_Branch_Hled(Event *eventHled){
+    Hled_tree->Branch("Events","Event",&eventHled,64000,0);
+    /*Hled_tree->Branch("TBTime", &Hled_struct->tb_time, "tb_time/l");
+    Hled_tree->Branch("CoBoTime", &Hled_struct->cobo_time, "cobo_time/l");
+    Hled_tree->Branch("UNIXTime", &Hled_struct->unix_time, "unix_time/l");
+    Hled_tree->Branch("SignalValue", Hled_struct->SignalValue, "Signal_Value[512][512]/i");    
+}*/
+/**
+ * Stores the CoBo and TB times of the event. The CoBo time is taken from the first
+ * AsAd that delivered a fragment, the join guarantees all fragments share eventIdx.
+ */
+void EventBuilder::SetEventHeader(EventSlot &slot, long startTime){
+    // Frame header values of this event, taken from the CoBo file indices.
+    const AssembledEvent &assembled = eventAssembler.getEvent(slot.coboIndex);
+    slot.eventIdx_CoBo = assembled.eventIdx;
+    slot.nMissing = assembled.nMissing;
+
+    for(size_t asadIdx=0; asadIdx<assembled.frames.size(); asadIdx++){
+        if(assembled.frames[asadIdx] < 0) continue;
+        const GrawFrame &frame = grawReaders[asadIdx]->getFrame(assembled.frames[asadIdx]);
+        // UNIX TIME WILL BE CHANGED IN FUTURE
+        slot.event->SetCoBoTime((ULong64_t)frame.eventTime);
+        break;
     }
-    Bifocal_struct->NofPixels = roiPixels.size();*/
+    slot.event->SetTBTime((ULong64_t)slot.eventTime_TB + startTime);
+}
 
-    // vectors for storing channel and bucket indices
-    // chanIdx = std::vector<uint32_t>(numChips, 0u);
-    // buckIdx = std::vector<uint32_t>(numChips, 0u);
+/**
+ * ROI-only storage: drops the traces outside the region of interest and its halo when
+ * the configuration of the event tree asks for it. Called once the traces are decoded.
+ */
+void EventBuilder::KeepROITraces(EventSlot &slot){
+    int halo = outputConfig.GetTreeConfig(slot.treeID).roiHalo;
+    if(halo >= 0){
+        slot.event->KeepPixels(FindNeighborPixels(slot.FirstTrigMusic_TB, halo));
+    }
+}
 
-    /*uint16_t desiredAsad[ROIMaxNofChannels];
-    uint16_t desiredAget[ROIMaxNofChannels];
-    uint16_t desiredChannel[ROIMaxNofChannels];*/
+/**
+ * Fused extraction: reduces the decoded traces to ExtractedData before any of them is
+ * dropped, so that the extracted values do not depend on the raw output settings.
+ */
+void EventBuilder::ExtractPulses(EventSlot &slot){
+    if(pulseExtractor) pulseExtractor->Extract(slot.event, slot.extracted);
+}
 
+void EventBuilder::Write_TestEvent(EventSlot &slot, long startTime){
+    SetEventHeader(slot, startTime);
 
-    //std::vector<std::vector<Int_t>> signalValue;
-    //signalValue = std::vector<std::vector<Int_t>>(MaxNofChannels, std::vector<Int_t>(MaxTimeBucket));
+    // REGION OF INTEREST -----------------------------------------------------------------------------------
+    // store active music IDs
+    vector<int> roiMUSICs{(int)slot.FirstTrigMusic_TB, (int)slot.FirstTrigMusic_TB};
+    slot.event->SetROIMusicID(roiMUSICs);
 
-    // read the first item in the frame
-    item = curFrame->itemAt(0);
-    field = item.field("");
-    agetIdxField = field.bitField("agetIdx");
-    sampleValueField = field.bitField("sample");
-    uint32_t agetIdx = agetIdxField.value<uint32_t>();
-    uint32_t sampleValue = sampleValueField.value<uint32_t>();
-    pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-    signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
+    // find the pixels we would like to record for a test event
+    slot.event->SetROIPixelID(FindNeighborPixels(slot.FirstTrigMusic_TB));
 
-    //Hled_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-    chanIdx[agetIdx]++;
-    
-    // loop through rest of the items in the frame
-    for (size_t itemId=1; itemId < (((MaxNofChannels)+16)*MaxTimeBucket); ++itemId){
-        //set current item
-        item = curFrame->itemAt(itemId);
-        field = item.field(field); // contains 2 main values, agetID and sampleValue
-        agetIdxField = field.bitField(agetIdxField);
-        sampleValueField = field.bitField(sampleValueField);
-        agetIdx = agetIdxField.value<uint32_t>();
-        sampleValue = sampleValueField.value<uint32_t>();
-        
-        // increment channel index and bucket index
-        if (chanIdx[agetIdx] >= MaxChannelsPerAget)
-            {
-                chanIdx[agetIdx] = 0u;
-                buckIdx[agetIdx]++;
-            }
-        
-        if ((chanIdx[agetIdx]!=11) && (chanIdx[agetIdx]!=22) && (chanIdx[agetIdx]!=45) && (chanIdx[agetIdx]!=56)){
-            pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-            signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
+    DecodeEvent(slot);
+    ExtractPulses(slot);
+    KeepROITraces(slot);
+}
 
-            //Hled_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-        }
-        chanIdx[agetIdx]++;
-    }
+void EventBuilder::Write_BifocalEvent(EventSlot &slot, long startTime){
+    SetEventHeader(slot, startTime);
 
-    //eventBifocal->SetSignalValue(signalValue);
+    // PEDESTAL ----------------------------------------------------------------------------------------
+    //  Pedestals are calculated in ExACT. No need for Pedestal Calculation
 
+    // REGION OF INTEREST -----------------------------------------------------------------------------------
+    // store active music IDs
+    vector<int> roiMUSICs{(int)slot.FirstTrigMusic_TB, (int)slot.FirstTrigMusic_TB+1};
+    slot.event->SetROIMusicID(roiMUSICs);
 
-    /*          OBSOLETE           */
+    // find the pixels we would like to record for a bifocal event
+    slot.event->SetROIPixelID(FindNeighborPixels(slot.FirstTrigMusic_TB));
 
     /*
-    Want to save traces of all pixels in memory
+    Traces of all pixels are saved unless ROISTORAGE is set for the tree,
     ExACT will only keep the traces for ROI pixels
     when preparing file download
     */
-
-    /*for(int k=0; k<roiPixels.size(); k++){
-        pixelMapDecoder(pixelMapArray, roiPixels.at(k), &desiredAsad[k], &desiredAget[k], &desiredChannel[k]);
-        // cout << roiPixels.at(k) << ", " << desiredAsad[k] << ", " << desiredAget[k] << ", " << desiredChannel[k] << endl;
-    }
-
-    // read the first item in the frame
-    item = curFrame->itemAt(0);
-    field = item.field("");
-    agetIdxField = field.bitField("agetIdx");
-    sampleValueField = field.bitField("sample");
-    agetIdx = agetIdxField.value<uint32_t>();
-    sampleValue = sampleValueField.value<uint32_t>();
-    pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-    for(int k=0; k<roiPixels.size(); k++){
-        if(desiredAsad[k] == asadIdx){
-            if(desiredAget[k] == agetIdx){
-                if(desiredChannel[k] == chanIdx[agetIdx]){
-                    Bifocal_struct->ROISignalValue[k][buckIdx[agetIdx]] = sampleValue;
-                    break;
-                }
-            }
-        }
-    }
-    chanIdx[agetIdx]++;
-
-    for (size_t itemId=1; itemId < (((MaxNofChannels/2)+16)*MaxTimeBucket/2); ++itemId){
-        //set current item
-        item = curFrame->itemAt(itemId);
-        field = item.field(field); // contains 2 main values, agetID and sampleValue
-        agetIdxField = field.bitField(agetIdxField);
-        sampleValueField = field.bitField(sampleValueField);
-        agetIdx = agetIdxField.value<uint32_t>();
-        sampleValue = sampleValueField.value<uint32_t>();
-
-        // increment channel index and bucket index
-        if (chanIdx[agetIdx] >= MaxChannelsPerAget)
-            {
-                chanIdx[agetIdx] = 0u;
-                buckIdx[agetIdx]++;
-            }
-
-        if ((chanIdx[agetIdx]!=11) && (chanIdx[agetIdx]!=22) && (chanIdx[agetIdx]!=45) && (chanIdx[agetIdx]!=56)){
-            pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-            for(int k=0; k<roiPixels.size(); k++){
-                if(desiredAsad[k] == asadIdx){
-                    if(desiredAget[k] == agetIdx){
-                        if(desiredChannel[k] == chanIdx[agetIdx]){
-                            Bifocal_struct->ROISignalValue[k][buckIdx[agetIdx]] = sampleValue;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-        chanIdx[agetIdx]++;
-        
-    }*/
+    DecodeEvent(slot);
+    ExtractPulses(slot);
+    KeepROITraces(slot);
 }
 
-void EventBuilder::Write_BackgroundEvent(string CoBo_filename_0, Event *eventForced, int asadIdx, int event_index, std::vector<std::vector<Int_t>> &signalValue, long startTime){
-    // ----------------------------------------------------------------------------------------------------------------
-    // First event in CoBo file, load first frame.
-    if(event_index == 0){
-        if(asadIdx == 0){
-            f_raw_0.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            f_raw_1.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    // Any frame after the First event in CoBo file.
-    }else{
-        if(asadIdx == 0){
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    }
-
-    // -----------------------------------------------
-    // Debugging - Print Cobo header file data
-    //-----------------------------------------------
-    cout << "--------------------------------" << endl;
-    cout << "From Cobo Header:" << endl;
-    cout << "ASAD: " << curFrame->headerField("asadIdx").value<uint32_t>() << endl;
-    cout << "Event Indx: " << curFrame->headerField("eventIdx").value<uint32_t>() << endl;
-    cout << "Event Time: " << curFrame->headerField("eventTime").value<uint64_t>() << endl;
-    cout << "--------------------------------" << endl;
+void EventBuilder::Write_BackgroundEvent(EventSlot &slot, long startTime){
+    SetEventHeader(slot, startTime);
 
-    // ----------------------------------------------------------------------------------------------------------------
-    // Store timing data in background struct
-    // UNIX TIME WILL BE CHANGED IN THE FUTURE
-    if(asadIdx == 0){
-
-        eventForced->SetCoBoTime((ULong64_t)eventTime_CoBo);
-        eventForced->SetTBTime((ULong64_t)eventTime_TB + startTime);
-        //eventForced->SetTBTime(time(NULL));
-        /*
-        Background_struct->tb_time = eventTime_TB;
-        Background_struct->cobo_time = eventTime_CoBo;
-        Background_struct->unix_time = time(NULL);
-        */
-        eventIdx_CoBo_asad0 = eventIdx_CoBo;
-    }else { // Confirm ASAD1 data corresponds to the same event as ASAD0
-        try{
-            if(eventIdx_CoBo != eventIdx_CoBo_asad0){
-                throw 1; //throw exception if 
-            }
-        }catch(int e){
-            cout << "Event indices of ASAD_0 and ASAD_1 do not match!";
-        }
-    }
-    // ----------------------------------------------------------------------------------------------------------------
-    // Store item data in background struct
-
-    // vectors for storing channel and bucket indices
-    std::vector<uint32_t> chanIdx = std::vector<uint32_t>(numChips, 0u);
-    std::vector<uint32_t> buckIdx = std::vector<uint32_t>(numChips, 0u);
-    
-    //std::vector<std::vector<Int_t>> signalValue;
-    //signalValue = std::vector<std::vector<Int_t>>(MaxNofChannels, std::vector<Int_t>(MaxTimeBucket));
+    // slots are shared between trees, forced events carry no region of interest
+    slot.event->SetROIMusicID(vector<int>());
+    slot.event->SetROIPixelID(vector<int>());
 
+    DecodeEvent(slot);
+    ExtractPulses(slot);
+}
 
-    // read the first item in the frame
-    item = curFrame->itemAt(0);
-    field = item.field("");
-    agetIdxField = field.bitField("agetIdx");
-    sampleValueField = field.bitField("sample");
-    uint32_t agetIdx = agetIdxField.value<uint32_t>();
-    uint32_t sampleValue = sampleValueField.value<uint32_t>();
-    pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-    
-    signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-    //Background_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-    chanIdx[agetIdx]++;
+void EventBuilder::Write_HledEvent(EventSlot &slot, long startTime){
+    SetEventHeader(slot, startTime);
 
-    // loop through each item in frame
-    for (size_t itemId=1; itemId < (((MaxNofChannels)+16)*MaxTimeBucket); ++itemId){
-        //set current item
-        item = curFrame->itemAt(itemId);
-        field = item.field(field); // contains 2 main values, agetID and sampleValue
-        agetIdxField = field.bitField(agetIdxField);
-        sampleValueField = field.bitField(sampleValueField);
-        agetIdx = agetIdxField.value<uint32_t>();
-        sampleValue = sampleValueField.value<uint32_t>();
-        
-        // increment channel index and bucket index
-        if (chanIdx[agetIdx] >= MaxChannelsPerAget)
-            {
-                chanIdx[agetIdx] = 0u;
-                buckIdx[agetIdx]++;
-            }
-        
-        if ((chanIdx[agetIdx]!=11) && (chanIdx[agetIdx]!=22) && (chanIdx[agetIdx]!=45) && (chanIdx[agetIdx]!=56)){
-            pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-            signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-            //Background_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-        }
-        chanIdx[agetIdx]++;
-    }
+    // slots are shared between trees, HLED events carry no region of interest
+    slot.event->SetROIMusicID(vector<int>());
+    slot.event->SetROIPixelID(vector<int>());
 
-    //eventForced->SetSignalValue(signalValue);
+    DecodeEvent(slot);
+    ExtractPulses(slot);
 }
 
-void EventBuilder::Write_HledEvent(string CoBo_filename_0, Event *eventHled, int asadIdx, int event_index, std::vector<std::vector<Int_t>> &signalValue, long startTime){
-    // ----------------------------------------------------------------------------------------------------------------
-    // First event in CoBo file, load first frame.
-    if(event_index == 0){
-        if(asadIdx == 0){
-            f_raw_0.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            f_raw_1.open(CoBo_filename_0, std::ios::in | std::ios::binary);
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    // Any frame after the First event in CoBo file.
-    }else{
-        if(asadIdx == 0){
-            curFrame = mfm::Frame::read(f_raw_0);
-        }else{
-            curFrame = mfm::Frame::read(f_raw_1);
-        }
-    }
-    
-    // -----------------------------------------------
-    // Debugging - Print Cobo header file data
-    //-----------------------------------------------
-    /*cout << "--------------------------------" << endl;
-    cout << "From Cobo Header:" << endl;
-    cout << "ASAD: " << curFrame->headerField("asadIdx").value<uint32_t>() << endl;
-    cout << "Event Indx: " << curFrame->headerField("eventIdx").value<uint32_t>() << endl;
-    cout << "Event Time: " << curFrame->headerField("eventTime").value<uint64_t>() << endl;
-    cout << "--------------------------------" << endl;
-*/
-    // ------------------------------------Filename: ./R----------------------------------------------------------------------------
-    // Store cobo header data and TB Time (from TB header data) in Hled struct
-    // UNIX TIME WILL BE CHANGED IN THE FUTURE.
-
-    if(asadIdx == 0){
-        eventHled->SetCoBoTime((ULong64_t)eventTime_CoBo);
-        eventHled->SetTBTime((ULong64_t)eventTime_TB+startTime);
-        //cout<<(ULong64_t)eventTime_TB+startTime<<endl;
-        //cout<<startTime<<endl;
-        cout<<eventTime_TB<<endl;
-        //eventHled->SetTBTime(time(NULL));
-        /*
-        Hled_struct->tb_time = eventTime_TB;
-        Hled_struct->cobo_time = eventTime_CoBo;
-        Hled_struct->unix_time = time(NULL);
-        */
-        eventIdx_CoBo_asad0 = eventIdx_CoBo;
-    }else { // confirm ASAD1 data corresponds to the same event as ASAD0.
-        try{
-            if(eventIdx_CoBo != eventIdx_CoBo_asad0){
-                throw 1;
+/**
+ * Chooses the output tree of an event from its trigger board record.
+ */
+void EventBuilder::SelectTree(EventSlot &slot){
+    switch (slot.triggerSource_TB){
+        case(Bifocal):
+            if(slot.FirstTrigMusic_TB<=63){
+                slot.treeID = TreeBiFocal;
+                slot.triggerName = "BIFOCAL TRIGGER";
+            }else{
+                slot.treeID = TreeForced;
+                slot.triggerName = "CORRUPT TRIGGER";
             }
-        }catch(int e){
-            cout << "Event indices of ASAD_0 and ASAD_1 do not match!";
-        }
+            break;
+        case(Internal):
+            slot.treeID = TreeForced;
+            slot.triggerName = "INTERNAL TRIGGER";
+            break;
+        case(DiscTest):
+            slot.treeID = TreeTest;
+            slot.triggerName = "TEST TRIGGER";
+            break;
+        case(HLED):
+            slot.treeID = TreeHLED;
+            slot.triggerName = "HLED TRIGGER";
+            break;
+        default:
+            slot.treeID = TreeForced;
+            slot.triggerName = "CORRUPT TRIGGER";
+            break;
     }
+}
 
-    // ----------------------------------------------------------------------------------------------------------------
-    // Store item data in Hled struct
-    // vectors for storing channel and bucket indices
-    std::vector<uint32_t> chanIdx = std::vector<uint32_t>(numChips, 0u);
-    std::vector<uint32_t> buckIdx = std::vector<uint32_t>(numChips, 0u);
-
-    //std::vector<std::vector<Int_t>> signalValue;
-    //signalValue = std::vector<std::vector<Int_t>>(MaxNofChannels, std::vector<Int_t>(MaxTimeBucket));
-
-    // read the first item in the frame
-    item = curFrame->itemAt(0);
-    field = item.field("");
-    agetIdxField = field.bitField("agetIdx");
-    sampleValueField = field.bitField("sample");
-    uint32_t agetIdx = agetIdxField.value<uint32_t>();
-    uint32_t sampleValue = sampleValueField.value<uint32_t>();
-    pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-    signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-
-    //Hled_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-    chanIdx[agetIdx]++;
-
-    // loop through rest of the items in the frame
-    for (size_t itemId=1; itemId < (((MaxNofChannels)+16)*MaxTimeBucket); ++itemId){
-        //set current item
-        item = curFrame->itemAt(itemId);
-        field = item.field(field); // contains 2 main values, agetID and sampleValue
-        agetIdxField = field.bitField(agetIdxField);
-        sampleValueField = field.bitField(sampleValueField);
-        agetIdx = agetIdxField.value<uint32_t>();
-        sampleValue = sampleValueField.value<uint32_t>();
-        
-        // increment channel index and bucket index
-        if (chanIdx[agetIdx] >= MaxChannelsPerAget)
-            {
-                chanIdx[agetIdx] = 0u;
-                buckIdx[agetIdx]++;
-            }
-        
-        if ((chanIdx[agetIdx]!=11) && (chanIdx[agetIdx]!=22) && (chanIdx[agetIdx]!=45) && (chanIdx[agetIdx]!=56)){
-            pixelMapEncoder(pixelMapArray, &sipmID, asadIdx, agetIdx, chanIdx[agetIdx]);
-           /* if(sipmID==0){
-                cout<<sipmID<<" "<<buckIdx[agetIdx]<<" "<< sampleValue<<endl;
-            }*/
-            
-            signalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
-            //Hled_struct->SignalValue[sipmID][buckIdx[agetIdx]] = sampleValue;
+/**
+ * Worker stage: decodes the frame of the event and fills the Event object of its slot.
+ * Runs concurrently on several slots, only touches the slot and read-only EventBuilder state.
+ */
+void EventBuilder::BuildEvent(EventSlot &slot, long startTime){
+    try{
+        switch (slot.treeID){
+            case(TreeBiFocal):
+                Write_BifocalEvent(slot, startTime);
+                break;
+            case(TreeTest):
+                Write_TestEvent(slot, startTime);
+                break;
+            case(TreeHLED):
+                Write_HledEvent(slot, startTime);
+                break;
+            default:
+                Write_BackgroundEvent(slot, startTime);
+                break;
         }
-
-        
-        chanIdx[agetIdx]++;
+    }catch(const std::exception & e){
+        slot.error = e.what();
     }
+}
 
-    //eventHled->SetSignalValue(signalValue);
+/**
+ * Sets the number of decode/ROI worker threads used by mainFlow.
+ * Reading and writing always run on their own thread.
+ * @param nThreads number of workers, at least 1
+ */
+void EventBuilder::SetThreads(int nThreads){
+    this->nThreads = (nThreads < 1) ? 1 : nThreads;
 }
+
 /*
 void EventBuilder::Write_Tree_to_file(){
     Bifocal_tree->Write();
@@ -776,21 +482,260 @@ EventBuilder::EventBuilder(string formats){
         string fileName = path+"/Pixel_Map.csv";
 //	cout<<fileName<<endl;
         pixelMapArray = openPixelMap(fileName);
+        buildPixelMapLUT(pixelMapArray, &pixelMapLUT);
+        frameDecoder = new FrameDecoder(pixelMapLUT);
+
+        // optional per tree output settings, the defaults are used without the file
+        if(outputConfig.Read(path+"/EventBuilder.cfg")){
+            outputConfig.Print();
+        }
+        fastDecoding = true;
+        nThreads = 1;
+        statsInterval = 0;
+        pulseExtractor = NULL;
     }
 }
 
 //Event Builder Destructor
 EventBuilder::~EventBuilder(){
+    CloseStreams();
+    delete frameDecoder;
+    delete pulseExtractor;
     closePixelMap(pixelMapArray);
 }
 
-void EventBuilder::mainFlow(string filename_0, string filename_tb, string outDir)
+/**
+ * Reads per tree basket size, split level, compression and autoflush/autosave settings.
+ * Settings missing from the file keep their current value.
+ * @param cfgFile configuration file in the EventBuilder.cfg format
+ * @return false if the file can not be read
+ */
+bool EventBuilder::ReadOutputConfig(string cfgFile){
+    bool found = outputConfig.Read(cfgFile);
+    if(found) outputConfig.Print();
+    return found;
+}
+
+/**
+ * Runs the ExACT pulse extraction while building the events and writes the extracted
+ * trees to <name>_Extracted.root next to the output file. The raw events are then only
+ * written as selected by the RAWTRACES settings.
+ * @param cfgFile ExACT.cfg with the extraction settings
+ * @return false if the file can not be read, extraction is then not enabled
+ */
+bool EventBuilder::SetPulseExtraction(string cfgFile){
+    std::ifstream cfgFileStream(cfgFile.c_str());
+    if(!cfgFileStream) return false;
+    delete pulseExtractor;
+    pulseExtractor = new PulseExtractor(cfgFile);
+    return true;
+}
+
+/**
+ * Prints the size of each tree before and after compression, and the run throughput.
+ * Called once the trees are written, before the file is closed.
+ */
+void EventBuilder::ReportOutput(TTree **trees, std::chrono::steady_clock::time_point runStart){
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    double totMB = 0.;
+    double zipMB = 0.;
+    for(int k=0; k<NofTrees; k++){
+        stats.outputRawBytes += trees[k]->GetTotBytes();
+        stats.outputBytes += trees[k]->GetZipBytes();
+        double treeTotMB = trees[k]->GetTotBytes()/1.e6;
+        double treeZipMB = trees[k]->GetZipBytes()/1.e6;
+        totMB += treeTotMB;
+        zipMB += treeZipMB;
+        if(!RunLog::Enabled(LogInfo)) continue;
+        cout << trees[k]->GetName() << ": " << trees[k]->GetEntries() << " events, " << treeTotMB << " MB -> " << treeZipMB << " MB";
+        if(treeZipMB > 0) cout << " (compression " << treeTotMB/treeZipMB << ")";
+        cout << endl;
+    }
+    if(!RunLog::Enabled(LogInfo)) return;
+    cout << "Output: " << totMB << " MB -> " << zipMB << " MB";
+    if(zipMB > 0) cout << " (compression " << totMB/zipMB << ")";
+    cout << " in " << elapsed << " s";
+    if(elapsed > 0) cout << ", " << totMB/elapsed << " MB/s uncompressed, " << zipMB/elapsed << " MB/s written";
+    cout << endl;
+}
+
+/**
+ * Creates an output file with one tree per trigger type, set up from the output configuration.
+ * @param trees receives the trees, owned by the file
+ * @param treeEvents branch addresses, must stay valid until the file is closed
+ */
+TFile *EventBuilder::OpenOutput(string fileName, TTree **trees, Event **treeEvents){
+    EB_LOG(LogInfo) << "Output file: " << fileName << endl;
+    TFile *f = new TFile(fileName.c_str(), "RECREATE");
+    outputFiles.push_back(fileName);
+
+    trees[TreeBiFocal] = new TTree("BiFocal", "Bifocal Triggers");
+    trees[TreeForced] = new TTree("Forced", "Forced Triggers");
+    trees[TreeHLED] = new TTree("HLED", "HLED Triggers");
+    trees[TreeTest] = new TTree("Test", "Test Triggers");
+
+    for(int k=0; k<NofTrees; k++){
+        const TreeOutputConfig &treeConfig = outputConfig.GetTreeConfig(k);
+        TBranch *branch = trees[k]->Branch("Events","Event",&treeEvents[k],treeConfig.basketSize,treeConfig.splitLevel);
+        if(branch && treeConfig.compressionSettings >= 0) branch->SetCompressionSettings(treeConfig.compressionSettings);
+        if(treeConfig.autoFlush != 0) trees[k]->SetAutoFlush(treeConfig.autoFlush);
+        if(treeConfig.autoSave != 0) trees[k]->SetAutoSave(treeConfig.autoSave);
+    }
+    return f;
+}
+
+/**
+ * Creates the file of the extracted trees, in the layout ExACT gives _Extracted.root files.
+ * @param trees receives the trees, owned by the file
+ */
+TFile *EventBuilder::OpenExtractedOutput(string fileName, TTree **trees){
+    EB_LOG(LogInfo) << "Extracted output file: " << fileName << endl;
+    TFile *f = new TFile(fileName.c_str(), "RECREATE");
+    outputFiles.push_back(fileName);
+
+    trees[TreeBiFocal] = new TTree("BiFocal", "Extracted Data");
+    trees[TreeForced] = new TTree("Forced", "Extracted Data");
+    trees[TreeHLED] = new TTree("HLED", "Extracted Data");
+    trees[TreeTest] = new TTree("Test", "Extracted Data");
+
+    for(int k=0; k<NofTrees; k++){
+        pulseExtractor->Branch(trees[k], k, k == TreeBiFocal || k == TreeTest);
+    }
+    return f;
+}
+
+/**
+ * With pulse extraction, selects the events also written with their traces: one in
+ * RAWTRACES events of each tree, starting with the first.
+ * @param treeCounters events seen so far per tree, updated
+ */
+bool EventBuilder::KeepRawEvent(int treeID, Long64_t *treeCounters){
+    Long64_t prescale = outputConfig.GetTreeConfig(treeID).rawPrescale;
+    bool keep = prescale > 0 && treeCounters[treeID] % prescale == 0;
+    treeCounters[treeID]++;
+    return keep;
+}
+
+/**
+ * Writes the trees to their file, reports the output and closes the file.
+ * @param fileStart time the file was opened, for the output rate
+ */
+void EventBuilder::CloseOutput(TFile *f, TTree **trees, std::chrono::steady_clock::time_point fileStart){
+    std::chrono::steady_clock::time_point writeStart = std::chrono::steady_clock::now();
+    f->cd();
+    f->Write();
+    ReportOutput(trees, fileStart);
+    f->Close();
+    // the trees belong to the file and are gone with it
+    delete f;
+    stats.writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+}
+
+/**
+ * Gives back the mapped pages of every CoBo file that lie before the frames of an event.
+ * Events are written in eventIdx order, so the pages behind the writer are not read again
+ * except for frames out of order, which are then read back from the file.
+ * @param coboIndex event index in the EventAssembler
+ */
+void EventBuilder::ReleaseFrames(int coboIndex){
+    const AssembledEvent &assembled = eventAssembler.getEvent(coboIndex);
+    for(size_t asadIdx=0; asadIdx<assembled.frames.size(); asadIdx++){
+        if(assembled.frames[asadIdx] >= 0) grawReaders[asadIdx]->releasePages(assembled.frames[asadIdx]);
+    }
+}
+
+/**
+ * Writes the statistics records to one file for all runs instead of <run>_stats.json.
+ * @param fileName JSON lines file, records are appended
+ */
+void EventBuilder::SetStatsFile(string fileName){
+    statsFileName = fileName;
+}
+
+/**
+ * Adds a progress record to the statistics every interval seconds during a run.
+ * @param seconds interval, 0 for the end of run record only
+ */
+void EventBuilder::SetStatsInterval(int seconds){
+    statsInterval = seconds;
+}
+
+/**
+ * Statistics of the last run.
+ */
+const RunStatistics &EventBuilder::GetStatistics() const{
+    return stats;
+}
+
+/**
+ * Output files of the last run, in the order they were written.
+ */
+const std::vector<std::string> &EventBuilder::GetOutputFiles() const{
+    return outputFiles;
+}
+
+/**
+ * Pairs the trigger board records with the assembled CoBo events on their event counters.
+ * The report goes to the output and, with every orphan listed, to <run>_join.txt next to
+ * the ROOT file.
+ * @param nCoboEvents number of assembled events to use
+ * @return number of events found in both streams
+ */
+int EventBuilder::JoinTriggerBoard(TBDecoder *TBEvents, string TB_filename, int nCoboEvents, string Out_filename){
+    std::vector<uint32_t> tbEventNumbers(TBEvents->getNofEvents());
+    if(!tbEventNumbers.empty()){
+        TBEvents->decodeRecords(0, tbEventNumbers.size(), &tbEventNumbers[0], NULL, NULL, NULL);
+    }
+    EB_LOG(LogInfo) << "Total Number of TB records: " << tbEventNumbers.size() << endl;
+    stats.inputFiles.push_back(TB_filename);
+    stats.inputBytes += tbEventNumbers.size()*sizeof(EventData);
+
+    triggerJoiner.join(tbEventNumbers, eventAssembler, nCoboEvents);
+    if(RunLog::Enabled(LogInfo)) triggerJoiner.printReport(cout);
+    stats.tbOrphans = triggerJoiner.getTBOrphanCount();
+    stats.coboOrphans = triggerJoiner.getCoboOrphanCount();
+
+    string reportName = Out_filename.substr(0, Out_filename.size()-5) + "_join.txt";
+    std::ofstream report(reportName.c_str());
+    if(report){
+        triggerJoiner.printReport(report, tbEventNumbers.size() + nCoboEvents);
+    }else{
+        EB_LOG(LogWarning) << "Can not write join report " << reportName << endl;
+    }
+    return triggerJoiner.getEventCount();
+}
+
+/**
+ * Selects the frame decoder. The compiled decoder is used by default, the generic
+ * frame dictionary decoding is kept for formats it does not know and for cross checks.
+ * @param enable false to always use the generic decoding
+ */
+void EventBuilder::SetFastDecoding(bool enable){
+    fastDecoding = enable;
+}
+
+/**
+ * Builds the events of one run.
+ * @param filename_0 CoBo file prefix, or comma separated prefixes of the files of each AsAd in pixel map order
+ * @param filename_tb trigger board file prefix
+ * @param outDir directory of the output ROOT file, named after the first CoBo file
+ * @return path of the output ROOT file
+ */
+string EventBuilder::mainFlow(string filename_0, string filename_tb, string outDir)
 {
     struct std::tm  t = {};
+    stats.Start(filename_0);
+    std::chrono::steady_clock::time_point runStart = stats.start;
+
+    std::vector<std::string> CoBo_filenames;
+    std::stringstream prefixes(filename_0);
+    std::string prefix;
+    while (std::getline(prefixes, prefix, ',')) {
+        if (!prefix.empty()) CoBo_filenames.push_back(prefix + ".graw");
+    }
+    if (CoBo_filenames.empty()) CoBo_filenames.push_back(filename_0 + ".graw");
 
-    std::string CoBo_filename_0 = filename_0 + ".graw";
-    //std::string CoBo_filename_1 = filename_1 + ".graw";
-    std::string Out_filename = filename_0 + ".root";
+    std::string Out_filename = CoBo_filenames[0].substr(0, CoBo_filenames[0].size()-5) + ".root";
     std::string TB_filename = filename_tb + ".bin";
 
     std::string TB_trimmedName = TB_filename.substr(TB_filename.find_last_of("/\\")+1);
@@ -803,170 +748,196 @@ void EventBuilder::mainFlow(string filename_0, string filename_tb, string outDir
     Out_filename = Out_filename.substr(Out_filename.find_last_of("/\\")+1);
     Out_filename = outDir+"/"+Out_filename;
 
-    cout<<"R"<<endl;
-    /*
-    STRUCT_Bifocal Bifocal_event;
-    STRUCT_Background Background_event;
-    STRUCT_Hled Hled_event;
-    */
     /* Here we switch to Event DataType*/
-    
-
-    TFile *f = new TFile(Out_filename.c_str(), "RECREATE");
 
-    TTree *Bifocal_tree = Bifocal_tree = new TTree("BiFocal", "Bifocal Triggers");
-    TTree *Background_tree = new TTree("Forced", "Forced Triggers");;
-    TTree *Hled_tree = new TTree("HLED", "HLED Triggers");
-    TTree *Test_tree = new TTree("Test", "Test Triggers");
-
-    Event *eventBifocal = new Event();
-    Event *eventHled = new Event();
-    Event *eventForced = new Event();
-    Event *eventTest = new Event();
+    // Open CoBo files and join their frames on eventIdx
+    std::chrono::steady_clock::time_point stageStart = std::chrono::steady_clock::now();
+    int Total_NofEvents = FrameCounter(CoBo_filenames);
+    stats.scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stageStart).count();
+    int nAsads = grawReaders.size();
+    if (nAsads == 0) nAsads = 1;
+
+    // slots carry one event each from the reader through the workers to the writer
+    int nSlots = 2*nThreads + 2;
+    std::vector<EventSlot> slots(nSlots);
+    for(int k=0; k<nSlots; k++){
+        slots[k].event = new Event();
+        // frames are decoded straight into the flat traces of the slot Event
+        slots[k].event->SetTraceSize(MaxNofChannels*nAsads, MaxTimeBucket);
+    }
 
-    Bifocal_tree->Branch("Events","Event",&eventBifocal,64000,0);
-    Background_tree->Branch("Events","Event",&eventForced,64000,0);
-    Hled_tree->Branch("Events","Event",&eventHled,64000,0);
-    Test_tree->Branch("Events","Event",&eventTest,64000,0);
+    // branch addresses, the writer points them to the Event of the slot being filled
+    Event *treeEvents[NofTrees];
+    for(int k=0; k<NofTrees; k++){
+        treeEvents[k] = slots[0].event;
+    }
 
+    // the output is split in parts when the configuration asks for it, <name>.root then <name>_<part>.root
+    TTree *trees[NofTrees];
+    outputFiles.clear();
+    int outputPart = 0;
+    Long64_t eventsInFile = 0;
+    std::chrono::steady_clock::time_point fileStart = runStart;
+    TFile *f = OpenOutput(Out_filename, trees, treeEvents);
+
+    // fused extraction, every part of the output gets its <part>_Extracted.root
+    TTree *extractedTrees[NofTrees];
+    TFile *fExtracted = NULL;
+    Long64_t rawCounters[NofTrees] = {0, 0, 0, 0};
+    if(pulseExtractor) fExtracted = OpenExtractedOutput(Out_filename.substr(0, Out_filename.size()-5) + "_Extracted.root", extractedTrees);
+
+    // create TBDecoder object to read trigger board data, and pair its records with the CoBo events
+    stageStart = std::chrono::steady_clock::now();
+    TBDecoder *TBEvents = new TBDecoder(TB_filename.c_str());
+    Total_NofEvents = JoinTriggerBoard(TBEvents, TB_filename, Total_NofEvents, Out_filename);
+    stats.joinSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - stageStart).count();
+
+    // statistics records, one JSON object per line: progress records every statsInterval seconds, then the run record
+    string statsName = statsFileName;
+    if(statsName.empty()) statsName = Out_filename.substr(0, Out_filename.size()-5) + "_stats.json";
+    std::ofstream statsFile(statsName.c_str(), statsFileName.empty() ? std::ios::trunc : std::ios::app);
+    if(!statsFile) EB_LOG(LogWarning) << "Can not write statistics to " << statsName << endl;
+    std::chrono::steady_clock::time_point lastStats = std::chrono::steady_clock::now();
 
-/*
-    Set_Branch_Bifocal(Bifocal_tree, eventBifocal);
-    Set_Branch_Hled(Hled_eventHled);
-    Set_Branch_Background(eventForced);
-*/
-    /*Set_Branch_Bifocal(&Bifocal_event);
-    Set_Branch_Background(&Background_event);
-    Set_Branch_Hled(&Hled_event);*/
-
-    // Open CoBo files and count Number of events for each AsAd
-    int Total_NofEvents = 0;
-    int AsAd0_NofEvents = FrameCounter(CoBo_filename_0,0);
-    Total_NofEvents = AsAd0_NofEvents;
-    //int AsAd2_NofEvents = FrameCounter(CoBo_filename_1,2);
-
-    /*if(AsAd0_NofEvents == AsAd2_NofEvents) {
-        Total_NofEvents = AsAd0_NofEvents;
-        cout << "NofEvents on both AsAd files match." << endl;
+    // ----------------------------------------------------------------------------------------------------------------
+    // Pipeline: one reader thread (TB records, tree selection), nThreads workers (frame decoding, ROI) and
+    // the writer on this thread, which fills the trees in the original event order.
+    // The number of slots bounds the number of events in flight.
+    BlockingQueue<EventSlot*> freeSlots;
+    BlockingQueue<EventSlot*> workQueue;
+    for(int k=0; k<nSlots; k++){
+        freeSlots.push(&slots[k]);
     }
-    else{
-        if(AsAd0_NofEvents > AsAd2_NofEvents){
-        Total_NofEvents = AsAd2_NofEvents;
-        cout << "NofEvents on AsAd0 file is bigger. Going with AsAd2_NofEvents." << endl;
-        }else{
-            Total_NofEvents = AsAd0_NofEvents;
-            cout << "NofEvents on AsAd2 file is bigger. Going with AsAd0_NofEvents." << endl;
-        }
-    }*/
 
-    // create TBDecoder object to read trigger board data
-    TBDecoder *TBEvents = new TBDecoder(Total_NofEvents, TB_filename.c_str());
-    int hledCounter, biFCounter;
-    hledCounter = 0;
-    biFCounter = 0;
-    std::vector<std::vector<Int_t>> signalValue;
-    signalValue = std::vector<std::vector<Int_t>>(MaxNofChannels, std::vector<Int_t>(MaxTimeBucket));
+    // decoded events waiting for the writer, keyed by event index
+    std::map<int, EventSlot*> doneSlots;
+    std::mutex doneMutex;
+    std::condition_variable doneCond;
+
+    std::thread reader([&](){
+        EventSlot *slot;
+        for (int event_index=0; event_index < Total_NofEvents; event_index++){
+            const JoinedEvent &joined = triggerJoiner.getEvent(event_index);
+            freeSlots.pop(slot);
+            slot->eventIndex = event_index;
+            slot->coboIndex = joined.coboIndex;
+            slot->error.clear();
+            logTBevent(joined.tbIndex, TBEvents, *slot);
+            SelectTree(*slot);
+            workQueue.push(slot);
+        }
+        workQueue.close();
+    });
+
+    std::vector<std::thread> workers;
+    for(int k=0; k<nThreads; k++){
+        workers.push_back(std::thread([&](){
+            EventSlot *slot;
+            while(workQueue.pop(slot)){
+                std::chrono::steady_clock::time_point decodeStart = std::chrono::steady_clock::now();
+                BuildEvent(*slot, seconds);
+                slot->decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - decodeStart).count();
+                {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    doneSlots[slot->eventIndex] = slot;
+                }
+                doneCond.notify_all();
+            }
+        }));
+    }
 
-    // loop through each event in the data (2 frames per event)
+    // loop through each event in the data, in order
     for (int event_index=0; event_index < Total_NofEvents; event_index++)
     {
-        cout << "-----------------------------------------" << endl;
-        // set TB instance variables, including triggerSource_TB
-        try{
-            logTBevent(event_index, TBEvents);
-        }catch(int e){
-            cout << "TB event number mismatch, event index " << e << endl;
-            return;
+        EventSlot *slot;
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneCond.wait(lock, [&]{ return doneSlots.count(event_index) > 0; });
+            slot = doneSlots[event_index];
+            doneSlots.erase(event_index);
         }
 
-        //triggerSource_TB = HLED;
-        switch (triggerSource_TB){
-            case(Bifocal):
-                f->cd();
-                //cout<<"MUSIC: "<<FirstTrigMusic_TB<<endl;
-                if(FirstTrigMusic_TB<=63){
-                    cout << "Event " << event_index << " | BIFOCAL TRIGGER" << endl;  
-                    Write_BifocalEvent(CoBo_filename_0, eventBifocal, ASAD0, event_index, signalValue, seconds);
-                    //Write_BifocalEvent(CoBo_filename_1, eventBifocal, ASAD1, event_index, signalValue, seconds);               
-                    eventBifocal->SetSignalValue(signalValue);
-                    Bifocal_tree->Fill(); 
-                    biFCounter ++;
-                }else{
-                    cout << "Event " << event_index << " | CORRUPT TRIGGER" << endl;
-                    //f->cd();
-                    Write_BackgroundEvent(CoBo_filename_0, eventForced, ASAD0, event_index,signalValue,seconds);
-                    //Write_BackgroundEvent(CoBo_filename_1, eventForced, ASAD1, event_index,signalValue,seconds);
-                    //f->cd();
-                    eventForced->SetSignalValue(signalValue);
-                    Background_tree->Fill();
-                }      
-                break;
-            case(Internal):
-                cout << "Event " << event_index << " | INTERNAL TRIGGER" << endl;           
-                f->cd();
-                Write_BackgroundEvent(CoBo_filename_0, eventForced, ASAD0, event_index,signalValue,seconds);
-                //Write_BackgroundEvent(CoBo_filename_1, eventForced, ASAD1, event_index,signalValue,seconds);
-                
-                eventForced->SetSignalValue(signalValue);
-                Background_tree->Fill();
-                break;
-            case(DiscTest):
-                f->cd();
-                //if(FirstTrigMusic_TB<=63){
-                    cout << "Event " << event_index << " | TEST TRIGGER" << endl;           
-                    
-                    Write_TestEvent(CoBo_filename_0, eventTest, ASAD0, event_index,signalValue,seconds);
-                   // Write_TestEvent(CoBo_filename_1, eventForced, ASAD1, event_index,signalValue,seconds);
-                    eventTest->SetSignalValue(signalValue);
-                    Test_tree->Fill();
-                /*}else{
-                    cout << "Event " << event_index << " | CORRUPT TRIGGER" << endl;
-                    //f->cd();
-                    Write_BackgroundEvent(CoBo_filename_0, eventForced, ASAD0, event_index,signalValue,seconds);
-                    Write_BackgroundEvent(CoBo_filename_1, eventForced, ASAD1, event_index,signalValue,seconds);
-                    //f->cd();
-                    eventForced->SetSignalValue(signalValue);
-                    Background_tree->Fill();
-                }*/
-                break;
-            case(HLED):
-                cout << "Event " << event_index << " | HLED TRIGGER" << endl;
-                f->cd();
-                Write_HledEvent(CoBo_filename_0, eventHled, ASAD0, event_index,signalValue,seconds);
-                //Write_HledEvent(CoBo_filename_1, eventHled, ASAD1, event_index,signalValue,seconds);  // we pass asad1 here, even if 2nd asad is connected to asad2 or asad3. this is just for calculating the pixel mapping
-                //f->cd();
-                eventHled->SetSignalValue(signalValue);
-                Hled_tree->Fill();
-                hledCounter++;
-                break;
-            default:
-                cout << "Event " << event_index << " | CORRUPT TRIGGER" << endl;
+        if(RunLog::Enabled(LogEvent)){
+            cout << "-----------------------------------------" << endl;
+            cout << "TB: Event number: " << slot->eventNumber_TB << endl;
+            cout << "Event " << event_index << " | " << slot->triggerName << endl;
+        }
+        stats.decodeSeconds += slot->decodeSeconds;
+
+        if(!slot->error.empty()){
+            EB_LOG(LogWarning) << "Event " << event_index << " could not be built: " << slot->error << endl;
+            stats.failedEvents++;
+        }else{
+            std::chrono::steady_clock::time_point writeStart = std::chrono::steady_clock::now();
+            if(fExtracted){
+                fExtracted->cd();
+                pulseExtractor->Fill(slot->treeID, slot->event, slot->extracted);
+            }
+            if(!fExtracted || KeepRawEvent(slot->treeID, rawCounters)){
+                // Fill() picks up the new object address behind the branch pointer
                 f->cd();
-                Write_BackgroundEvent(CoBo_filename_0, eventForced, ASAD0, event_index,signalValue,seconds);
-               // Write_BackgroundEvent(CoBo_filename_1, eventForced, ASAD1, event_index,signalValue,seconds);
-                //f->cd();
-                eventForced->SetSignalValue(signalValue);
-                Background_tree->Fill();
-                break;
+                treeEvents[slot->treeID] = slot->event;
+                trees[slot->treeID]->Fill();
+            }
+            stats.writeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+            stats.events++;
+            stats.treeEvents[slot->treeID]++;
+            stats.frames += eventAssembler.getEvent(slot->coboIndex).frames.size() - slot->nMissing;
+            if(slot->nMissing > 0){
+                EB_LOG(LogEvent) << "Event " << event_index << " | EventIdx " << slot->eventIdx_CoBo << " missing " << slot->nMissing << " AsAd fragment(s)" << endl;
+            }
+            eventsInFile++;
+        }
+        // frames before the ones of this event are no longer needed
+        if(event_index % ReleaseInterval == ReleaseInterval-1) ReleaseFrames(slot->coboIndex);
+        freeSlots.push(slot);
+
+        bool splitEvents = outputConfig.GetSplitEvents() > 0 && eventsInFile >= outputConfig.GetSplitEvents();
+        bool splitSize = outputConfig.GetSplitSize() > 0 && (f->GetEND() >= outputConfig.GetSplitSize()
+                         || (fExtracted && fExtracted->GetEND() >= outputConfig.GetSplitSize()));
+        if((splitEvents || splitSize) && event_index < Total_NofEvents-1){
+            CloseOutput(f, trees, fileStart);
+            if(fExtracted) CloseOutput(fExtracted, extractedTrees, fileStart);
+            outputPart++;
+            std::stringstream partName;
+            partName << Out_filename.substr(0, Out_filename.size()-5) << "_" << outputPart;
+            fileStart = std::chrono::steady_clock::now();
+            eventsInFile = 0;
+            f = OpenOutput(partName.str() + ".root", trees, treeEvents);
+            if(fExtracted) fExtracted = OpenExtractedOutput(partName.str() + "_Extracted.root", extractedTrees);
+        }
+
+        if(statsInterval > 0 && statsFile && std::chrono::steady_clock::now() - lastStats >= std::chrono::seconds(statsInterval)){
+            lastStats = std::chrono::steady_clock::now();
+            stats.outputFiles = outputFiles;
+            stats.WriteJSON(statsFile, "progress");
         }
     }
 
-    cout<<"BiFocal Events: "<< biFCounter <<" HLED Events: "<<hledCounter<<endl;
-     
-    // delete TBEvent object
-    //delete TBEvents;
+    reader.join();
+    for(size_t k=0; k<workers.size(); k++){
+        workers[k].join();
+    }
 
-    // Close CoBo files, oppened within FrameCounter function above
-    f_raw_0.close();
-    //f_raw_1.close();
+    EB_LOG(LogInfo) << "BiFocal Events: " << stats.treeEvents[TreeBiFocal] << " HLED Events: " << stats.treeEvents[TreeHLED]
+                    << " Forced Events: " << stats.treeEvents[TreeForced] << " Test Events: " << stats.treeEvents[TreeTest] << endl;
 
-    // create output tree file, write all three trees to that file, close the file
-    
-    // Bifocal_tree->Write();
-    // Background_tree->Write();
-    // Hled_tree->Write();
-    f->cd();
-    f->Write();
-    //Write_Tree_to_file();
-    f->Close();
+    // delete TBEvent object, which unmaps the trigger board file
+    delete TBEvents;
+
+    // Unmap CoBo files, opened within FrameCounter function above
+    CloseStreams();
+
+    // write all trees to the output file and close it
+    CloseOutput(f, trees, fileStart);
+    if(fExtracted) CloseOutput(fExtracted, extractedTrees, fileStart);
+
+    stats.outputFiles = outputFiles;
+    if(statsFile) stats.WriteJSON(statsFile, "run");
+    EB_LOG(LogInfo) << "Statistics: " << statsName << endl;
+
+    for(int k=0; k<nSlots; k++){
+        delete slots[k].event;
+    }
+    return Out_filename;
 }
@@ -0,0 +1,131 @@
+#include "FrameDecoder.h"
+
+#include <algorithm>
+
+#define PartialReadoutItemSize  4
+#define FullReadoutItemSize     2
+#define SampleMask              0xFFF
+
+/**
+ * Finds the highest pixel of each AsAd, so that decode() checks the destination size once per frame.
+ * @param pixelMap lookup tables from buildPixelMapLUT, must outlive the decoder
+ */
+FrameDecoder::FrameDecoder(const PixelMapLUT &pixelMap) : pixelMap(pixelMap)
+{
+    for(int asad=0; asad<DecoderNofAsads; asad++){
+        maxSipmID[asad] = -1;
+        for(int aget=0; aget<DecoderNofAgets; aget++){
+            for(int chan=0; chan<DecoderChannelsPerAget; chan++){
+                if(pixelMap.sipmID[asad][aget][chan] > maxSipmID[asad]) maxSipmID[asad] = pixelMap.sipmID[asad][aget][chan];
+            }
+        }
+    }
+}
+
+/**
+ * Checks the frame header against the layouts this decoder knows.
+ * @param frame header summary from GrawReader
+ * @param asadIdx pixel map AsAd the frame is decoded for
+ * @return true if decode() can handle the frame
+ */
+bool FrameDecoder::isSupported(const GrawFrame &frame, int asadIdx) const
+{
+    bool supported = false;
+    if(asadIdx >= 0 && asadIdx < DecoderNofAsads && maxSipmID[asadIdx] >= 0 && frame.headerSize > 0){
+        if(frame.frameType == DecoderPartialReadout && frame.itemSize == PartialReadoutItemSize) supported = true;
+        if(frame.frameType == DecoderFullReadout && frame.itemSize == FullReadoutItemSize) supported = true;
+    }
+    return supported;
+}
+
+/**
+ * Unpacks the samples of a frame into traces[sipmID*nSamples + bucket].
+ * @param frame header summary from GrawReader, items are read in place
+ * @param asadIdx pixel map AsAd the frame belongs to
+ * @param traces destination, nPixels x nSamples, nPixels above the highest sipmID of the AsAd
+ * @param maxItems upper limit on the number of items to decode
+ * @return false if the frame is not supported, traces are then unchanged
+ */
+bool FrameDecoder::decode(const GrawFrame &frame, int asadIdx, UShort_t *traces, int nPixels, int nSamples, size_t maxItems) const
+{
+    if(!isSupported(frame, asadIdx) || nPixels <= maxSipmID[asadIdx]) return false;
+
+    size_t nItems = frame.itemCount;
+    if(nItems > maxItems) nItems = maxItems;
+
+    if(frame.frameType == DecoderPartialReadout){
+        clear(asadIdx, traces, nPixels, nSamples);
+        decodePartialReadout(frame, pixelMap.sipmID[asadIdx], traces, nSamples, nItems);
+    }else{
+        decodeFullReadout(frame, pixelMap.sipmID[asadIdx], traces, nSamples, nItems);
+    }
+    return true;
+}
+
+/**
+ * Zeroes the traces of every pixel of the AsAd, the samples a zero suppressed frame does not carry.
+ * @param traces nPixels x nSamples, pixels above nPixels are left out
+ */
+void FrameDecoder::clear(int asadIdx, UShort_t *traces, int nPixels, int nSamples) const
+{
+    if(asadIdx < 0 || asadIdx >= DecoderNofAsads) return;
+    for(int aget=0; aget<DecoderNofAgets; aget++){
+        for(int chan=0; chan<DecoderChannelsPerAget; chan++){
+            int sipmID = pixelMap.sipmID[asadIdx][aget][chan];
+            if(sipmID >= 0 && sipmID < nPixels){
+                std::fill(traces + (size_t)sipmID*nSamples, traces + (size_t)(sipmID+1)*nSamples, 0);
+            }
+        }
+    }
+}
+
+/**
+ * Frame type 1, every item carries its own channel and bucket index.
+ */
+void FrameDecoder::decodePartialReadout(const GrawFrame &frame, const int16_t (*lut)[DecoderChannelsPerAget], UShort_t *traces, int nSamples, size_t nItems) const
+{
+    const unsigned char *p = (const unsigned char *)frame.data + frame.headerSize;
+    for(size_t itemId=0; itemId<nItems; itemId++, p+=PartialReadoutItemSize){
+        uint32_t word;
+        if(frame.bigEndian){
+            word = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        }else{
+            word = ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+        }
+        uint32_t agetIdx = word >> 30;
+        uint32_t chanIdx = (word >> 23) & 0x7F;
+        uint32_t buckIdx = (word >> 14) & 0x1FF;
+        if(chanIdx >= DecoderChannelsPerAget) continue;
+        int sipmID = lut[agetIdx][chanIdx];
+        if(sipmID < 0 || (int)buckIdx >= nSamples) continue;
+        traces[sipmID*nSamples + buckIdx] = word & SampleMask;
+    }
+}
+
+/**
+ * Frame type 2, channels are implicit: each aget sends its 68 channels in order for every bucket.
+ */
+void FrameDecoder::decodeFullReadout(const GrawFrame &frame, const int16_t (*lut)[DecoderChannelsPerAget], UShort_t *traces, int nSamples, size_t nItems) const
+{
+    uint32_t chanIdx[DecoderNofAgets] = {0u, 0u, 0u, 0u};
+    uint32_t buckIdx[DecoderNofAgets] = {0u, 0u, 0u, 0u};
+
+    const unsigned char *p = (const unsigned char *)frame.data + frame.headerSize;
+    int hi = frame.bigEndian ? 0 : 1;
+    int lo = 1 - hi;
+    for(size_t itemId=0; itemId<nItems; itemId++, p+=FullReadoutItemSize){
+        uint32_t word = ((uint32_t)p[hi] << 8) | p[lo];
+        uint32_t agetIdx = word >> 14;
+
+        // increment channel index and bucket index
+        if(chanIdx[agetIdx] >= DecoderChannelsPerAget){
+            chanIdx[agetIdx] = 0u;
+            buckIdx[agetIdx]++;
+        }
+        int sipmID = lut[agetIdx][chanIdx[agetIdx]];
+        if(sipmID >= 0 && (int)buckIdx[agetIdx] < nSamples){
+            traces[sipmID*nSamples + buckIdx[agetIdx]] = word & SampleMask;
+        }
+        chanIdx[agetIdx]++;
+    }
+}
@@ -0,0 +1,92 @@
+#include "GrawIndex.h"
+
+#include <fstream>
+
+using namespace std;
+
+static void putField(unsigned char *p, uint64_t value, int nBytes)
+{
+    for(int i=0; i<nBytes; i++){
+        p[i] = (value >> (8*i)) & 0xFF;
+    }
+}
+
+static uint64_t getField(const unsigned char *p, int nBytes)
+{
+    uint64_t value = 0;
+    for(int i=nBytes-1; i>=0; i--){
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/**
+ * @param grawFileName path of the .graw file
+ * @return path of its sidecar index, the .graw extension replaced by .gidx
+ */
+string grawIndexFileName(const string &grawFileName)
+{
+    string baseName = grawFileName;
+    size_t ext = baseName.rfind(".graw");
+    if(ext != string::npos && ext + 5 == baseName.size()) baseName.erase(ext);
+    return baseName + ".gidx";
+}
+
+/**
+ * Reads all complete records of an index file.
+ * @return false if the file does not exist or is not a frame index of a known version
+ */
+bool readGrawIndex(const string &indexFileName, vector<GrawIndexRecord> &records)
+{
+    records.clear();
+    ifstream in(indexFileName.c_str(), ios::binary);
+    if(!in.is_open()) return false;
+
+    unsigned char header[GrawIndexHeaderSize];
+    if(!in.read((char *)header, GrawIndexHeaderSize)) return false;
+    if(header[0] != 'G' || header[1] != 'I' || header[2] != 'D' || header[3] != 'X') return false;
+    if(getField(header + 4, 4) != GrawIndexVersion || getField(header + 8, 4) != GrawIndexRecordSize) return false;
+
+    unsigned char buf[GrawIndexRecordSize];
+    while(in.read((char *)buf, GrawIndexRecordSize)){
+        GrawIndexRecord record;
+        record.offset = getField(buf, 8);
+        record.size = getField(buf + 8, 4);
+        record.eventIdx = getField(buf + 12, 4);
+        record.frameType = getField(buf + 16, 2);
+        record.coboIdx = buf[18];
+        record.asadIdx = buf[19];
+        records.push_back(record);
+    }
+    return true;
+}
+
+/**
+ * Writes a complete index file, replacing any existing one.
+ * @return false if the file could not be written
+ */
+bool writeGrawIndex(const string &indexFileName, const vector<GrawIndexRecord> &records)
+{
+    ofstream out(indexFileName.c_str(), ios::binary | ios::trunc);
+    if(!out.is_open()) return false;
+
+    unsigned char header[GrawIndexHeaderSize] = {'G', 'I', 'D', 'X'};
+    putField(header + 4, GrawIndexVersion, 4);
+    putField(header + 8, GrawIndexRecordSize, 4);
+    putField(header + 12, 0, 4);
+    out.write((const char *)header, GrawIndexHeaderSize);
+
+    for(size_t k=0; k<records.size(); k++){
+        unsigned char buf[GrawIndexRecordSize];
+        putField(buf, records[k].offset, 8);
+        putField(buf + 8, records[k].size, 4);
+        putField(buf + 12, records[k].eventIdx, 4);
+        putField(buf + 16, records[k].frameType, 2);
+        buf[18] = records[k].coboIdx;
+        buf[19] = records[k].asadIdx;
+        putField(buf + 20, 0, 4);
+        out.write((const char *)buf, GrawIndexRecordSize);
+    }
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,334 @@
+#include "GrawReader.h"
+#include "GrawIndex.h"
+#include "RunLog.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+// MFM primary header layout (see CoboFormats.xcfg)
+#define mfmPrimaryHeaderSize    8
+#define mfmFrameSizeOffset      1
+#define mfmFrameTypeOffset      5
+#define mfmRevisionOffset       7
+
+// CoBo standard header layout, identical for revision 5 of frame types 1 and 2
+#define coboHeaderSizeOffset    8
+#define coboItemSizeOffset      10
+#define coboItemCountOffset     12
+#define coboEventTimeOffset     16
+#define coboEventIdxOffset      22
+#define coboCoboIdxOffset       26
+#define coboAsadIdxOffset       27
+#define coboMinHeaderSize       28
+
+#define coboPartialReadout      1
+#define coboFullReadout         2
+
+/**
+ * Reads an unsigned integer of nBytes bytes stored with the given byte order.
+ * @param p pointer to the first byte
+ * @param nBytes number of bytes, at most 8
+ * @param bigEndian byte order of the stored value
+ * @return decoded value
+ */
+static uint64_t readField(const char *p, int nBytes, bool bigEndian)
+{
+    const unsigned char *b = (const unsigned char *)p;
+    uint64_t value = 0;
+    if(bigEndian){
+        for(int i=0; i<nBytes; i++){
+            value = (value << 8) | b[i];
+        }
+    }else{
+        for(int i=nBytes-1; i>=0; i--){
+            value = (value << 8) | b[i];
+        }
+    }
+    return value;
+}
+
+GrawReader::GrawReader()
+{
+    fd = -1;
+    mapBegin = NULL;
+    mapSize = 0;
+    skippedFrames = 0;
+    indexed = false;
+}
+
+GrawReader::~GrawReader()
+{
+    close();
+}
+
+/**
+ * Maps a .graw file read-only and indexes all of its CoBo data frames.
+ * Any previously opened file is closed first.
+ * @param fileName path to the .graw file
+ * @param useIndex false to ignore the sidecar index and always scan the file
+ */
+void GrawReader::open(const string &fileName, bool useIndex)
+{
+    close();
+    this->fileName = fileName;
+
+    fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0) throw runtime_error("Can not open CoBo file " + fileName);
+
+    struct stat st;
+    if(fstat(fd, &st) != 0){
+        close();
+        throw runtime_error("Can not stat CoBo file " + fileName);
+    }
+    mapSize = st.st_size;
+
+    if(mapSize > 0){
+        void *p = mmap(NULL, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED){
+            close();
+            throw runtime_error("Can not map CoBo file " + fileName);
+        }
+        mapBegin = (const char *)p;
+        // frames are consumed front to back, let the kernel read ahead
+        madvise(p, mapSize, MADV_SEQUENTIAL);
+    }
+
+    uint64_t offset = 0;
+    if(useIndex) indexed = loadIndex(offset);
+    scanHeaders(offset);
+}
+
+/**
+ * Unmaps the current file and forgets its frame index.
+ */
+void GrawReader::close()
+{
+    if(mapBegin != NULL){
+        munmap((void *)mapBegin, mapSize);
+        mapBegin = NULL;
+    }
+    if(fd >= 0){
+        ::close(fd);
+        fd = -1;
+    }
+    mapSize = 0;
+    skippedFrames = 0;
+    indexed = false;
+    frames.clear();
+    headerDecoded.clear();
+}
+
+bool GrawReader::isOpen() const
+{
+    return mapBegin != NULL;
+}
+
+/**
+ * True if the frame positions were taken from a sidecar index.
+ */
+bool GrawReader::isIndexed() const
+{
+    return indexed;
+}
+
+/**
+ * Number of CoBo data frames (types 1 and 2) found in the file.
+ */
+size_t GrawReader::getFrameCount() const
+{
+    return frames.size();
+}
+
+/**
+ * Number of frames of other types that were skipped while indexing.
+ */
+size_t GrawReader::getSkippedFrameCount() const
+{
+    return skippedFrames;
+}
+
+/**
+ * Size in bytes of the mapped file.
+ */
+size_t GrawReader::getFileSize() const
+{
+    return mapSize;
+}
+
+/**
+ * Drops the mapped pages of the file that lie entirely before a frame. The mapping is
+ * read-only, so a later access to those pages reads them back from the file.
+ * @param indx index of the first data frame still in use
+ */
+void GrawReader::releasePages(size_t indx) const
+{
+    if(mapBegin == NULL || indx >= frames.size()) return;
+    uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    uint64_t releaseSize = frames[indx].offset / pageSize * pageSize;
+    if(releaseSize > 0) madvise((void *)mapBegin, releaseSize, MADV_DONTNEED);
+}
+
+/**
+ * eventIdx of a data frame, known without touching the frame when an index is used.
+ * @param indx index of the data frame, in file order
+ */
+uint32_t GrawReader::getEventIdx(size_t indx) const
+{
+    return frames.at(indx).eventIdx;
+}
+
+/**
+ * @param indx index of the data frame, in file order
+ * @return header summary and pointer to the frame inside the mapping
+ */
+const GrawFrame &GrawReader::getFrame(size_t indx) const
+{
+    GrawFrame &frame = frames.at(indx);
+    if(indexed && !headerDecoded[indx].load(std::memory_order_acquire)){
+        std::lock_guard<std::mutex> lock(headerMutex);
+        if(!headerDecoded[indx].load(std::memory_order_relaxed)){
+            GrawFrame decoded;
+            if(!decodeHeader(frame.offset, decoded) || decoded.size != frame.size || decoded.eventIdx != frame.eventIdx){
+                throw runtime_error("Frame index does not match CoBo file " + fileName);
+            }
+            frame = decoded;
+            headerDecoded[indx].store(1, std::memory_order_release);
+        }
+    }
+    return frame;
+}
+
+/**
+ * Builds an mfm::Frame for the given data frame. The frame bytes are copied,
+ * use getFrame() to access them in place.
+ * @param indx index of the data frame, in file order
+ */
+std::auto_ptr<mfm::Frame> GrawReader::readFrame(size_t indx) const
+{
+    const GrawFrame &frame = getFrame(indx);
+    return mfm::Frame::read(frame.data, frame.data + frame.size);
+}
+
+const string &GrawReader::getFileName() const
+{
+    return fileName;
+}
+
+/**
+ * Decodes the primary header and, for CoBo frames, the standard header of the frame at offset.
+ * @param offset byte offset of the frame in the mapping
+ * @param frame structure receiving the decoded values
+ * @return false if the frame is truncated or its header is not valid
+ */
+bool GrawReader::decodeHeader(uint64_t offset, GrawFrame &frame) const
+{
+    if(offset + mfmPrimaryHeaderSize > mapSize) return false;
+
+    const char *p = mapBegin + offset;
+    uint8_t metaType = (uint8_t)p[0];
+
+    frame.data = p;
+    frame.offset = offset;
+    frame.bigEndian = !(metaType & 0x80);
+    uint32_t blockSize = 1u << (metaType & 0x0F);
+    frame.size = readField(p + mfmFrameSizeOffset, 3, frame.bigEndian) * blockSize;
+    frame.frameType = readField(p + mfmFrameTypeOffset, 2, frame.bigEndian);
+    frame.revision = (uint8_t)p[mfmRevisionOffset];
+
+    if(frame.size < mfmPrimaryHeaderSize || offset + frame.size > mapSize) return false;
+
+    frame.headerSize = 0;
+    frame.itemSize = 0;
+    frame.itemCount = 0;
+    frame.eventTime = 0;
+    frame.eventIdx = 0;
+    frame.coboIdx = 0;
+    frame.asadIdx = 0;
+
+    if(frame.frameType == coboPartialReadout || frame.frameType == coboFullReadout){
+        if(frame.size < coboMinHeaderSize) return false;
+        frame.headerSize = readField(p + coboHeaderSizeOffset, 2, frame.bigEndian) * blockSize;
+        frame.itemSize = readField(p + coboItemSizeOffset, 2, frame.bigEndian);
+        frame.itemCount = readField(p + coboItemCountOffset, 4, frame.bigEndian);
+        frame.eventTime = readField(p + coboEventTimeOffset, 6, frame.bigEndian);
+        frame.eventIdx = readField(p + coboEventIdxOffset, 4, frame.bigEndian);
+        frame.coboIdx = (uint8_t)p[coboCoboIdxOffset];
+        frame.asadIdx = (uint8_t)p[coboAsadIdxOffset];
+
+        if((uint64_t)frame.headerSize + (uint64_t)frame.itemSize*frame.itemCount > frame.size) return false;
+    }
+    return true;
+}
+
+/**
+ * Takes the frame positions from the sidecar index of the file, if there is one.
+ * @param indexedEnd receives the end of the last indexed frame, where scanning resumes
+ * @return false if there is no usable index, nothing is recorded then
+ */
+bool GrawReader::loadIndex(uint64_t &indexedEnd)
+{
+    vector<GrawIndexRecord> records;
+    if(!readGrawIndex(grawIndexFileName(fileName), records)) return false;
+
+    uint64_t end = 0;
+    for(size_t k=0; k<records.size(); k++){
+        const GrawIndexRecord &record = records[k];
+        if(record.offset < end || record.size < mfmPrimaryHeaderSize || record.offset + record.size > mapSize){
+            EB_LOG(LogWarning) << "GrawReader: frame index of " << fileName << " does not match the file, scanning it instead." << endl;
+            frames.clear();
+            headerDecoded.clear();
+            skippedFrames = 0;
+            return false;
+        }
+        end = record.offset + record.size;
+
+        if(record.frameType != coboPartialReadout && record.frameType != coboFullReadout){
+            skippedFrames++;
+            continue;
+        }
+        GrawFrame frame = GrawFrame();
+        frame.data = mapBegin + record.offset;
+        frame.offset = record.offset;
+        frame.size = record.size;
+        frame.frameType = record.frameType;
+        frame.eventIdx = record.eventIdx;
+        frame.coboIdx = record.coboIdx;
+        frame.asadIdx = record.asadIdx;
+        frames.push_back(frame);
+        headerDecoded.emplace_back(0);
+    }
+    indexedEnd = end;
+    return true;
+}
+
+/**
+ * Walks the primary headers from offset to the end of the file and records every CoBo data frame.
+ * Scanning stops at the first truncated or corrupt frame (e.g. a file still being written).
+ * @param offset position of the first frame to scan, 0 or the end of the indexed frames
+ */
+void GrawReader::scanHeaders(uint64_t offset)
+{
+    GrawFrame frame;
+
+    while(offset < mapSize){
+        if(!decodeHeader(offset, frame)){
+            EB_LOG(LogWarning) << "GrawReader: truncated or corrupt frame at byte " << offset
+                 << " of " << fileName << ", ignoring the rest of the file." << endl;
+            break;
+        }
+        if(frame.frameType == coboPartialReadout || frame.frameType == coboFullReadout){
+            frames.push_back(frame);
+            headerDecoded.emplace_back(1);
+        }else{
+            skippedFrames++;
+        }
+        offset += frame.size;
+    }
+}
@@ -0,0 +1,154 @@
+#include "OutputConfiguration.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// ROOT compression algorithm numbers, as in ROOT::RCompressionSetting::EAlgorithm
+#define CompressionNone     0
+#define CompressionZLIB     1
+#define CompressionLZMA     2
+#define CompressionLZ4      4
+#define CompressionZSTD     5
+
+static const char *treeNames[OutputNofTrees] = {"BIFOCAL", "FORCED", "HLED", "TEST"};
+
+OutputConfiguration::OutputConfiguration()
+{
+    splitEvents = 0;
+    splitSize = 0;
+    for(int k=0; k<OutputNofTrees; k++){
+        trees[k].basketSize = 64000;
+        trees[k].splitLevel = 0;
+        trees[k].compressionSettings = -1;
+        trees[k].autoFlush = 0;
+        trees[k].autoSave = 0;
+        trees[k].roiHalo = -1;
+        trees[k].rawPrescale = 1;
+    }
+}
+
+/**
+ * Reads the settings of a configuration file over the current ones.
+ * @return false if the file can not be opened, the settings are then unchanged
+ */
+bool OutputConfiguration::Read(string cfgFile)
+{
+    ifstream cfgFileStream(cfgFile.c_str());
+    if(!cfgFileStream) return false;
+
+    string iline;
+    while(getline(cfgFileStream, iline)){
+        if (iline.substr(0,1) == "*"){
+            ReadLine(iline);
+        }
+    }
+    return true;
+}
+
+void OutputConfiguration::ReadLine(string iline)
+{
+    string i_dump, key, treeName;
+    istringstream lineStream(iline);
+    lineStream >> i_dump >> key;
+
+    // settings of the whole output
+    if(key == "SPLITEVENTS"){
+        lineStream >> splitEvents;
+        return;
+    }
+    if(key == "SPLITSIZE"){
+        double sizeMB = 0.;
+        lineStream >> sizeMB;
+        splitSize = (Long64_t)(sizeMB*1.e6);
+        return;
+    }
+
+    lineStream >> treeName;
+
+    int first = -1;
+    int last = -1;
+    if(treeName == "ALL"){
+        first = 0;
+        last = OutputNofTrees-1;
+    }
+    for(int k=0; k<OutputNofTrees; k++){
+        if(treeName == treeNames[k]) first = last = k;
+    }
+    if(first < 0){
+        cout << "EventBuilder configuration: unknown tree " << treeName << " in: " << iline << endl;
+        return;
+    }
+
+    // the values are read again for every tree of ALL
+    string values;
+    getline(lineStream, values);
+    for(int k=first; k<=last; k++){
+        istringstream valueStream(values);
+        if(key == "BASKETSIZE"){
+            valueStream >> trees[k].basketSize;
+        }else if(key == "SPLITLEVEL"){
+            valueStream >> trees[k].splitLevel;
+        }else if(key == "AUTOFLUSH"){
+            valueStream >> trees[k].autoFlush;
+        }else if(key == "AUTOSAVE"){
+            valueStream >> trees[k].autoSave;
+        }else if(key == "ROISTORAGE"){
+            valueStream >> trees[k].roiHalo;
+        }else if(key == "RAWTRACES"){
+            valueStream >> trees[k].rawPrescale;
+        }else if(key == "COMPRESSION"){
+            string algorithmName;
+            int level = 1;
+            valueStream >> algorithmName >> level;
+            int algorithm = -1;
+            if(algorithmName == "NONE") algorithm = CompressionNone;
+            if(algorithmName == "ZLIB") algorithm = CompressionZLIB;
+            if(algorithmName == "LZMA") algorithm = CompressionLZMA;
+            if(algorithmName == "LZ4")  algorithm = CompressionLZ4;
+            if(algorithmName == "ZSTD") algorithm = CompressionZSTD;
+            if(algorithm < 0){
+                cout << "EventBuilder configuration: unknown compression " << algorithmName << " in: " << iline << endl;
+                return;
+            }
+            trees[k].compressionSettings = (algorithm == CompressionNone) ? 0 : 100*algorithm + level;
+        }else{
+            cout << "EventBuilder configuration: unknown setting " << key << endl;
+            return;
+        }
+    }
+}
+
+const TreeOutputConfig &OutputConfiguration::GetTreeConfig(int treeID) const
+{
+    return trees[treeID];
+}
+
+Long64_t OutputConfiguration::GetSplitEvents() const
+{
+    return splitEvents;
+}
+
+Long64_t OutputConfiguration::GetSplitSize() const
+{
+    return splitSize;
+}
+
+void OutputConfiguration::Print() const
+{
+    if(splitEvents > 0) cout << "Output split every " << splitEvents << " events" << endl;
+    if(splitSize > 0) cout << "Output split every " << splitSize/1.e6 << " MB" << endl;
+    for(int k=0; k<OutputNofTrees; k++){
+        cout << "Output " << treeNames[k] << ": basket " << trees[k].basketSize
+             << " B, split " << trees[k].splitLevel
+             << ", compression " << trees[k].compressionSettings
+             << ", autoflush " << trees[k].autoFlush
+             << ", autosave " << trees[k].autoSave;
+        if(trees[k].roiHalo >= 0) cout << ", ROI traces only (halo " << trees[k].roiHalo << ")";
+        if(trees[k].rawPrescale == 0) cout << ", no raw events with extraction";
+        if(trees[k].rawPrescale > 1) cout << ", 1 in " << trees[k].rawPrescale << " raw events with extraction";
+        cout << endl;
+    }
+}
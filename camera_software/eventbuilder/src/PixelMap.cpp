@@ -1,6 +1,8 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include "PixelMap.h"
 using namespace std;
  
@@ -13,9 +15,9 @@ using namespace std;
  * @param *channelID one of the return parameters
 **/
 void pixelMapDecoder(int **pixelMapArray, uint16_t sipmID, uint16_t *asadID, uint16_t *agetID, uint16_t *channelID){
-	int numSipm = 256;
+	int numSipm = 512;
 	// Check if sipmID is out of bounds [0-511]
-	if((sipmID<0)||(sipmID>numSipm)){
+	if((sipmID<0)||(sipmID>=numSipm)){
 		cout << "sipmID is out of bounds! Must be in range [0-511]." << endl;
 		*asadID = *agetID = *channelID = -1;
 		return;	
@@ -82,13 +84,14 @@ void pixelMapEncoder(int **pixelMapArray, uint16_t *sipmID, uint16_t asadID, uin
  * Function which opens a csv file and allocates the data onto the heap as int values.
  * Assumming format of the csv is the following:
  * First row is a header row.
- * 512 rows and 4 columns (excluding header row).
+ * Up to 512 rows and 4 columns (excluding header row), 256 rows per AsAd.
  * Columns are in order sipmID, asadID, agetID, channelID.
+ * Rows missing from the file (e.g. a single AsAd map) are filled with -1.
  * @param pixelMapCSV string containing the file location/name of the csv file
  * @return a 2D integer array represented as a pointer to pointers to ints.
  */
 int** openPixelMap(string pixelMapCSV){
-	const int numRows = 256; //number of rows in csv (excluding header)
+	const int numRows = 512; //maximum number of rows in csv (excluding header)
 	const int numCols = 4; //number of collums in csv
 
 	// create input file stream
@@ -111,8 +114,13 @@ int** openPixelMap(string pixelMapCSV){
 
 	// assign csv values to allocated memmory
 	for(int i=0; i<numRows; i++){
-		//get next row
-		getline(pixelMap, line);
+		//get next row, rows past the end of the file are marked unused
+		if(!getline(pixelMap, line) || line.find(",") == string::npos){
+			for(int j=0; j<numCols; j++){
+				pixelMapArray[i][j] = -1;
+			}
+			continue;
+		}
 		for(int j=0; j<numCols; j++){
 			//store value
 			pixelMapArray[i][j] = stoi(line.substr(0,line.find(",")));
@@ -132,13 +140,64 @@ int** openPixelMap(string pixelMapCSV){
  * @param **pixelMapArray variables whose data will be deallocated, previously return parameter from openPixelMap.
  */
 void closePixelMap(int **pixelMapArray){
-	const int numRows = 256; //number of rows in csv (excluding header)
+	const int numRows = 512; //number of rows allocated by openPixelMap
 	for(int i = 0; i < numRows; ++i) {
     	delete [] pixelMapArray[i];
 	}
 	delete [] pixelMapArray;
 }
 
+/**
+ * Builds the dense lookup tables from the table returned by openPixelMap, and checks the csv on the way.
+ * Every listed row must give a valid sipmID, asadID, agetID and non FPN channelID, each pixel and each
+ * channel may only be listed once, and rows must follow the AsAd, AGET, channel order that
+ * pixelMapEncoder relies on. A runtime_error naming the first bad row is thrown otherwise.
+ * @param **pixelMapArray table returned by openPixelMap
+ * @param *lut tables to fill
+ */
+void buildPixelMapLUT(int **pixelMapArray, PixelMapLUT *lut){
+	for(int asad=0; asad<PixelMapNofAsads; asad++){
+		for(int aget=0; aget<PixelMapNofAgets; aget++){
+			for(int chan=0; chan<PixelMapChannelsPerAget; chan++){
+				bool fpn = (chan==11)||(chan==22)||(chan==45)||(chan==56);
+				lut->sipmID[asad][aget][chan] = fpn ? PixelMapFPN : PixelMapUnmapped;
+			}
+		}
+	}
+	for(int sipm=0; sipm<PixelMapNofSipms; sipm++){
+		lut->asadID[sipm] = lut->agetID[sipm] = lut->channelID[sipm] = -1;
+		lut->musicID[sipm] = -1;
+	}
+
+	for(int row=0; row<PixelMapNofSipms; row++){
+		int sipm = pixelMapArray[row][0];
+		int asad = pixelMapArray[row][1];
+		int aget = pixelMapArray[row][2];
+		int chan = pixelMapArray[row][3];
+		// rows missing from the csv
+		if(sipm == -1) continue;
+
+		ostringstream error;
+		error << "Pixel map row " << row+1 << " (" << sipm << "," << asad << "," << aget << "," << chan << "): ";
+		if((sipm<0)||(sipm>=PixelMapNofSipms)||(asad<0)||(asad>=PixelMapNofAsads)||(aget<0)||(aget>=PixelMapNofAgets)||(chan<0)||(chan>=PixelMapChannelsPerAget)){
+			throw runtime_error(error.str() + "value out of range.");
+		}
+		if(lut->sipmID[asad][aget][chan] == PixelMapFPN) throw runtime_error(error.str() + "FPN channel.");
+		if(lut->sipmID[asad][aget][chan] != PixelMapUnmapped) throw runtime_error(error.str() + "channel listed twice.");
+		if(lut->asadID[sipm] != -1) throw runtime_error(error.str() + "sipmID listed twice.");
+
+		uint16_t encoded;
+		pixelMapEncoder(pixelMapArray, &encoded, asad, aget, chan);
+		if(encoded != sipm) throw runtime_error(error.str() + "row is not in AsAd, AGET, channel order.");
+
+		lut->sipmID[asad][aget][chan] = sipm;
+		lut->asadID[sipm] = asad;
+		lut->agetID[sipm] = aget;
+		lut->channelID[sipm] = chan;
+		lut->musicID[sipm] = sipm/PixelMapSipmsPerMusic;
+	}
+}
+
 int myMain(int argc, char *argv[]){
 	string fileName = argv[1];
 	uint16_t sipmID, asadID, agetID, channelID;
@@ -0,0 +1,76 @@
+#include "PulseExtractor.h"
+
+#include <cmath>
+
+#include <PulseBatch.h>
+
+using namespace std;
+
+/**
+ * @param cfgFile ExACT.cfg, read by ReadConfiguration which stops the program if it is missing
+ */
+PulseExtractor::PulseExtractor(string cfgFile)
+{
+    readConf = new ReadConfiguration(cfgFile);
+    for(int k=0; k<ExtractorNofTrees; k++) extractedTree[k] = NULL;
+}
+
+PulseExtractor::~PulseExtractor()
+{
+    for(int k=0; k<ExtractorNofTrees; k++) delete extractedTree[k];
+    delete readConf;
+}
+
+int PulseExtractor::GetNofPixels() const
+{
+    return readConf->nPixelsCamera;
+}
+
+/**
+ * Extracts pedestal, pedestal RMS, amplitude, peak time and charge of every camera pixel.
+ * Pixels the event does not hold get the values of a trace of zeros, as in ExACT.
+ * @param pixels receives one ExtractedData per camera pixel, values not extracted are 0
+ */
+void PulseExtractor::Extract(Event *event, vector<ExtractedData> &pixels) const
+{
+    // working buffers of the batch are per call, Extract() runs on several workers
+    PulseBatch batch(readConf);
+    batch.Extract(event);
+    pixels.assign(readConf->nPixelsCamera, ExtractedData());
+    for(int j=0; j<readConf->nPixelsCamera; j++){
+        if(readConf->amplitudeExtraction){
+            pixels[j].SetAmplitude(batch.GetAmplitude(j));
+            pixels[j].SetTimePeak(batch.GetTimePeak(j));
+        }
+        if(readConf->chargeExtraction){
+            pixels[j].SetCharge(batch.GetCharge(j));
+        }
+        pixels[j].SetPedestal(round(batch.GetPedestal(j)));
+        pixels[j].SetPedestalRMS(batch.GetPedestalRMS(j));
+    }
+}
+
+/**
+ * Creates the branches of an extracted tree, in the layout ExACT writes with the same ExACT.cfg.
+ * @param withTriggerRegion adds the TriggerRegion branch, for the BiFocal and Test trees
+ */
+void PulseExtractor::Branch(TTree *tree, int treeID, bool withTriggerRegion)
+{
+    delete extractedTree[treeID];
+    extractedTree[treeID] = new IExtractedTree(tree, readConf->nPixelsCamera, readConf->columnarExtracted, withTriggerRegion);
+}
+
+/**
+ * Fills one entry of the extracted tree set up by Branch() for treeID.
+ * @param pixels values from Extract() for the event
+ */
+void PulseExtractor::Fill(int treeID, Event *event, vector<ExtractedData> &pixels)
+{
+    IExtractedTree *extracted = extractedTree[treeID];
+    for(int i=0; i<extracted->GetNPixels() && i<(int)pixels.size(); i++){
+        extracted->SetPixel(i, &pixels[i]);
+    }
+    extracted->SetTriggerTime(event->GetTBTime());
+    extracted->SetTriggerRegion(event->GetROIPixelID(), event->GetROIMusicID());
+    extracted->Fill();
+}
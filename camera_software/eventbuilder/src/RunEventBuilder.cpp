@@ -1,18 +1,75 @@
 #include "EventBuilder.h"
+#include "RunWatcher.h"
+#include "BatchRunner.h"
 
 int main(int argc, char* argv[]){
 	
 	
 	std::string coboFormats = argv[1];
 //	cout<<coboFormats<<endl;
-	std::string filename_0 = argv[2];
+	// watch mode: EventBuilder formats --watch inputDir outDir [options]
+	bool watch = (argc > 2 && std::string(argv[2]) == "--watch");
+	// batch mode: EventBuilder formats --batch runList|inputDir outDir [options]
+	bool batch = (argc > 2 && std::string(argv[2]) == "--batch");
+	int firstArg = (watch || batch) ? 3 : 2;
+	std::string filename_0 = argv[firstArg];
 	//std::string filename_1 = argv[3];
-	std::string filename_2 = argv[3];
+	std::string filename_2 = (watch || batch) ? "" : argv[firstArg+1];
 //	cout<<"H"<<endl;
-	std::string outDir = argv[4];
+	std::string outDir = (watch || batch) ? argv[firstArg+1] : argv[firstArg+2];
 //	cout<<"E"<<endl;
 	EventBuilder eB(coboFormats);
+	RunWatcher watcher(eB, filename_0, outDir);
+	BatchRunner batchRunner(eB, filename_0, outDir);
 //	cout<<"R"<<endl;
+
+	// optional flags after the positional arguments
+	for(int i=5; i<argc; i++){
+		std::string option = argv[i];
+		if(option == "--generic-decoder"){
+			eB.SetFastDecoding(false);
+		}else if(option == "--threads" && i+1 < argc){
+			eB.SetThreads(atoi(argv[++i]));
+		}else if(option == "--log" && i+1 < argc){
+			RunLog::SetLevel(RunLog::ParseLevel(argv[++i]));
+		}else if(option == "--stats" && i+1 < argc){
+			eB.SetStatsFile(argv[++i]);
+		}else if(option == "--stats-interval" && i+1 < argc){
+			eB.SetStatsInterval(atoi(argv[++i]));
+		}else if(option == "--config" && i+1 < argc){
+			if(!eB.ReadOutputConfig(argv[++i])) cout << "Can not read configuration " << argv[i] << endl;
+		}else if(option == "--extract" && i+1 < argc){
+			if(!eB.SetPulseExtraction(argv[++i])) cout << "Can not read ExACT configuration " << argv[i] << endl;
+		}else if(watch && option == "--archive" && i+1 < argc){
+			watcher.SetArchiveDirectory(argv[++i]);
+		}else if(watch && option == "--settle" && i+1 < argc){
+			watcher.SetSettleTime(atoi(argv[++i]));
+		}else if(batch && option == "--jobs" && i+1 < argc){
+			batchRunner.SetJobs(atoi(argv[++i]));
+		}else if(batch && option == "--memory" && i+1 < argc){
+			batchRunner.SetMemoryLimit(atol(argv[++i]));
+		}else{
+			cout << "Unknown option " << option << endl;
+		}
+	}
+
+	if(watch){
+		try{
+			watcher.Run();
+		}catch(const std::exception & e){
+			cout << e.what() << endl;
+			return 1;
+		}
+		return 0;
+	}
+	if(batch){
+		try{
+			return batchRunner.Run() > 0 ? 1 : 0;
+		}catch(const std::exception & e){
+			cout << e.what() << endl;
+			return 1;
+		}
+	}
 	eB.mainFlow(filename_0,  filename_2, outDir);
 
 	return 0;
@@ -0,0 +1,96 @@
+#include "RunFiles.h"
+
+#include <dirent.h>
+#include <stdio.h>
+
+#include <fstream>
+
+using namespace std;
+
+bool endsWith(const string &name, const string &suffix)
+{
+    return name.size() >= suffix.size() && name.compare(name.size()-suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool isAsAd0File(const string &name)
+{
+    return endsWith(name, ".graw") && name.find("AsAd0_") != string::npos;
+}
+
+bool isTBFile(const string &name)
+{
+    return endsWith(name, ".bin") && name.find("TB") != string::npos;
+}
+
+/**
+ * @param name AsAd0 file name
+ * @param asadIdx AsAd index
+ * @return name of the file of the same run for AsAd asadIdx
+ */
+string asadFileName(const string &name, int asadIdx)
+{
+    string sibling = name;
+    size_t pos = sibling.find("AsAd0_");
+    sibling[pos+4] = '0' + asadIdx;
+    return sibling;
+}
+
+string stripExtension(const string &name)
+{
+    size_t dot = name.find_last_of('.');
+    size_t slash = name.find_last_of('/');
+    if(dot == string::npos || (slash != string::npos && dot < slash)) return name;
+    return name.substr(0, dot);
+}
+
+string stripDirectory(const string &path)
+{
+    return path.substr(path.find_last_of('/')+1);
+}
+
+/**
+ * Collects the input files listed in the .done markers of a directory.
+ * @param inputFiles receives the raw file names, without directory
+ */
+void readRunMarkers(const string &outDir, set<string> &inputFiles)
+{
+    DIR *dir = opendir(outDir.c_str());
+    if(dir == NULL) return;
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL){
+        string name = entry->d_name;
+        if(!endsWith(name, ".done")) continue;
+        ifstream marker((outDir + "/" + name).c_str());
+        string key, value;
+        while(marker >> key >> value){
+            if(key == "input") inputFiles.insert(value);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * Writes <outDir>/<AsAd0 file name>.done for a built run.
+ * @param asadFiles raw files of the AsAds in AsAd order, names without directory
+ * @param tbName trigger board file name, without directory
+ * @param outputFiles ROOT files of the run
+ * @return false if the marker could not be written
+ */
+bool writeRunMarker(const string &outDir, const vector<string> &asadFiles, const string &tbName,
+                    const vector<string> &outputFiles)
+{
+    string markerName = outDir + "/" + stripExtension(asadFiles[0]) + ".done";
+    string tmpName = markerName + ".tmp";
+    {
+        ofstream marker(tmpName.c_str());
+        for(size_t k=0; k<asadFiles.size(); k++){
+            marker << "input " << asadFiles[k] << endl;
+        }
+        marker << "input " << tbName << endl;
+        for(size_t k=0; k<outputFiles.size(); k++){
+            marker << "output " << outputFiles[k] << endl;
+        }
+        if(!marker) return false;
+    }
+    return rename(tmpName.c_str(), markerName.c_str()) == 0;
+}
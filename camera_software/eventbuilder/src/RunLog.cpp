@@ -0,0 +1,33 @@
+#include "RunLog.h"
+
+#include <stdlib.h>
+
+using namespace std;
+
+int RunLog::currentLevel = LogInfo;
+
+void RunLog::SetLevel(int level)
+{
+    currentLevel = level;
+}
+
+int RunLog::GetLevel()
+{
+    return currentLevel;
+}
+
+/**
+ * @param name error, warning, info, event, debug, or the level number
+ * @return the level, LogInfo if the name is not known
+ */
+int RunLog::ParseLevel(const string &name)
+{
+    int level = LogInfo;
+    if(name == "error") level = LogError;
+    else if(name == "warning") level = LogWarning;
+    else if(name == "info") level = LogInfo;
+    else if(name == "event") level = LogEvent;
+    else if(name == "debug") level = LogDebug;
+    else if(!name.empty() && name[0] >= '0' && name[0] <= '9') level = atoi(name.c_str());
+    return level;
+}
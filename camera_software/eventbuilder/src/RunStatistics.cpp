@@ -0,0 +1,116 @@
+#include "RunStatistics.h"
+
+#include <time.h>
+
+using namespace std;
+
+static const char *statsTreeNames[StatsNofTrees] = {"BiFocal", "Forced", "HLED", "Test"};
+
+/**
+ * Writes a string as a JSON string literal.
+ */
+static void writeJSONString(ostream &out, const string &value)
+{
+    out << '"';
+    for(size_t k=0; k<value.size(); k++){
+        char c = value[k];
+        if(c == '"' || c == '\\') out << '\\' << c;
+        else if((unsigned char)c < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+static void writeJSONList(ostream &out, const vector<string> &values)
+{
+    out << '[';
+    for(size_t k=0; k<values.size(); k++){
+        if(k > 0) out << ',';
+        writeJSONString(out, values[k]);
+    }
+    out << ']';
+}
+
+RunStatistics::RunStatistics()
+{
+    Start("");
+}
+
+/**
+ * Clears the counters and starts the run clock.
+ */
+void RunStatistics::Start(const string &name)
+{
+    runName = name;
+    inputFiles.clear();
+    outputFiles.clear();
+    start = chrono::steady_clock::now();
+    events = 0;
+    for(int k=0; k<StatsNofTrees; k++) treeEvents[k] = 0;
+    failedEvents = 0;
+    frames = 0;
+    missingFragments = 0;
+    outOfOrderFrames = 0;
+    repeatedEventIdx = 0;
+    tbOrphans = 0;
+    coboOrphans = 0;
+    inputBytes = 0;
+    outputBytes = 0;
+    outputRawBytes = 0;
+    scanSeconds = 0.;
+    joinSeconds = 0.;
+    decodeSeconds = 0.;
+    writeSeconds = 0.;
+}
+
+double RunStatistics::ElapsedSeconds() const
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Writes the statistics as a single line JSON object.
+ * @param recordType "progress" for periodic records, "run" for the end of run record
+ */
+void RunStatistics::WriteJSON(ostream &out, const char *recordType) const
+{
+    double elapsed = ElapsedSeconds();
+    double rateScale = elapsed > 0 ? 1./elapsed : 0.;
+
+    out << "{\"record\":";
+    writeJSONString(out, recordType);
+    out << ",\"run\":";
+    writeJSONString(out, runName);
+    out << ",\"unixTime\":" << (long)time(NULL);
+    out << ",\"inputFiles\":";
+    writeJSONList(out, inputFiles);
+    out << ",\"outputFiles\":";
+    writeJSONList(out, outputFiles);
+
+    out << ",\"events\":" << events << ",\"eventsPerTree\":{";
+    for(int k=0; k<StatsNofTrees; k++){
+        if(k > 0) out << ',';
+        out << '"' << statsTreeNames[k] << "\":" << treeEvents[k];
+    }
+    out << "},\"failedEvents\":" << failedEvents
+        << ",\"frames\":" << frames
+        << ",\"mismatches\":{\"missingFragments\":" << missingFragments
+        << ",\"outOfOrderFrames\":" << outOfOrderFrames
+        << ",\"repeatedEventIdx\":" << repeatedEventIdx
+        << ",\"tbOrphans\":" << tbOrphans
+        << ",\"coboOrphans\":" << coboOrphans << '}';
+
+    out << ",\"inputMB\":" << inputBytes/1.e6
+        << ",\"outputMB\":" << outputBytes/1.e6
+        << ",\"outputRawMB\":" << outputRawBytes/1.e6
+        << ",\"wallSeconds\":" << elapsed
+        << ",\"scanSeconds\":" << scanSeconds
+        << ",\"joinSeconds\":" << joinSeconds
+        << ",\"decodeSeconds\":" << decodeSeconds
+        << ",\"writeSeconds\":" << writeSeconds
+        << ",\"eventsPerSecond\":" << events*rateScale
+        << ",\"framesPerSecond\":" << frames*rateScale
+        << ",\"inputMBPerSecond\":" << inputBytes/1.e6*rateScale
+        << ",\"outputMBPerSecond\":" << outputBytes/1.e6*rateScale
+        << '}' << endl;
+}
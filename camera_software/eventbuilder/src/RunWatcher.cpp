@@ -0,0 +1,255 @@
+#include "RunWatcher.h"
+#include "EventBuilder.h"
+#include "RunFiles.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void stopHandler(int)
+{
+    stopRequested = 1;
+}
+
+RunWatcher::RunWatcher(EventBuilder &builder, string inputDir, string outDir)
+    : builder(builder), inputDir(inputDir), outDir(outDir), settleTime(5)
+{
+}
+
+/**
+ * Raw files are moved to dir once their run has been built. By default they stay in place.
+ */
+void RunWatcher::SetArchiveDirectory(string dir)
+{
+    archiveDir = dir;
+}
+
+/**
+ * @param seconds time a file must stay untouched before it is considered complete
+ */
+void RunWatcher::SetSettleTime(int seconds)
+{
+    settleTime = seconds;
+}
+
+/**
+ * Requests Run() to return once the run in progress has been written.
+ * Only sets a flag, so it can be called from a signal handler.
+ */
+void RunWatcher::Stop()
+{
+    stopRequested = 1;
+}
+
+/**
+ * Watches the input directory and builds runs until Stop() is called.
+ */
+void RunWatcher::Run()
+{
+#ifdef __linux__
+    signal(SIGINT, stopHandler);
+    signal(SIGTERM, stopHandler);
+
+    int fd = inotify_init();
+    if(fd < 0) throw runtime_error("Can not initialise inotify");
+    // watch before listing the directory, so that no file closed in between is missed
+    if(inotify_add_watch(fd, inputDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+        ::close(fd);
+        throw runtime_error("Can not watch directory " + inputDir);
+    }
+    cout << "Watching " << inputDir << " for new runs" << endl;
+
+    ReadMarkers();
+    ScanExisting();
+
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while(!stopRequested){
+        // wake up every second to build runs whose files have settled
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int nReady = poll(&pfd, 1, 1000);
+        if(nReady < 0 && errno != EINTR){
+            ::close(fd);
+            throw runtime_error("Error waiting for inotify events");
+        }
+        if(nReady > 0){
+            ssize_t len = read(fd, buffer, sizeof(buffer));
+            time_t now = time(NULL);
+            for(char *p = buffer; len > 0 && p < buffer + len; ){
+                const struct inotify_event *event = (const struct inotify_event *)p;
+                if(event->mask & IN_Q_OVERFLOW){
+                    ScanExisting();
+                }else if(event->len > 0){
+                    FileClosed(event->name, now);
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        ProcessReadyRuns();
+    }
+    ::close(fd);
+    cout << "Stopped watching " << inputDir << endl;
+#else
+    throw runtime_error("Watch mode needs inotify, it is only available on Linux");
+#endif
+}
+
+/**
+ * Collects the input files listed in the .done markers of the output directory.
+ */
+void RunWatcher::ReadMarkers()
+{
+    readRunMarkers(outDir, processedFiles);
+}
+
+/**
+ * Registers the raw files already in the input directory, in name order, with their
+ * modification time as close time.
+ */
+void RunWatcher::ScanExisting()
+{
+    DIR *dir = opendir(inputDir.c_str());
+    if(dir == NULL) throw runtime_error("Can not open directory " + inputDir);
+    vector<string> names;
+    struct dirent *entry;
+    while((entry = readdir(dir)) != NULL){
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    sort(names.begin(), names.end());
+    for(size_t k=0; k<names.size(); k++){
+        struct stat st;
+        if(stat((inputDir + "/" + names[k]).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        FileClosed(names[k], st.st_mtime);
+    }
+}
+
+/**
+ * Records that a writer closed a file. The first time an AsAd0 or TB file is seen it is
+ * queued for pairing.
+ */
+void RunWatcher::FileClosed(const string &name, time_t closeTime)
+{
+    if(!endsWith(name, ".graw") && !endsWith(name, ".bin")) return;
+    if(processedFiles.count(name) > 0) return;
+
+    bool firstSeen = (closeTimes.count(name) == 0);
+    if(firstSeen || closeTimes[name] < closeTime) closeTimes[name] = closeTime;
+    if(!firstSeen) return;
+
+    if(isAsAd0File(name)) pendingGraw.push_back(name);
+    if(isTBFile(name)) pendingTB.push_back(name);
+}
+
+bool RunWatcher::FileSettled(const string &name, time_t now)
+{
+    map<string, time_t>::const_iterator it = closeTimes.find(name);
+    return it != closeTimes.end() && now - it->second >= settleTime;
+}
+
+/**
+ * @param grawName AsAd0 file of the run
+ * @param asadFiles receives the files of all AsAds of the run, in AsAd order
+ * @return true if every file of the run exists and has settled
+ */
+bool RunWatcher::RunReady(const string &grawName, time_t now, vector<string> &asadFiles)
+{
+    asadFiles.clear();
+    if(!FileSettled(grawName, now)) return false;
+    asadFiles.push_back(grawName);
+
+    for(int asadIdx=1; asadIdx<MaxNofAsads; asadIdx++){
+        string sibling = asadFileName(grawName, asadIdx);
+        struct stat st;
+        if(stat((inputDir + "/" + sibling).c_str(), &st) != 0) continue;
+        if(closeTimes.count(sibling) == 0) FileClosed(sibling, st.st_mtime);
+        if(!FileSettled(sibling, now)) return false;
+        asadFiles.push_back(sibling);
+    }
+    return true;
+}
+
+/**
+ * Builds the runs at the front of the queues while their files are complete.
+ */
+void RunWatcher::ProcessReadyRuns()
+{
+    vector<string> asadFiles;
+    while(!stopRequested && !pendingGraw.empty() && !pendingTB.empty()){
+        time_t now = time(NULL);
+        if(!RunReady(pendingGraw.front(), now, asadFiles) || !FileSettled(pendingTB.front(), now)) return;
+
+        string tbName = pendingTB.front();
+        pendingGraw.pop_front();
+        pendingTB.pop_front();
+
+        string prefixes;
+        for(size_t k=0; k<asadFiles.size(); k++){
+            if(k > 0) prefixes += ",";
+            prefixes += inputDir + "/" + stripExtension(asadFiles[k]);
+        }
+        cout << "-----------------------------------------" << endl;
+        cout << "Building run " << asadFiles[0] << " with " << tbName << endl;
+
+        try{
+            builder.mainFlow(prefixes, inputDir + "/" + stripExtension(tbName), outDir);
+        }catch(const std::exception & e){
+            cout << "Run " << asadFiles[0] << " failed: " << e.what() << endl;
+            continue;
+        }
+
+        WriteMarker(asadFiles, tbName);
+        for(size_t k=0; k<asadFiles.size(); k++){
+            Archive(asadFiles[k]);
+        }
+        Archive(tbName);
+    }
+}
+
+/**
+ * Writes <outDir>/<AsAd0 file name>.done, listing the input files and the ROOT files of the run.
+ * The marker is written under a temporary name and renamed, so it only appears complete.
+ */
+void RunWatcher::WriteMarker(const vector<string> &asadFiles, const string &tbName)
+{
+    if(!writeRunMarker(outDir, asadFiles, tbName, builder.GetOutputFiles())){
+        cout << "Can not write marker for " << asadFiles[0] << endl;
+    }
+    for(size_t k=0; k<asadFiles.size(); k++){
+        processedFiles.insert(asadFiles[k]);
+    }
+    processedFiles.insert(tbName);
+}
+
+/**
+ * Moves a built raw file, and its frame index, to the archive directory.
+ */
+void RunWatcher::Archive(const string &name)
+{
+    closeTimes.erase(name);
+    if(archiveDir.empty()) return;
+
+    vector<string> names(1, name);
+    if(endsWith(name, ".graw")) names.push_back(grawIndexFileName(name));
+    for(size_t k=0; k<names.size(); k++){
+        string from = inputDir + "/" + names[k];
+        string to = archiveDir + "/" + names[k];
+        if(rename(from.c_str(), to.c_str()) != 0 && k == 0){
+            cout << "Can not move " << from << " to " << archiveDir << endl;
+        }
+    }
+}
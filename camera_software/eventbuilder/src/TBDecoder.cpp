@@ -1,38 +1,92 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <fstream>
 #include <iostream>
 #include "TBDecoder.h"
+#include "RunLog.h"
 using namespace std;
 
 class TBDecoder {
     private:    
     //INSTANCE VARIABLES
-    EventData* pEvents; //pointer to EventData array
+    const EventData* pEvents; //records of the file, mapped read-only and decoded on access
     int N; //number of events in file
+    void* mapBegin; //start of the file mapping, NULL if nothing is mapped
+    size_t mapSize; //size of the file mapping in bytes
 
     //--------------------------------------------------------------------------
     public:    
     //CONSTRUCTORS
+    /**
+     * Maps the file, the number of events is taken from the file size.
+     * Records are decoded when they are accessed, so construction costs the
+     * same for any file size.
+     * @param fileName trigger board data file
+     */
+    TBDecoder(const char *fileName) {
+        mapFile(fileName);
+    }
+
+    /**
+     * Maps the file and uses at most its first N records.
+     * @param N maximum number of events
+     * @param fileName trigger board data file
+     */
     TBDecoder(int N, const char *fileName) { 
-        //set number of events
-        this->N = N;
-        //allocate memmory and return pointer
-        pEvents = new EventData[N];
-        //check succesful mem allocation
-        //if (pEvents == NULL) exit;
-        
-        //read input file
-        ifstream infile;
-        infile.open(fileName, ios::binary | ios::in);
+        mapFile(fileName);
+        if(N < this->N) this->N = N;
+    }
+
+    ~TBDecoder() {
+        removeData();
+    }
+
+    //--------------------------------------------------------------------------
+    private:
+    /**
+     * Maps the whole file read-only. A trailing partial record is ignored.
+     * @param fileName trigger board data file
+     */
+    void mapFile(const char *fileName) {
+        pEvents = NULL;
+        mapBegin = NULL;
+        mapSize = 0;
+        N = 0;
+
+        int fd = open(fileName, O_RDONLY);
         //check file opened successful
-        if(!infile.is_open()) {
-            cout << "Cant open file" << endl;
-            infile.close();
-        } else {
-            //read data into allocated memmory
-            infile.read((char*)pEvents, N*sizeof(EventData));
-            infile.close();
+        if(fd < 0) {
+            EB_LOG(LogError) << "Cant open file" << endl;
+            return;
+        }
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(EventData)) {
+            void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p != MAP_FAILED) {
+                mapBegin = p;
+                mapSize = st.st_size;
+                pEvents = (const EventData*)p;
+                N = (int)(mapSize / sizeof(EventData));
+                // records are consumed front to back, let the kernel read ahead
+                madvise(p, mapSize, MADV_SEQUENTIAL);
+            } else {
+                EB_LOG(LogError) << "Cant map file" << endl;
+            }
         }
-        unshuffleData(); //reorganizes data from 3412 to 1234, function found bellow.
+        // the mapping stays valid once the descriptor is closed
+        close(fd);
+    }
+
+    //--------------------------------------------------------------------------
+    public:
+    /**
+     * Number of records held by this object.
+     * @return number of events
+     */
+    int getNofEvents(){
+        return N;
     }
     
     //--------------------------------------------------------------------------
@@ -55,14 +109,7 @@ class TBDecoder {
      * @return clock count
      */
     uint64_t getClockCount(uint32_t indx){
-    	Break4Bytes tempUnion;
-		tempUnion.fullWord = getWord3(indx);
-		uint64_t temp64 = tempUnion.quartWord[msbClockByte];
-		temp64 = (temp64<<fullWordSizeBits);
-		temp64 |= pEvents[indx].word2;
-
-        //cout<<temp64<<endl;
-		return temp64;
+		return clockCount(pEvents[indx]);
     }
 
     /**
@@ -80,11 +127,7 @@ class TBDecoder {
 	 * 32: LED
 	 */
 	uint8_t getTriggerSource(uint32_t indx){
-		Break4Bytes temp;
-		temp.fullWord = getWord3(indx);
-		uint8_t trigger = temp.quartWord[triggerSourceByte];
-		trigger = (trigger >> 2);
-		return trigger;
+		return triggerSource(pEvents[indx]);
 	}
 
 	/**
@@ -139,55 +182,41 @@ class TBDecoder {
 		bitNum += recursiveHelper(eithNumSdbBits, sdbBits);
 
 		return bitNum;*/
-        // Check to see if the event is bifocal
-    if(!(getTriggerSource(index)&bifocalTrigger||getTriggerSource(index)&discTestTrigger)){
-        //std::cout << "This event is not bifocal." << std::endl;
-        return -1;
-    }
-
-    //local variables
-    bool found_pair = false;
-    uint32_t bitNum = 0;                    //records the triggered bit position. starts from zero.
-    uint64_t sdbBits = getSdb(index);   //store stretched disciminator bits in local variable
+        uint32_t bitNum = activeSdb(getTriggerSource(index), getSdb(index));
+        if(bitNum == (uint32_t)-1 && isBifocalOrTest(getTriggerSource(index))){
+            EB_LOG(LogEvent) << "Disc. bits are all zero. Is the event file bad?" << std::endl;
+        }
+        return bitNum;
+	}
 
-    //if there are no active bits return -1;
-    if(!sdbBits){
-        std::cout << "Disc. bits are all zero. Is the event file bad?" << std::endl;
-        return -1;
-    }
+    /**
+     * Decodes a block of consecutive records into one array per field, for callers
+     * that walk the file in order. Every field is decoded in its own branch-free loop
+     * over the records, which the compiler vectorises. Any output may be NULL to skip it.
+     * @param first index of the first record
+     * @param count number of records, clipped to the end of the file
+     * @return number of records decoded
+     */
+    uint32_t decodeRecords(uint32_t first, uint32_t count, uint32_t *eventNumbers, uint64_t *clockCounts, uint8_t *triggerSources, uint32_t *activeSdbs){
+        if(first >= (uint32_t)N) return 0;
+        if(count > (uint32_t)N - first) count = (uint32_t)N - first;
+        const EventData *records = pEvents + first;
 
-    // Find the bit#i, and check to see if it is non-zero and no bifocal pair has been found yet.
-    // If bit#i is non-zero, then check bit#i+1, and if that is non-zero as well, then the pair is found. Retrun.
-    // If the bit#i+1 is zero, then keep bit#i as temporary triggered bit and continue the for loop.
-    // If by the end of for loop, no pair has been found, then temporary bit will be returned. There is no other scenario here!
-    for(int i=0; i<64; i++)
-    {
-        if(((sdbBits >> i) & 0x01) && (!found_pair))
-        {
-            //std::cout<<"Music: "<<i<<" triggered"<<endl;
-            if((sdbBits >> i+1) & 0x01)
-            {
-                //std::cout << "Found a bifocal pair at Music IDs: " << i << " and " << i+1 << std::endl;
-                bitNum = i;
-                found_pair = true;
-            }else{
-                //std::cout << "Disc. bit#" << i << " was 1, but bit#" << i+1 << " was zero!" << std::endl;
-                //std::cout << "Keeping bit#" << i << " as the temporary triggered bit." << std::endl;
-                bitNum = i;
-            }
+        if(eventNumbers){
+            for(uint32_t k=0; k<count; k++) eventNumbers[k] = records[k].eventNumber;
+        }
+        if(clockCounts){
+            for(uint32_t k=0; k<count; k++) clockCounts[k] = clockCount(records[k]);
         }
+        if(triggerSources){
+            for(uint32_t k=0; k<count; k++) triggerSources[k] = triggerSource(records[k]);
+        }
+        if(activeSdbs){
+            for(uint32_t k=0; k<count; k++) activeSdbs[k] = activeSdb(triggerSource(records[k]), unshuffleSdb(records[k]));
+        }
+        return count;
     }
 
-    /*if(found_pair){
-        std::cout << "Found a pair. Returning bit#" << bitNum << " as the final triggered bit." << std::endl;
-    }else{
-        std::cout << "Did not find a pair. Returning bit#" << bitNum << " as the final triggered bit." << std::endl;
-    }*/
-
-    return bitNum;
-
-	}
-
 	//--------------------------------------------------------------------------
     private:
     //GETTERS
@@ -198,7 +227,7 @@ class TBDecoder {
 		return pEvents[indx].word3;
 	}
     uint64_t getSdb(uint32_t indx){
-		return combineSdb(indx);
+		return unshuffleSdb(pEvents[indx]);
 	}
     uint32_t getSdbLow(uint32_t indx){
         return pEvents[indx].sdbLow;
@@ -207,37 +236,23 @@ class TBDecoder {
         return pEvents[indx].sdbHigh;
     }
     
-    //--------------------------------------------------------------------------
-    private:
-    //SETTERS - used for unshuffling data
-    void setEventNumber(uint32_t indx, uint32_t data){
-        pEvents[indx].eventNumber = data;
-    }
-    void setWord2(uint32_t indx, uint32_t data){
-        pEvents[indx].word2 = data;
-    }
-    void setWord3(uint32_t indx, uint32_t data){
-        pEvents[indx].word3 = data;
-    }
-    void setSdbHigh(uint32_t indx, uint32_t data){
-        pEvents[indx].sdbHigh = data;
-    }
-    void setSdbLow(uint32_t indx, uint32_t data){
-        pEvents[indx].sdbLow = data;
-    }
-    
     //--------------------------------------------------------------------------
     public:
     //ADDITIONAL FUNCTIONS
     /**
-    *   Frees memory allocated for the data from the current file.
-    *   You should no longer use this objects pointer to the EventData array.
-    *   The data is no longer reserved and therefore its behavior undefined.
+    *   Unmaps the current file. Called by the destructor, calling it before is allowed.
+    *   No record can be accessed afterwards.
     *   @param none
     *   @return none
     **/
     void removeData() {
-        delete[] pEvents;
+        if(mapBegin != NULL) {
+            munmap(mapBegin, mapSize);
+        }
+        mapBegin = NULL;
+        mapSize = 0;
+        pEvents = NULL;
+        N = 0;
     }
     
     /**
@@ -284,61 +299,65 @@ class TBDecoder {
 	}
 
     /**
-    *   Initially, the bytes for the data stored in the EventData array are in
-    *   the order 3421.
-    *   This function calls a helper function to convert that data into the
-    *   correct format of 1234.
-    *   @return void
+    *   Clock count of a record: the most significant byte is the low byte of word3,
+    *   the rest is word2.
+    **/
+    static uint64_t clockCount(const EventData &record){
+        return ((uint64_t)(record.word3 & 0xFF) << fullWordSizeBits) | record.word2;
+    }
+
+    /**
+    *   Trigger source bits of a record, the last 6 bits of the top byte of word3.
     **/
-    void unshuffleData() {
-    	uint32_t temp;
-        for(int k=0; k<N; k++) {
-        	// simply call helper function for first 3 words
-            // None of those functions has any effect on the
-            // stored value
-           // cout<<"Event No.: "<<getEventNumber(k) << endl;
-            //setEventNumber(k, shiftWord(getEventNumber(k)));
-            //cout<<"Event No.: "<<getEventNumber(k) << endl;
+    static uint8_t triggerSource(const EventData &record){
+        return (uint8_t)(record.word3 >> (triggerSourceByte*byteSize)) >> 2;
+    }
 
-            //cout<<"Word 2: "<<getWord2(k) << endl;
-            //setWord2(k, shiftWord(getWord2(k)));
-            //cout<<"Word 2: "<<getWord2(k) << endl;
-            //cout<<"Word 3: "<<getWord3(k) << endl;*/
-            //setWord3(k, shiftWord(getWord3(k)));
-            //cout<<"Word 3: "<<getWord3(k) << endl;/*
-            // call helper function and swap high and low sdb words.
-            
-            temp = getSdbHigh(k);
-            //cout<<"High: " << getSdbHigh(k) <<endl;
-            setSdbHigh(k, shiftWord(getSdbLow(k)));
-            //cout<<"High: " << getSdbHigh(k) <<endl;
-            //cout<<"Low: " << getSdbLow(k) <<endl;
-            setSdbLow(k, shiftWord(temp));
-            //cout<<"Low: " << getSdbLow(k) <<endl;
-        }
+    static bool isBifocalOrTest(uint8_t trigger){
+        return (trigger & bifocalTrigger) || (trigger & discTestTrigger);
     }
-    
+
     /**
-    *   Return single unsigned long for sdb. 
-    *   Combines sdbHigh and sdbLow by bitshifting sdbHigh and computing bitwise or.
-    *   @param index index of EventData array
+    *   The stretched discriminator bits are stored with the words swapped and the
+    *   bytes of each word in the order 3421. Records are read-only in the mapping,
+    *   so this reorganisation to 1234 is done on every access instead of once per file.
+    *   @param record raw record
     *   @return combined 64bit stretched discriminator bits.
     **/
-    uint64_t combineSdb(uint32_t index){
-        uint64_t temp = pEvents[index].sdbHigh;
+    static uint64_t unshuffleSdb(const EventData &record){
+        uint64_t temp = shiftWord(record.sdbLow);
         temp = temp << fullWordSizeBits;
-        temp |= pEvents[index].sdbLow;
-        
+        temp |= shiftWord(record.sdbHigh);
         return temp;
     }
-    
+
+    /**
+    *   First triggered MUSIC from the stretched discriminator bits: the lower bit of the
+    *   lowest pair of adjacent active bits, or the highest active bit if there is no pair.
+    *   This is the result of testing the bits one by one from bit 0, computed with two
+    *   bit scans.
+    *   @param trigger trigger source bits of the event
+    *   @param sdbBits combined stretched discriminator bits
+    *   @return The bit index, -1 if neither bifocal nor test trigger, -1 if no active SDBs
+    **/
+    static uint32_t activeSdb(uint8_t trigger, uint64_t sdbBits){
+        if(!isBifocalOrTest(trigger) || !sdbBits){
+            return -1;
+        }
+        uint64_t pairs = sdbBits & (sdbBits >> 1);
+        if(pairs){
+            return __builtin_ctzll(pairs);
+        }
+        return 63 - __builtin_clzll(sdbBits);
+    }
+
     /**
     *   Converts 32 bit data stored as bytes 4,3,2,1 to correct value read as 1,2,3,4
     *   Uses union Break4Bytes to enable individual byte access.
     *   @param data 32 bit data stored as 4,3,2,1
     *   @return 32 bit data shifted to 1234
     **/
-    uint32_t shiftWord(uint32_t data){
+    static uint32_t shiftWord(uint32_t data){
         Break4Bytes temp;
         temp.fullWord = data;
         uint32_t output;
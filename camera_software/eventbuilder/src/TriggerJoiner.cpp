@@ -0,0 +1,155 @@
+#include "TriggerJoiner.h"
+
+#include <map>
+#include <unordered_map>
+
+using namespace std;
+
+// number of leading records paired by position to find the counter offset
+#define OffsetProbeSize     64
+
+TriggerJoiner::TriggerJoiner()
+{
+    clear();
+}
+
+void TriggerJoiner::clear()
+{
+    events.clear();
+    tbOrphans.clear();
+    coboOrphans.clear();
+    repeatedTBNumbers = 0;
+    offset = 0;
+    positional = false;
+}
+
+/**
+ * Most frequent difference tbEventNumber - eventIdx over the first records paired by position.
+ * Sets positional if no difference is shared by half of them.
+ */
+int64_t TriggerJoiner::detectOffset(const vector<uint32_t> &tbEventNumbers, const EventAssembler &assembler, size_t nCoboEvents)
+{
+    size_t nProbe = tbEventNumbers.size();
+    if(nCoboEvents < nProbe) nProbe = nCoboEvents;
+    if(nProbe > OffsetProbeSize) nProbe = OffsetProbeSize;
+
+    map<int64_t, size_t> differences;
+    for(size_t k=0; k<nProbe; k++){
+        differences[(int64_t)tbEventNumbers[k] - (int64_t)assembler.getEvent(k).eventIdx]++;
+    }
+
+    int64_t bestOffset = 0;
+    size_t bestCount = 0;
+    for(map<int64_t, size_t>::iterator it=differences.begin(); it!=differences.end(); ++it){
+        if(it->second > bestCount){
+            bestOffset = it->first;
+            bestCount = it->second;
+        }
+    }
+    positional = (2*bestCount < nProbe);
+    return bestOffset;
+}
+
+/**
+ * Builds the list of events found in both streams, in CoBo eventIdx order.
+ * @param tbEventNumbers event counter of every trigger board record, in file order
+ * @param assembler CoBo events joined across AsAds, sorted by eventIdx
+ * @param nCoboEvents number of assembled events to use
+ */
+void TriggerJoiner::join(const vector<uint32_t> &tbEventNumbers, const EventAssembler &assembler, size_t nCoboEvents)
+{
+    clear();
+    if(nCoboEvents > assembler.getEventCount()) nCoboEvents = assembler.getEventCount();
+    offset = detectOffset(tbEventNumbers, assembler, nCoboEvents);
+
+    if(positional){
+        size_t nEvents = tbEventNumbers.size() < nCoboEvents ? tbEventNumbers.size() : nCoboEvents;
+        for(size_t k=0; k<nEvents; k++){
+            JoinedEvent event = {(int)k, (int)k};
+            events.push_back(event);
+        }
+        for(size_t k=nEvents; k<tbEventNumbers.size(); k++) tbOrphans.push_back(tbEventNumbers[k]);
+        for(size_t k=nEvents; k<nCoboEvents; k++) coboOrphans.push_back(assembler.getEvent(k).eventIdx);
+        return;
+    }
+
+    // trigger board event number -> record index, the first record wins
+    unordered_map<uint32_t, int> tbTable;
+    tbTable.reserve(tbEventNumbers.size());
+    for(size_t k=0; k<tbEventNumbers.size(); k++){
+        if(!tbTable.insert(make_pair(tbEventNumbers[k], (int)k)).second) repeatedTBNumbers++;
+    }
+
+    vector<bool> tbUsed(tbEventNumbers.size(), false);
+    events.reserve(nCoboEvents);
+    for(size_t k=0; k<nCoboEvents; k++){
+        uint32_t eventIdx = assembler.getEvent(k).eventIdx;
+        unordered_map<uint32_t, int>::iterator it = tbTable.find((uint32_t)(eventIdx + offset));
+        if(it == tbTable.end() || tbUsed[it->second]){
+            coboOrphans.push_back(eventIdx);
+            continue;
+        }
+        tbUsed[it->second] = true;
+        JoinedEvent event = {it->second, (int)k};
+        events.push_back(event);
+    }
+    for(size_t k=0; k<tbEventNumbers.size(); k++){
+        if(!tbUsed[k]) tbOrphans.push_back(tbEventNumbers[k]);
+    }
+}
+
+size_t TriggerJoiner::getEventCount() const
+{
+    return events.size();
+}
+
+const JoinedEvent &TriggerJoiner::getEvent(size_t indx) const
+{
+    return events.at(indx);
+}
+
+bool TriggerJoiner::isPositional() const
+{
+    return positional;
+}
+
+int64_t TriggerJoiner::getOffset() const
+{
+    return offset;
+}
+
+size_t TriggerJoiner::getTBOrphanCount() const
+{
+    return tbOrphans.size();
+}
+
+size_t TriggerJoiner::getCoboOrphanCount() const
+{
+    return coboOrphans.size();
+}
+
+/**
+ * Prints the counter offset, the number of joined events and the orphans of both streams.
+ * @param maxListed number of orphans of each stream listed individually
+ */
+void TriggerJoiner::printReport(ostream &out, size_t maxListed) const
+{
+    if(positional){
+        out << "TB/CoBo join: event counters do not match, records paired by position" << endl;
+    }else{
+        out << "TB/CoBo join: TB event number = CoBo eventIdx + " << offset << endl;
+    }
+    out << "Joined events: " << events.size()
+        << " | TB records without CoBo event: " << tbOrphans.size()
+        << " | CoBo events without TB record: " << coboOrphans.size()
+        << " | Repeated TB event numbers: " << repeatedTBNumbers << endl;
+
+    for(size_t k=0; k<tbOrphans.size() && k<maxListed; k++){
+        out << "TB event number " << tbOrphans[k] << " has no CoBo event" << endl;
+    }
+    if(tbOrphans.size() > maxListed) out << "... " << tbOrphans.size() << " TB orphans in total" << endl;
+    for(size_t k=0; k<coboOrphans.size() && k<maxListed; k++){
+        out << "CoBo eventIdx " << coboOrphans[k] << " has no TB record" << endl;
+    }
+    if(coboOrphans.size() > maxListed) out << "... " << coboOrphans.size() << " CoBo orphans in total" << endl;
+}
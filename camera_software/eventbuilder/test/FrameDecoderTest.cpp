@@ -0,0 +1,106 @@
+// FrameDecoderTest: checks that decoding zero suppressed (type 1) frames into a reused
+// trace buffer gives the traces of the new event only, as with a fresh buffer.
+// Two events with different suppression patterns are decoded into the same Event, as
+// the worker slots of the EventBuilder are reused between events.
+//
+// Usage: ./FrameDecoderTest, returns 0 if all checks pass
+
+#include <stdint.h>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <Event.h>
+
+#include "FrameDecoder.h"
+
+using namespace std;
+
+#define TestNofPixels   8
+#define TestNofSamples  32
+#define TestHeaderSize  8
+
+// one type 1 item per (channel, bucket), on aget 0
+struct TestSample {
+    int chan;
+    int bucket;
+    int value;
+};
+
+static GrawFrame buildPartialFrame(const vector<TestSample> &samples, vector<unsigned char> &bytes)
+{
+    bytes.assign(TestHeaderSize + 4*samples.size(), 0);
+    for (size_t k=0; k<samples.size(); k++) {
+        uint32_t word = ((uint32_t)samples[k].chan << 23) | ((uint32_t)samples[k].bucket << 14) | (samples[k].value & 0xFFF);
+        unsigned char *p = &bytes[TestHeaderSize + 4*k];
+        p[0] = word >> 24;
+        p[1] = word >> 16;
+        p[2] = word >> 8;
+        p[3] = word;
+    }
+    GrawFrame frame = GrawFrame();
+    frame.data = (const char *)&bytes[0];
+    frame.size = bytes.size();
+    frame.frameType = DecoderPartialReadout;
+    frame.bigEndian = true;
+    frame.headerSize = TestHeaderSize;
+    frame.itemSize = 4;
+    frame.itemCount = samples.size();
+    return frame;
+}
+
+static void decodeInto(const FrameDecoder &decoder, const GrawFrame &frame, Event *event)
+{
+    event->SetTraceSize(TestNofPixels, TestNofSamples);
+    decoder.decode(frame, 0, event->GetTraceBuffer(), TestNofPixels, TestNofSamples, frame.itemCount);
+}
+
+int main()
+{
+    // channel c of aget 0 of AsAd 0 is pixel c, all other channels are unmapped
+    PixelMapLUT lut;
+    memset(&lut, 0, sizeof(lut));
+    for (int asad=0; asad<DecoderNofAsads; asad++)
+        for (int aget=0; aget<DecoderNofAgets; aget++)
+            for (int chan=0; chan<DecoderChannelsPerAget; chan++)
+                lut.sipmID[asad][aget][chan] = (asad == 0 && aget == 0 && chan < TestNofPixels) ? chan : PixelMapUnmapped;
+    FrameDecoder decoder(lut);
+
+    // first event keeps the early buckets of every pixel, the second the late ones of some
+    vector<TestSample> first, second;
+    for (int pix=0; pix<TestNofPixels; pix++)
+        for (int b=0; b<16; b++) first.push_back(TestSample{pix, b, 1000 + pix*16 + b});
+    for (int pix=0; pix<TestNofPixels; pix+=2)
+        for (int b=16; b<TestNofSamples; b++) second.push_back(TestSample{pix, b, 2000 + pix*16 + b});
+
+    vector<unsigned char> firstBytes, secondBytes;
+    GrawFrame firstFrame = buildPartialFrame(first, firstBytes);
+    GrawFrame secondFrame = buildPartialFrame(second, secondBytes);
+
+    Event slot;
+    decodeInto(decoder, firstFrame, &slot);
+    decodeInto(decoder, secondFrame, &slot);
+
+    Event fresh;
+    decodeInto(decoder, secondFrame, &fresh);
+
+    int nFailed = 0;
+    const UShort_t *reused = slot.GetTraceBuffer();
+    const UShort_t *expected = fresh.GetTraceBuffer();
+    for (int pix=0; pix<TestNofPixels; pix++) {
+        for (int b=0; b<TestNofSamples; b++) {
+            int i = pix*TestNofSamples + b;
+            int value = (pix % 2 == 0 && b >= 16) ? 2000 + pix*16 + b : 0;
+            if (reused[i] != value || expected[i] != value) {
+                if (nFailed < 10) {
+                    cout << "pixel " << pix << " bucket " << b << ": reused slot " << reused[i]
+                         << ", fresh slot " << expected[i] << ", expected " << value << endl;
+                }
+                nFailed++;
+            }
+        }
+    }
+
+    cout << "FrameDecoderTest: " << (nFailed == 0 ? "passed" : "FAILED") << endl;
+    return nFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,374 @@
+// DataGenerator: writes synthetic CoBo .graw files and the matching trigger board
+// TB_data_*.bin file of one run, so that the EventBuilder can be tested and timed
+// without the camera.
+//
+// Usage: ./DataGenerator outputDirectory [options]
+//   --events N            number of events (default 1000)
+//   --asads N             number of AsAd files, 1 or 2 (default 1)
+//   --frame-type T        1 partial readout, 2 full readout (default 2)
+//   --samples S           time buckets per channel (default 512)
+//   --mix B:F:H:T         relative weights of BiFocal, Forced, HLED and Test triggers (default 8:1:1:0)
+//   --shape gauss|exp     pulse shape (default gauss)
+//   --amplitude A         pulse amplitude of BiFocal and Test events in ADC counts (default 800)
+//   --hled-amplitude A    pulse amplitude of HLED events (default 400)
+//   --peak B              bucket of the pulse maximum (default 240)
+//   --width W             gauss: sigma, exp: decay time, in buckets (default 4)
+//   --pedestal P          baseline in ADC counts (default 3000)
+//   --noise RMS           gaussian noise in ADC counts (default 4)
+//   --threshold T         frame type 1 only: skip samples above T (default 4095, every sample)
+//   --seed S              random seed (default 1)
+//   --map FILE            pixel map (default $EVENTBUILDER_DIR/Pixel_Map.csv, else ./Pixel_Map.csv)
+//
+// Frames follow the CoBo MFM layout of CoboFormats-Rev-5: big endian, 256 byte blocks, a
+// one block header. The CoBo eventIdx counts from 0 and the trigger board eventNumber
+// from 1, as in the camera. Pulses go down from the baseline, as the camera pulses that
+// ExACT extracts (amplitude = pedestal - minimum). They are put on the pixels of the two triggered MUSICs for
+// BiFocal and Test events, on every pixel for HLED events. Forced events are noise only.
+// Only MUSIC pairs whose pixels are all read by the generated AsAds are triggered.
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "PixelMap.h"
+
+using namespace std;
+
+#define GenNofTriggers          4
+#define GenBlockSize            256
+#define GenHeaderSize           256
+#define GenMetaType             0x08    // big endian, 2^8 byte blocks
+#define GenFrameRevision        5
+#define GenPartialItemSize      4
+#define GenFullItemSize         2
+#define GenSampleMax            0xFFF
+#define GenNofMusics            (PixelMapNofSipms/PixelMapSipmsPerMusic)
+#define GenClockStep            100000  // 1 ms in 10 ns ticks
+
+// trigger source bits of the trigger board, in --mix order
+static const uint8_t genTriggerSource[GenNofTriggers] = {1, 4, 32, 2};
+
+struct GeneratorConfig {
+    string outDir;
+    string mapFile;
+    int nEvents;
+    int nAsads;
+    int frameType;
+    int nSamples;
+    double mix[GenNofTriggers];
+    bool expShape;
+    double amplitude;
+    double hledAmplitude;
+    double peak;
+    double width;
+    double pedestal;
+    double noise;
+    int threshold;
+    unsigned seed;
+};
+
+static void usage(const char *name)
+{
+    cout << "Usage: " << name << " outputDirectory [--events N] [--asads 1|2] [--frame-type 1|2] [--samples S]" << endl
+         << "       [--mix B:F:H:T] [--shape gauss|exp] [--amplitude A] [--hled-amplitude A] [--peak B]" << endl
+         << "       [--width W] [--pedestal P] [--noise RMS] [--threshold T] [--seed S] [--map Pixel_Map.csv]" << endl;
+}
+
+static bool parseMix(const string &text, double *mix)
+{
+    size_t pos = 0;
+    for (int k=0; k<GenNofTriggers; k++) {
+        size_t end = text.find(':', pos);
+        if ((end == string::npos) != (k == GenNofTriggers-1)) return false;
+        mix[k] = atof(text.substr(pos, end == string::npos ? string::npos : end-pos).c_str());
+        if (mix[k] < 0) return false;
+        pos = end+1;
+    }
+    return mix[0] + mix[1] + mix[2] + mix[3] > 0;
+}
+
+static bool parseArguments(int argc, char **argv, GeneratorConfig &config)
+{
+    if (argc < 2 || argv[1][0] == '-') return false;
+    config.outDir = argv[1];
+    const char *ebDir = getenv("EVENTBUILDER_DIR");
+    config.mapFile = ebDir ? string(ebDir) + "/Pixel_Map.csv" : "Pixel_Map.csv";
+    config.nEvents = 1000;
+    config.nAsads = 1;
+    config.frameType = 2;
+    config.nSamples = 512;
+    config.mix[0] = 8; config.mix[1] = 1; config.mix[2] = 1; config.mix[3] = 0;
+    config.expShape = false;
+    config.amplitude = 800;
+    config.hledAmplitude = 400;
+    config.peak = 240;
+    config.width = 4;
+    config.pedestal = 3000;
+    config.noise = 4;
+    config.threshold = GenSampleMax;
+    config.seed = 1;
+
+    for (int i=2; i<argc; i++) {
+        string option = argv[i];
+        if (i+1 >= argc) return false;
+        string value = argv[++i];
+        if (option == "--events") config.nEvents = atoi(value.c_str());
+        else if (option == "--asads") config.nAsads = atoi(value.c_str());
+        else if (option == "--frame-type") config.frameType = atoi(value.c_str());
+        else if (option == "--samples") config.nSamples = atoi(value.c_str());
+        else if (option == "--mix") { if (!parseMix(value, config.mix)) return false; }
+        else if (option == "--shape") { if (value != "gauss" && value != "exp") return false; config.expShape = (value == "exp"); }
+        else if (option == "--amplitude") config.amplitude = atof(value.c_str());
+        else if (option == "--hled-amplitude") config.hledAmplitude = atof(value.c_str());
+        else if (option == "--peak") config.peak = atof(value.c_str());
+        else if (option == "--width") config.width = atof(value.c_str());
+        else if (option == "--pedestal") config.pedestal = atof(value.c_str());
+        else if (option == "--noise") config.noise = atof(value.c_str());
+        else if (option == "--threshold") config.threshold = atoi(value.c_str());
+        else if (option == "--seed") config.seed = strtoul(value.c_str(), NULL, 10);
+        else if (option == "--map") config.mapFile = value;
+        else return false;
+    }
+    return config.nEvents > 0 && config.nAsads >= 1 && config.nAsads <= PixelMapNofAsads
+        && (config.frameType == 1 || config.frameType == 2)
+        && config.nSamples > 0 && config.nSamples <= 512 && config.width > 0;
+}
+
+static void putBigEndian(unsigned char *p, uint64_t value, int nBytes)
+{
+    for (int k=nBytes-1; k>=0; k--) {
+        p[k] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static void putLittleEndian(unsigned char *p, uint32_t value)
+{
+    for (int k=0; k<4; k++) {
+        p[k] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+/**
+ * Pulse template normalised to 1 at its maximum.
+ */
+static vector<double> pulseTemplate(const GeneratorConfig &config)
+{
+    vector<double> shape(config.nSamples, 0.);
+    for (int b=0; b<config.nSamples; b++) {
+        double t = b - config.peak;
+        if (config.expShape) {
+            // fast rise over two buckets, exponential decay
+            if (t >= -2 && t < 0) shape[b] = 1. + t/2.;
+            else if (t >= 0) shape[b] = exp(-t/config.width);
+        } else {
+            shape[b] = exp(-0.5*t*t/(config.width*config.width));
+        }
+    }
+    return shape;
+}
+
+/**
+ * Writes the MFM header of one CoBo frame, the fields not listed are left at zero.
+ */
+static void writeFrameHeader(unsigned char *p, const GeneratorConfig &config, size_t frameBytes, uint32_t nItems,
+                             uint64_t eventTime, uint32_t eventIdx, int asadIdx)
+{
+    memset(p, 0, GenHeaderSize);
+    p[0] = GenMetaType;
+    putBigEndian(p + 1, frameBytes/GenBlockSize, 3);
+    putBigEndian(p + 5, config.frameType, 2);
+    p[7] = GenFrameRevision;
+    putBigEndian(p + 8, GenHeaderSize/GenBlockSize, 2);
+    putBigEndian(p + 10, config.frameType == 1 ? GenPartialItemSize : GenFullItemSize, 2);
+    putBigEndian(p + 12, nItems, 4);
+    putBigEndian(p + 16, eventTime, 6);
+    putBigEndian(p + 22, eventIdx, 4);
+    p[26] = 0;
+    p[27] = asadIdx;
+}
+
+int main(int argc, char **argv)
+{
+    GeneratorConfig config;
+    if (!parseArguments(argc, argv, config)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int **pixelMapArray;
+    try {
+        pixelMapArray = openPixelMap(config.mapFile);
+    }
+    catch (const std::exception & e) {
+        cout << config.mapFile << ": " << e.what() << endl;
+        return 1;
+    }
+    PixelMapLUT pixelMap;
+    buildPixelMapLUT(pixelMapArray, &pixelMap);
+    closePixelMap(pixelMapArray);
+
+    // run files, named as the camera names them
+    time_t now = time(NULL);
+    struct tm t;
+    localtime_r(&now, &t);
+    char coboStamp[32], tbStamp[32];
+    strftime(coboStamp, sizeof(coboStamp), "%Y-%m-%dT%H:%M:%S.000", &t);
+    strftime(tbStamp, sizeof(tbStamp), "%y_%m_%d_%H_%M_%S", &t);
+
+    vector<string> coboNames;
+    vector<ofstream *> coboFiles;
+    for (int asad=0; asad<config.nAsads; asad++) {
+        coboNames.push_back(config.outDir + "/CoBo0_AsAd" + to_string(asad) + "_" + coboStamp + "_0000");
+        coboFiles.push_back(new ofstream((coboNames.back() + ".graw").c_str(), ios::binary | ios::trunc));
+    }
+    string tbName = config.outDir + "/TB_data_" + tbStamp + "_0000";
+    ofstream tbFile((tbName + ".bin").c_str(), ios::binary | ios::trunc);
+    for (int asad=0; asad<config.nAsads; asad++) {
+        if (!*coboFiles[asad]) {
+            cout << "Can not write " << coboNames[asad] << ".graw" << endl;
+            return 1;
+        }
+    }
+    if (!tbFile) {
+        cout << "Can not write " << tbName << ".bin" << endl;
+        return 1;
+    }
+
+    mt19937 rng(config.seed);
+    normal_distribution<double> noise(0., config.noise);
+    uniform_real_distribution<double> uniform(0., 1.);
+
+    // MUSIC pairs that can be triggered, the pixel map may not cover every AsAd
+    vector<int> triggerMusics;
+    for (int music=0; music<GenNofMusics-1; music++) {
+        bool covered = true;
+        for (int sipm=music*PixelMapSipmsPerMusic; sipm<(music+2)*PixelMapSipmsPerMusic; sipm++) {
+            if (pixelMap.asadID[sipm] < 0 || pixelMap.asadID[sipm] >= config.nAsads) covered = false;
+        }
+        if (covered) triggerMusics.push_back(music);
+    }
+    if (triggerMusics.empty() && (config.mix[0] > 0 || config.mix[3] > 0)) {
+        cout << "No MUSIC pair of " << config.mapFile << " is read by " << config.nAsads << " AsAd(s)" << endl;
+        return 1;
+    }
+    uniform_int_distribution<int> musicPick(0, triggerMusics.empty() ? 0 : triggerMusics.size()-1);
+
+    double mixTotal = config.mix[0] + config.mix[1] + config.mix[2] + config.mix[3];
+    vector<double> shape = pulseTemplate(config);
+
+    size_t nChannels = PixelMapNofAgets*PixelMapChannelsPerAget;
+    size_t itemSize = config.frameType == 1 ? GenPartialItemSize : GenFullItemSize;
+    size_t maxFrameBytes = GenHeaderSize + nChannels*config.nSamples*itemSize + GenBlockSize;
+    vector<unsigned char> frame(maxFrameBytes);
+    vector<double> amplitude(PixelMapNofSipms);
+    vector<uint32_t> samples(nChannels*config.nSamples);
+    unsigned char record[5*4];
+
+    uint64_t nTriggers[GenNofTriggers] = {0, 0, 0, 0};
+    uint64_t totalBytes = 0;
+
+    for (int eventIdx=0; eventIdx<config.nEvents; eventIdx++) {
+        // trigger type from the mix, and the MUSIC pair for BiFocal and Test triggers
+        double pick = uniform(rng)*mixTotal;
+        int trigger = 0;
+        while (trigger < GenNofTriggers-1 && pick >= config.mix[trigger]) {
+            pick -= config.mix[trigger];
+            trigger++;
+        }
+        nTriggers[trigger]++;
+        uint8_t source = genTriggerSource[trigger];
+        uint64_t sdb = 0;
+
+        fill(amplitude.begin(), amplitude.end(), 0.);
+        if (source == 1 || source == 2) {
+            int music = triggerMusics[musicPick(rng)];
+            sdb = (uint64_t)3 << music;
+            for (int sipm=music*PixelMapSipmsPerMusic; sipm<(music+2)*PixelMapSipmsPerMusic; sipm++) {
+                amplitude[sipm] = config.amplitude*(0.5 + uniform(rng));
+            }
+        } else if (source == 32) {
+            for (int sipm=0; sipm<PixelMapNofSipms; sipm++) amplitude[sipm] = config.hledAmplitude*(0.9 + 0.2*uniform(rng));
+        }
+
+        uint64_t clock = (uint64_t)(eventIdx+1)*GenClockStep;
+        for (int asad=0; asad<config.nAsads; asad++) {
+            // samples of every channel, FPN and unmapped channels carry the baseline only
+            for (int aget=0; aget<PixelMapNofAgets; aget++) {
+                for (int chan=0; chan<PixelMapChannelsPerAget; chan++) {
+                    int sipm = pixelMap.sipmID[asad][aget][chan];
+                    double a = sipm >= 0 ? amplitude[sipm] : 0.;
+                    uint32_t *s = &samples[(aget*PixelMapChannelsPerAget + chan)*config.nSamples];
+                    for (int b=0; b<config.nSamples; b++) {
+                        long v = lround(config.pedestal - a*shape[b] + noise(rng));
+                        s[b] = v < 0 ? 0 : (v > GenSampleMax ? GenSampleMax : v);
+                    }
+                }
+            }
+
+            // items: full readout interleaves the agets channel by channel for every bucket,
+            // partial readout carries aget, channel and bucket in every item
+            unsigned char *p = &frame[GenHeaderSize];
+            uint32_t nItems = 0;
+            for (int b=0; b<config.nSamples; b++) {
+                for (int chan=0; chan<PixelMapChannelsPerAget; chan++) {
+                    for (int aget=0; aget<PixelMapNofAgets; aget++) {
+                        uint32_t sample = samples[(aget*PixelMapChannelsPerAget + chan)*config.nSamples + b];
+                        if (config.frameType == 2) {
+                            putBigEndian(p, ((uint32_t)aget << 14) | sample, GenFullItemSize);
+                        } else {
+                            if ((int)sample > config.threshold) continue;
+                            putBigEndian(p, ((uint32_t)aget << 30) | ((uint32_t)chan << 23) | ((uint32_t)b << 14) | sample, GenPartialItemSize);
+                        }
+                        p += itemSize;
+                        nItems++;
+                    }
+                }
+            }
+            size_t frameBytes = (GenHeaderSize + nItems*itemSize + GenBlockSize-1)/GenBlockSize*GenBlockSize;
+            memset(p, 0, &frame[0] + frameBytes - p);
+            writeFrameHeader(&frame[0], config, frameBytes, nItems, clock, eventIdx, asad);
+            coboFiles[asad]->write((const char *)&frame[0], frameBytes);
+            totalBytes += frameBytes;
+        }
+
+        // trigger board record, little endian words, the SDB words in the order TBDecoder unshuffles them
+        putLittleEndian(record, eventIdx+1);
+        putLittleEndian(record + 4, (uint32_t)clock);
+        putLittleEndian(record + 8, ((uint32_t)(source << 2) << 24) | ((clock >> 32) & 0xFF));
+        putLittleEndian(record + 12, (uint32_t)sdb);
+        putLittleEndian(record + 16, (uint32_t)(sdb >> 32));
+        tbFile.write((const char *)record, sizeof(record));
+        totalBytes += sizeof(record);
+    }
+
+    bool ok = (bool)tbFile;
+    tbFile.close();
+    for (int asad=0; asad<config.nAsads; asad++) {
+        coboFiles[asad]->close();
+        if (coboFiles[asad]->fail()) ok = false;
+        delete coboFiles[asad];
+    }
+    if (!ok) {
+        cout << "Write error in " << config.outDir << endl;
+        return 1;
+    }
+
+    cout << config.nEvents << " events, BiFocal " << nTriggers[0] << " Forced " << nTriggers[1]
+         << " HLED " << nTriggers[2] << " Test " << nTriggers[3] << ", " << totalBytes/1.e6 << " MB" << endl;
+    // EventBuilder input arguments
+    cout << "CoBo: ";
+    for (int asad=0; asad<config.nAsads; asad++) cout << (asad > 0 ? "," : "") << coboNames[asad];
+    cout << endl << "TB: " << tbName << endl;
+    return 0;
+}
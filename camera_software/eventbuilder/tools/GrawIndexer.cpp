@@ -0,0 +1,58 @@
+// GrawIndexer: writes the sidecar .gidx frame index of existing .graw files,
+// so that EventBuilder and other readers can skip scanning them.
+//
+// Usage: ./GrawIndexer file.graw [file.graw ...]
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "GrawReader.h"
+#include "GrawIndex.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        cout << "Usage: " << argv[0] << " file.graw [file.graw ...]" << endl;
+        return 1;
+    }
+
+    int nFailed = 0;
+    for (int k=1; k<argc; k++) {
+        string grawFileName = argv[k];
+        string indexFileName = grawIndexFileName(grawFileName);
+
+        GrawReader reader;
+        try {
+            // always scan, an existing index may be stale
+            reader.open(grawFileName, false);
+        }
+        catch (const std::exception & e) {
+            cout << e.what() << endl;
+            nFailed++;
+            continue;
+        }
+
+        vector<GrawIndexRecord> records(reader.getFrameCount());
+        for (size_t indx=0; indx<reader.getFrameCount(); indx++) {
+            const GrawFrame &frame = reader.getFrame(indx);
+            records[indx].offset = frame.offset;
+            records[indx].size = frame.size;
+            records[indx].eventIdx = frame.eventIdx;
+            records[indx].frameType = frame.frameType;
+            records[indx].coboIdx = frame.coboIdx;
+            records[indx].asadIdx = frame.asadIdx;
+        }
+
+        if (!writeGrawIndex(indexFileName, records)) {
+            cout << "Can not write " << indexFileName << endl;
+            nFailed++;
+            continue;
+        }
+        cout << indexFileName << ": " << records.size() << " frames" << endl;
+    }
+    return nFailed > 0 ? 1 : 0;
+}
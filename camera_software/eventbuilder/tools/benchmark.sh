@@ -0,0 +1,65 @@
+#!/bin/bash
+# Times the EventBuilder end to end and per stage on a synthetic run from DataGenerator.
+#
+# Usage: tools/benchmark.sh [path/to/]CoboFormats.xcfg [workDirectory]
+# Settings are taken from the environment:
+#   BENCH_EVENTS      events of the synthetic run (default 5000)
+#   BENCH_THREADS     decoding thread counts to time, one run each (default "1 2 4")
+#   BENCH_GENERATOR   extra DataGenerator options, e.g. "--frame-type 1 --mix 1:0:0:0"
+#   BENCH_CONFIG      EventBuilder output configuration (default EventBuilder.cfg)
+#
+# The run is generated once in workDirectory (default ./benchmark) and kept, so that the
+# timings are not affected by the writing of the input. Stage times are read from the
+# statistics record of each run: scan (mapping and joining the CoBo frames), join (trigger
+# board), decode (summed over the threads) and write.
+
+EVENTBUILDER_DIR=${EVENTBUILDER_DIR:-$(cd "$(dirname "$0")/.." && pwd)}
+export EVENTBUILDER_DIR
+COBOFORMAT=$1
+WORKDIR=${2:-./benchmark}
+EVENTS=${BENCH_EVENTS:-5000}
+THREADS=${BENCH_THREADS:-"1 2 4"}
+
+if [ -z "${COBOFORMAT}" ]; then
+	echo "Usage: $0 [path/to/]CoboFormats.xcfg [workDirectory]"
+	exit 1
+fi
+
+INDIR=${WORKDIR}/input
+OUTDIR=${WORKDIR}/output
+STATS=${WORKDIR}/stats.json
+mkdir -p ${INDIR} ${OUTDIR}
+
+# value of a numeric field of a JSON statistics record
+Field () {
+	echo "$1" | sed -n "s/.*\"$2\":\([-0-9.e+]*\).*/\1/p"
+}
+
+if [ ! -f ${INDIR}/generated.txt ] || ! grep -q "^${EVENTS} ${BENCH_GENERATOR}\$" ${INDIR}/generated.txt; then
+	rm -f ${INDIR}/*.graw ${INDIR}/*.bin ${INDIR}/generated.txt
+	${EVENTBUILDER_DIR}/DataGenerator ${INDIR} --events ${EVENTS} ${BENCH_GENERATOR} || exit 1
+	echo "${EVENTS} ${BENCH_GENERATOR}" > ${INDIR}/generated.txt
+fi
+COBO=$(ls ${INDIR}/CoBo0_AsAd*.graw | sed 's/\.graw$//' | paste -sd, -)
+TB=$(ls ${INDIR}/TB_data_*.bin | sed 's/\.bin$//')
+
+OPTIONS="--log warning --stats ${STATS}"
+if [ -n "${BENCH_CONFIG}" ]; then
+	OPTIONS="${OPTIONS} --config ${BENCH_CONFIG}"
+fi
+
+rm -f ${STATS}
+printf "%8s %8s %8s %8s %8s %8s %8s %10s %10s\n" threads events wall_s scan_s join_s decode_s write_s events/s inMB/s
+for N in ${THREADS}; do
+	rm -f ${OUTDIR}/*.root
+	${EVENTBUILDER_DIR}/EventBuilder ${COBOFORMAT} ${COBO} ${TB} ${OUTDIR} --threads ${N} ${OPTIONS} > ${WORKDIR}/EventBuilder_${N}.log 2>&1 || {
+		echo "EventBuilder failed with ${N} thread(s), see ${WORKDIR}/EventBuilder_${N}.log"
+		exit 1
+	}
+	RECORD=$(grep '"record":"run"' ${STATS} | tail -n 1)
+	printf "%8s %8s %8.3f %8.3f %8.3f %8.3f %8.3f %10.1f %10.1f\n" ${N} $(Field "${RECORD}" events) \
+		$(Field "${RECORD}" wallSeconds) $(Field "${RECORD}" scanSeconds) $(Field "${RECORD}" joinSeconds) \
+		$(Field "${RECORD}" decodeSeconds) $(Field "${RECORD}" writeSeconds) \
+		$(Field "${RECORD}" eventsPerSecond) $(Field "${RECORD}" inputMBPerSecond)
+done
+echo "Statistics records: ${STATS}"
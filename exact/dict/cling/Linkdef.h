@@ -9,9 +9,13 @@
 #pragma link C++ class GoldPlated+;
 #pragma link C++ class ReadConfiguration+;
 #pragma link C++ class Pulse+;
+#pragma link C++ class PulseBatch+;
+#pragma link C++ class IHousekeeping+;
 #pragma link C++ class IEvent+;
+#pragma link C++ class IHealthScanResult+;
 #pragma link C++ class IHealthTools+;
 #pragma link C++ class IFile+;
+#pragma link C++ class IExtractedTree+;
 #pragma link C++ class IPlotTools+;
 #pragma link C++ class ISims+;
 #pragma link C++ class IUtilities+;
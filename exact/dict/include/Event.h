@@ -17,7 +17,11 @@ public:
 	void SetEventType(Int_t rcvEventType);
 	void SetROIMusicID(vector<Int_t> musicIDs);
 	void SetROIPixelID(vector<Int_t> pixIDs);
-	void SetSignalValue(vector<vector<Int_t>> signalTrace);
+	void SetSignalValue(const vector<vector<Int_t>> &signalTrace);
+	void SetTraceSize(Int_t nPix, Int_t nBuckets);
+	void ClearTraces();
+	UShort_t *GetTraceBuffer();
+	void KeepPixels(const vector<Int_t> &pixIDs);
 
 	ULong64_t GetCoBoTime();
 	ULong64_t GetUNIXTime();
@@ -27,6 +31,14 @@ public:
 	vector<Int_t> GetROIPixelID();
 	vector<vector<Int_t>> GetSignalValue();
 	vector<Int_t> GetSignalValue(int pixID);
+	const UShort_t *GetTrace(int pixID);
+	const UShort_t *GetSignalRow(int pixID, vector<UShort_t> &flatTrace);
+	Int_t GetNPixels();
+	Int_t GetNSamples();
+	Bool_t IsTraceStored(int pixID);
+	vector<Int_t> GetStoredPixelID();
+	Float_t GetPedestalMean(int pixID);
+	Float_t GetPedestalRMS(int pixID);
 	
 
 protected:
@@ -35,7 +47,22 @@ protected:
 	ULong64_t unix_time;
 	Int_t eventType;
 
+	void ConvertLegacyTraces();
+	Int_t FindStoredPixel(int pixID);
+
+	// Traces are stored as one contiguous nPixels x nSamples array, the trace of
+	// pixel i starts at traces[i*nSamples]. signalValue is only filled when reading
+	// files written before the flat storage, and is converted on first access.
 	vector<vector<Int_t>> signalValue;
+	Int_t nPixels;
+	Int_t nSamples;
+	vector<UShort_t> traces;
+	// Sparse events (see KeepPixels) hold traces only for the sorted storedPixelID,
+	// traces[k*nSamples] is then the trace of pixel storedPixelID[k]. Every pixel keeps
+	// the mean and RMS of its trace. Both are empty for events holding all traces.
+	vector<Int_t> storedPixelID;
+	vector<Float_t> pedestalMean;
+	vector<Float_t> pedestalRMS;
 	vector<Int_t> roiMusicID;
 	vector<Int_t> roiPixelID;
 
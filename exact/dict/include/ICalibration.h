@@ -35,8 +35,10 @@ class ICalibration {
 	    static double GetRelativeOverVoltage(int pixelID, double operatingVol, double nominalVol);
 	    static double GetOverVoltage(int pixelID, double operatingVol);
 	    static double GetRelativeGain(int pixelID, double sipmTemp, double OperatingVol);
+	    static std::vector<double> GetRelativeGain(double sipmTemp, double OperatingVol);
 	   	static int GetMeasurementLine(std::string filename, std::string measurement);
 	    static double GetMeasurementFromFile(int pixelID, double sipmTemp, double OperatingVol, std::string filename, std::string measurement, std::string biasVoltageRef="ABS");
+	    static std::vector<double> GetMeasurementFromFile(double sipmTemp, double OperatingVol, std::string filename, std::string measurement, std::string biasVoltageRef="ABS");
 
 
 	private:
@@ -45,8 +47,6 @@ class ICalibration {
 	    std::vector<double> charges;
 	    std::vector<double> errCharges;
 
-	    static int GetClosestTemperatureLine(double sipmTemp, std::string filename, std::string measurement);
-
 	   	
 	    //double relativeGain;
 };
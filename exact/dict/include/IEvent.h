@@ -3,6 +3,7 @@
 #define IFHBEVENT_H
 
 #include "Event.h"
+#include "IHousekeeping.h"
 
 using namespace std;
 
@@ -48,7 +49,10 @@ class IEvent : public Event{
 		ULong64_t unix_time; Time as recorded by the computer for the event
 		Int_t eventType; Deprecated 
 	
-		vector<vector<Int_t>> signalValue; All traces for the event. contains a vecotr of 512x512
+		vector<UShort_t> traces; All traces for the event, nPixels x nSamples in one contiguous array
+		(files written before hold them in vector<vector<Int_t>> signalValue, converted on access)
+		vector<Int_t> storedPixelID; Pixels with a stored trace when the event was written ROI-only, empty otherwise
+		vector<Float_t> pedestalMean, pedestalRMS; Trace mean and RMS of every pixel of a ROI-only event
 		vector<Int_t> roiMusicID; List of triggered music chips. Exactly 2 IDs are given
 		vector<Int_t> roiPixelID; Region of Interest for the event 36 pixelIDs stored */
 
@@ -119,9 +123,15 @@ class IEvent : public Event{
 
 	public:
 		// void LoadFromFile(const std::string& filename1, const std::string& filename2);
-		void SetParametersFromTimestamp(int timestamp,std::vector<std::vector<std::string>> data,std::vector<std::vector<std::string>> data2);
-		void SetTelescopePointing(int timestamp, std::vector<std::vector<std::string>> data);
-		void SetTelescopePointingRaw(int timestamp, std::vector<std::vector<std::string>> data);
+		void SetParametersFromTimestamp(int timestamp,const std::vector<std::vector<std::string>> &data,const std::vector<std::vector<std::string>> &data2);
+		void SetTelescopePointing(int timestamp, const std::vector<std::vector<std::string>> &data);
+		void SetTelescopePointingRaw(int timestamp, const std::vector<std::vector<std::string>> &data);
+		// Same from housekeeping tables parsed once, for merging many events
+		void SetParametersFromTimestamp(int timestamp, const IHousekeeping &data, const IHousekeeping &data2);
+		void SetTelescopePointing(int timestamp, const IHousekeeping &data);
+		void SetTelescopePointingRaw(int timestamp, const IHousekeeping &data);
+		// GPS, HV, temperatures, EMON, LVPS and tilt from the records closest to the timestamp
+		void SetHousekeeping(int timestamp, const IHousekeeping &data, const IHousekeeping &data2, const IHousekeeping &dataTilt, const IHousekeeping &dataTiltRaw);
 		int GetclosestTimestamp1() const;
 		int GetclosestTimestamp2() const;
 		float GetLatitude() const;
@@ -156,8 +166,5 @@ class IEvent : public Event{
 
 		static int FindClosestTimestampIndex(std::vector<unsigned long long> timeArray, unsigned long long eventTime);
 
-	private:
-    	int findClosestTimestamp(const std::vector<std::vector<std::string>>& data, int timestamp) const;
-
 };
 #endif
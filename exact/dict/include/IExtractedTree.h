@@ -0,0 +1,105 @@
+#ifndef IEXTRACTEDTREE_H
+#define IEXTRACTEDTREE_H
+
+#include <TROOT.h>
+#include <TTree.h>
+#include <vector>
+
+#include "ExtractedData.h"
+#include "BiFocal.h"
+
+/*
+
+Class used to read and write the trees of an _Extracted.root file.
+
+The extracted trees come in two layouts:
+
+Per pixel: one branch Pixel[i] per camera pixel, each holding an ExtractedData
+Columnar: one fixed size array branch per quantity, Amplitude[nPixels], Charge[nPixels],
+TimePeak[nPixels], Pedestal[nPixels] and PedestalRMS[nPixels]
+
+Both have the TriggerTime branch and, for the BiFocal and Test trees, TriggerRegion. The
+columnar layout reads and writes 5 branches per entry instead of one per pixel. The class
+hides which one a file uses, so files written before the columnar layout stay readable.
+
+Constructors:
+IExtractedTree(TTree *tree, int nPixels)
+Reads an existing tree, the layout is taken from its branches.
+
+IExtractedTree(TTree *tree, int nPixels, bool columnar, bool withTriggerRegion)
+Creates the branches of a new tree in the given layout. The values of an entry are set
+with SetPixel, SetTriggerTime and SetTriggerRegion before Fill.
+
+When reading a columnar tree whose arrays differ in length from nPixels, a warning is printed:
+pixels beyond the arrays of the file read 0 and array elements beyond nPixels are ignored.
+
+The tree is not owned by the class, which holds the branch buffers: it has to be kept while
+the tree is read or filled.
+
+*/
+
+class IExtractedTree{
+	public:
+		IExtractedTree(TTree *tree, int nPixels);
+		IExtractedTree(TTree *tree, int nPixels, bool columnar, bool withTriggerRegion);
+		~IExtractedTree();
+
+		bool IsColumnar();
+		int GetNPixels();
+		Long64_t GetEntries();
+
+		/*
+		Reads an entry of the tree
+
+		Arguments:
+		Long64_t entry: entry number
+
+		returns:
+		bytes read, as TTree::GetEntry
+		*/
+		Int_t GetEntry(Long64_t entry);
+
+		// Values of the last entry read
+		ExtractedData* GetPixel(int pixID);
+		unsigned short GetAmplitude(int pixID);
+		unsigned short GetCharge(int pixID);
+		unsigned short GetTimePeak(int pixID);
+		unsigned short GetPedestal(int pixID);
+		float GetPedestalRMS(int pixID);
+		unsigned long long GetTriggerTime();
+		// NULL for trees without TriggerRegion
+		BiFocal* GetTriggerRegion();
+
+		// Values of the next entry written
+		void SetPixel(int pixID, ExtractedData *ex);
+		void SetTriggerTime(unsigned long long time);
+		void SetTriggerRegion(vector<int> roiPixelIDs, vector<int> trigMusicIDs);
+		Int_t Fill();
+
+		/*
+		Checks the layout of an extracted tree
+
+		returns:
+		true if the tree has the array branches of the columnar layout
+		*/
+		static bool IsColumnar(TTree *tree);
+
+	private:
+		TTree *ITTree;
+		int nPixels;
+		bool isColumnar;
+
+		std::vector<ExtractedData*> pixels;
+		std::vector<unsigned short> amplitude;
+		std::vector<unsigned short> charge;
+		std::vector<unsigned short> timePeak;
+		std::vector<unsigned short> pedestal;
+		std::vector<float> pedestalRMS;
+		unsigned long long triggerTime;
+		BiFocal *triggerRegion;
+
+		void Init(int nPix, bool columnar);
+		// grows a columnar buffer to the array length of its branch in the file
+		template<typename T> void ResizeToLeaf(const char *name, std::vector<T> &buffer);
+};
+#endif
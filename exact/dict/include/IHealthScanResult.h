@@ -0,0 +1,97 @@
+#ifndef IHEALTHSCANRESULT_H
+#define IHEALTHSCANRESULT_H
+
+#include <TROOT.h>
+#include <string>
+#include <vector>
+
+/*
+
+Class holding the result of a camera health scan, IHealthTools::CameraHealthScan.
+
+The scan reads every entry of a tree once and extracts Pedestal, Pedestal RMS, Amplitude, Charge
+and Peaking Time of all pixels from the same pulse. Entries rejected by the time, voltage and
+tilt filters are only counted. For the accepted entries the result keeps the trigger time, whether
+the event is bad (IHealthTools::IsBadEvent) and, unless disabled, the values of every pixel.
+
+Per pixel means and RMS over the accepted events that are not bad are always kept, so that long
+scans can drop the values of the single events.
+
+A measurement is selected with its ID, see GetMeasurementID.
+
+*/
+
+class IHealthScanResult{
+	public:
+		enum Measurement {kPedestal, kPedestalRMS, kAmplitude, kCharge, kPeakingTime, kNMeasurements};
+
+		IHealthScanResult(int nPixels = 512, bool keepValues = true);
+		~IHealthScanResult();
+
+		// Clears the result for a new scan
+		void Reset(int nPixels, bool keepValues);
+
+		/*
+		Adds an accepted entry
+
+		Arguments:
+		int entry: entry in the tree
+		unsigned long long eventTime: trigger time of the entry
+		bool isBadEvent: the traces have too many flat pixels
+		const std::vector<std::vector<float>> &values: values[measurementID][pixID]
+		*/
+		void AddEntry(int entry, unsigned long long eventTime, bool isBadEvent, const std::vector<std::vector<float>> &values);
+		void AddRejected();
+
+		int GetNPixels() const;
+		// accepted entries
+		int GetNEntries() const;
+		int GetNRejected() const;
+		int GetNBadEvents() const;
+
+		// i runs over the accepted entries, from 0 to GetNEntries()-1
+		int GetEntry(int i) const;
+		unsigned long long GetEventTime(int i) const;
+		bool IsBadEvent(int i) const;
+
+		/*
+		Values of the accepted entry i, as returned by IHealthTools::CameraPedestal... for it.
+		Empty if the values were not kept
+		*/
+		std::vector<float> GetCameraValues(int measurementID, int i) const;
+		float GetValue(int measurementID, int i, int pixID) const;
+		// mean over the pixels of the accepted entry i
+		float GetCameraMean(int measurementID, int i) const;
+
+		// over the accepted events that are not bad, 0 if there are none
+		std::vector<float> GetPixelMean(int measurementID) const;
+		std::vector<float> GetPixelRMS(int measurementID) const;
+
+		/*
+		Get Measurement ID
+
+		Arguments:
+		std::string measurement: Not case sensitive, can be pedestal, pedestalrms, amplitude,
+		charge, peakingtime
+
+		returns:
+		int specifying the ID, -1 if there is no such measurement
+		*/
+		static int GetMeasurementID(std::string measurement);
+
+	private:
+		int nPixels;
+		bool keepValues;
+		int nRejected;
+		int nGoodEvents;
+
+		std::vector<int> entries;
+		std::vector<unsigned long long> eventTimes;
+		std::vector<bool> badEvents;
+		// values[measurementID][i*nPixels + pixID]
+		std::vector<std::vector<float>> values;
+		std::vector<std::vector<float>> cameraMeans;
+		std::vector<std::vector<double>> sums;
+		std::vector<std::vector<double>> sumsSquared;
+};
+#endif
@@ -5,6 +5,7 @@
 #include "Event.h"
 #include "IEvent.h"
 #include "IFile.h"
+#include "IHealthScanResult.h"
 #include <TString.h>
 #include <TROOT.h>
 
@@ -51,19 +52,48 @@ class IHealthTools{
 		static std::vector<float> CameraAmplitude(IFile *file,int entry,unsigned long long lTimeStart, unsigned long long lTimeEnd, std::string tree, float voltage, unsigned long long *eventTime,int iTWStart=200, int iTWEnd=300,float fTiltLow=-100,float fTiltHigh=100);
 
 		static std::vector<float> CameraAmplitude(IFile *file,int entry, std::string tree, int iTWStart=200, int iTWEnd=300);
-		static std::vector<float> CameraAmplitude(std::vector<std::vector<int>>, int iTWStart=200, int iTWEnd=300);
+		static std::vector<float> CameraAmplitude(const std::vector<std::vector<int>> &, int iTWStart=200, int iTWEnd=300);
 
 		static std::vector<float> CameraCharge(IFile *file,int entry,unsigned long long lTimeStart, unsigned long long lTimeEnd, std::string tree, float voltage, unsigned long long *eventTime,int iTWStart=200, int iTWEnd=300,float fTiltLow=-100,float fTiltHigh=100);
 		static std::vector<float> CameraPeakingTime(IFile *file,int entry,unsigned long long lTimeStart, unsigned long long lTimeEnd, std::string tree, float voltage, unsigned long long *eventTime,int iTWStart=200, int iTWEnd=300,float fTiltLow=-100,float fTiltHigh=100);
 
-		static bool IsBadEvent(std::vector<std::vector<int>> traces, int iTWStart, int iTWEnd, int nPixelsTolerance = 20, int nSamplesTolerance = 10);
+		static bool IsBadEvent(const std::vector<std::vector<int>> &traces, int iTWStart, int iTWEnd, int nPixelsTolerance = 20, int nSamplesTolerance = 10);
 		static bool IsBadEvent(IFile *file,int entry, std::string treeName,int iTWStart, int iTWEnd, int nPixelsTolerance = 20, int nSamplesTolerance = 10);
 
+		/*
+		Scans a whole tree in one pass for the camera health
+
+		Every entry is read once. The entries outside of the time range, biased at a different
+		voltage or outside of the tilt range are rejected before any trace is looked at. For the
+		others a single pulse extraction per pixel gives Pedestal, Pedestal RMS, Amplitude, Charge
+		and Peaking Time, and the traces are checked as in IsBadEvent.
+
+		Arguments are those of the methods above, plus:
+
+		bool tiltRelativeToHorizon: filters on the tilt angle minus the horizon, as CameraAmplitude
+		does, instead of the tilt angle, as the other methods do. It applies to all measurements, so
+		to select the events CameraAmplitude would use set it to true
+
+		float voltageTolerance: largest accepted difference between the bias voltage from the
+		Auxiliary data and voltage
+
+		bool keepValues: keeps the values of every pixel of every accepted entry. Without them the
+		result only holds the per pixel means and RMS, and the camera means of each entry
+
+		returns
+
+		IHealthScanResult with the values of the accepted entries
+		*/
+		static IHealthScanResult CameraHealthScan(IFile *file, std::string tree, unsigned long long lTimeStart, unsigned long long lTimeEnd, float voltage, int iTWStart=200, int iTWEnd=300, float fTiltLow=-100, float fTiltHigh=100, bool tiltRelativeToHorizon=false, float voltageTolerance=0.1, bool keepValues=true, int nPixelsTolerance = 20, int nSamplesTolerance = 10);
+
 
 
 	private:
 		static bool IsTimeInRange(unsigned long long lTime,unsigned long long lTimeStart, unsigned long long lTimeEnd);
 		static bool IsTiltInRange(float ftilt,float fTiltLow,float fTiltHigh);
+		static TTree* GetTree(IFile *file, std::string treeName);
+		// nSamplesTolerance equal consecutive samples in the time window
+		static bool IsFlatTrace(const UShort_t *trace, int iTWStart, int iTWEnd, int nSamplesTolerance);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef IHOUSEKEEPING_H
+#define IHOUSEKEEPING_H
+
+#include <TROOT.h>
+#include <string>
+#include <vector>
+
+/*
+
+Class used to hold a housekeeping table (GPS, HV, temperatures, tilt sensor...) as a time series.
+
+The tables are text files with a header line and one row per record, the timestamp in the first
+column. The cells are parsed once into numeric columns sorted by timestamp, so that the record
+closest to an event time is found by a binary search instead of a scan of the table.
+
+Constructors:
+IHousekeeping(std::string filename)
+Reads the table from a text file. Throws std::runtime_error if the file can not be opened, has no
+header or a row has not as many cells as the header.
+
+IHousekeeping(const std::vector<std::vector<std::string>> &data)
+Parses a table already read into rows of cells, without the header.
+
+Cells that are not numbers are read as 0.
+
+*/
+
+class IHousekeeping{
+	public:
+		IHousekeeping(std::string filename);
+		IHousekeeping(const std::vector<std::vector<std::string>> &data);
+		~IHousekeeping();
+
+		int GetEntries() const;
+		int GetNColumns() const;
+		// Column names, empty if the table was not read from a file
+		const std::vector<std::string>& GetHeaders() const;
+
+		/*
+		Finds the record closest in time
+
+		Arguments:
+		long long timestamp: time in the unit of the first column
+
+		returns:
+		entry of the record with the smallest time difference, of the one first in the table if
+		several are as close. -1 if the table is empty
+		*/
+		int FindClosestEntry(long long timestamp) const;
+
+		long long GetTimestamp(int entry) const;
+		// 0 for a column the table does not have
+		double GetValue(int entry, int column) const;
+
+	private:
+		std::vector<std::string> headers;
+		// sorted by timestamp, records with the same timestamp in table order
+		std::vector<long long> timestamps;
+		std::vector<int> rows;
+		std::vector<std::vector<double>> columns;
+
+		void Init(const std::vector<std::vector<std::string>> &data);
+};
+#endif
@@ -20,24 +20,33 @@ private:
 	int timeFW;
 	float pedestalRMS;
 	Double_t timeIntegration;
-	vector<Int_t> trace;
 
-	void CalcPedestal(Int_t nSamplesPedestal);
+	// the trace is only read while the constructor runs, it is not copied
+	template<typename T> void Extract(ReadConfiguration *config, const T *trace);
+	template<typename T> void Extract(const T *trace, Int_t tStart, Int_t tEnd, bool isPedestalSub);
+	template<typename T> void CalcPedestal(const T *trace, Int_t nSamplesPedestal);
 	void CalcAmplitude();
-	void CalcCharge(Int_t tWinSt, Int_t tWinEnd, Int_t tWinExt, Bool_t isRevolving);
+	template<typename T> void CalcCharge(const T *trace, Int_t tWinSt, Int_t tWinEnd, Int_t tWinExt, Bool_t isRevolving);
 	void CalcPeakTime();
 	void CalcFWHM();
 	void CalcFW();
-	void FindPeakTime(Int_t tWinSt, Int_t tWinEnd);
-	void FindPeak();
+	template<typename T> void FindPeakTime(const T *trace, Int_t tWinSt, Int_t tWinEnd);
+	template<typename T> void FindPeak(const T *trace);
+	void Init(Int_t nSamples);
 
 public:
 	//Constructor
 	//Pulse(ReadConfiguration *config, UInt_t *samples);
-	Pulse(ReadConfiguration *config, std::vector<Int_t> samples);
-	Pulse(vector<Int_t> samples);
-	Pulse(vector<int> samples, Int_t tStart, Int_t tEnd, int nSamples = 512, bool isPedestalSub = true);
-	Pulse(vector<float> samples, Int_t tStart, Int_t tEnd, int nSamples = 512, bool isPedestalSub = true);
+	Pulse(ReadConfiguration *config, const std::vector<Int_t> &samples);
+	Pulse(const vector<Int_t> &samples);
+	Pulse(const vector<int> &samples, Int_t tStart, Int_t tEnd, int nSamples = 512, bool isPedestalSub = true);
+	Pulse(const vector<float> &samples, Int_t tStart, Int_t tEnd, int nSamples = 512, bool isPedestalSub = true);
+	// read-only views of nSamples samples, e.g. Event::GetSignalRow()
+	Pulse(ReadConfiguration *config, const UShort_t *samples, Int_t nSamples);
+	Pulse(ReadConfiguration *config, const Int_t *samples, Int_t nSamples);
+	Pulse(const UShort_t *samples, Int_t nSamples, Int_t tStart, Int_t tEnd, bool isPedestalSub = true);
+	Pulse(const Int_t *samples, Int_t nSamples, Int_t tStart, Int_t tEnd, bool isPedestalSub = true);
+	Pulse(const float *samples, Int_t nSamples, Int_t tStart, Int_t tEnd, bool isPedestalSub = true);
 	//Destructor
 	~Pulse();
 
@@ -0,0 +1,53 @@
+#ifndef PULSEBATCH_H
+#define PULSEBATCH_H
+#include <TROOT.h>
+#include <ReadConfiguration.h>
+#include <Event.h>
+#include <vector>
+using namespace std;
+
+/**
+ * Pulse extraction of all pixels of an event at once.
+ * Extract() computes the values the Pulse(ReadConfiguration*, trace) constructor
+ * gives for every camera pixel, bit for bit, reading the flat trace storage of the
+ * Event without copying the traces. Pixels are processed 8 at a time with AVX2 or
+ * SSE2 when the CPU has them, with plain loops otherwise. The getters return the
+ * values of the last extracted event. An object holds working buffers, use one per
+ * thread.
+ */
+class PulseBatch {
+private:
+	ReadConfiguration *config;
+	Int_t nPixels;
+	// samples of the traces read by the extraction
+	Int_t nSamplesUsed;
+	Int_t instructionSet;
+
+	// traces of 8 pixels, sample-major: sample i of lane k at block[i*8+k]
+	vector<Int_t> block;
+	vector<Double_t> pedestal;
+	vector<float> pedestalRMS;
+	vector<int> amplitude;
+	vector<int> charge;
+	vector<int> timePeak;
+
+	void FillBlock(Event *event, Int_t firstPixel);
+	void ExtractBlock(Int_t firstPixel);
+
+public:
+	//Constructor
+	PulseBatch(ReadConfiguration *config);
+	//Destructor
+	~PulseBatch();
+
+	void Extract(Event *event);
+
+	Int_t GetNPixels();
+	const char *GetInstructionSet();
+	Double_t GetPedestal(int pixID);
+	float GetPedestalRMS(int pixID);
+	int GetAmplitude(int pixID);
+	int GetCharge(int pixID);
+	int GetTimePeak(int pixID);
+};
+#endif
@@ -27,6 +27,9 @@ public:
 	Bool_t isFlightMode;
 	Bool_t isDiscriminator;
 	Bool_t isSoftwareThreshold;
+	Bool_t columnarExtracted;
+	Bool_t isPipeline;
+	Bool_t keepIntermediate;
 
 	Int_t timeWindowStart;
 	Int_t timeWindowEnd;
@@ -41,6 +44,10 @@ public:
 	Int_t softwareThresholdLvl;
 	Int_t goldPlatedThresholdLvl;
 
+	Int_t nThreads;
+	// above it the pipeline keeps its intermediate trees on disk
+	Int_t memoryLimitMB;
+
 protected:
 	void ReadLine(string iline, ifstream *inFileStream);
 	string BoolToStringAction(Bool_t stage_status);
@@ -1,4 +1,6 @@
 #include "Event.h"
+#include <TMath.h>
+#include <algorithm>
 
 using namespace std;
 
@@ -8,7 +10,8 @@ Event::Event(){
 	cobo_time = 0;
 	unix_time = 0;
 	
-	signalValue = vector<vector<Int_t>>(512,vector<Int_t>(512));
+	nPixels = 0;
+	nSamples = 0;
 	roiMusicID = vector<Int_t>(36);
 	roiPixelID = vector<Int_t>(2);
 }
@@ -43,13 +46,120 @@ void Event::SetROIPixelID(vector<Int_t> pixIDs){
 	roiPixelID = pixIDs;
 }
 
-void Event::SetSignalValue(vector<vector<Int_t>> signalTrace){
-	signalValue = signalTrace;
-	/*for(int i = 0; i< 512; i++){
-		cout<<signalValue[0][i]<<endl;
-	}*/
+/**
+ * Copies traces given as one vector per pixel into the flat storage.
+ * Samples are 12-bit ADC values, they are stored as UShort_t.
+ */
+void Event::SetSignalValue(const vector<vector<Int_t>> &signalTrace){
+	Int_t nBuckets = signalTrace.empty() ? 0 : signalTrace[0].size();
+	SetTraceSize(signalTrace.size(), nBuckets);
+	for(Int_t i = 0; i < nPixels; i++){
+		UShort_t *trace = &traces[i*nSamples];
+		Int_t n = TMath::Min((Int_t)signalTrace[i].size(), nSamples);
+		for(Int_t j = 0; j < n; j++){
+			trace[j] = signalTrace[i][j];
+		}
+	}
 }
 
+/**
+ * Sets the shape of the flat trace storage. The buffer is only reallocated
+ * when the shape changes, so an Event reused for every entry allocates once.
+ */
+void Event::SetTraceSize(Int_t nPix, Int_t nBuckets){
+	signalValue.clear();
+	if(nPix != nPixels || nBuckets != nSamples || !storedPixelID.empty()){
+		nPixels = nPix;
+		nSamples = nBuckets;
+		storedPixelID.clear();
+		pedestalMean.clear();
+		pedestalRMS.clear();
+		traces.assign((size_t)nPixels*nSamples, 0);
+	}
+}
+
+void Event::ClearTraces(){
+	ConvertLegacyTraces();
+	std::fill(traces.begin(), traces.end(), 0);
+}
+
+/**
+ * Writable access to the flat storage, nPixels x nSamples samples.
+ */
+UShort_t *Event::GetTraceBuffer(){
+	ConvertLegacyTraces();
+	return traces.empty() ? 0 : &traces[0];
+}
+
+/**
+ * Makes the event sparse: only the traces of pixIDs are kept, every other pixel
+ * is reduced to the mean and RMS of its trace. Readers get a flat trace at the
+ * pedestal mean from GetSignalValue() for the pixels that were dropped.
+ * The buffer keeps its capacity, so SetTraceSize() restores the full shape of a
+ * reused Event without reallocating.
+ * @param pixIDs pixels whose traces are kept, any order, out of range IDs ignored
+ */
+void Event::KeepPixels(const vector<Int_t> &pixIDs){
+	ConvertLegacyTraces();
+	if(!storedPixelID.empty()) return;
+
+	pedestalMean.assign(nPixels, 0.);
+	pedestalRMS.assign(nPixels, 0.);
+	for(Int_t i = 0; i < nPixels; i++){
+		const UShort_t *trace = &traces[(size_t)i*nSamples];
+		Double_t sum = 0.;
+		Double_t sum2 = 0.;
+		for(Int_t j = 0; j < nSamples; j++){
+			sum += trace[j];
+			sum2 += (Double_t)trace[j]*trace[j];
+		}
+		if(nSamples > 0){
+			Double_t mean = sum/nSamples;
+			pedestalMean[i] = mean;
+			pedestalRMS[i] = TMath::Sqrt(TMath::Max(sum2/nSamples - mean*mean, 0.));
+		}
+	}
+
+	for(size_t k = 0; k < pixIDs.size(); k++){
+		if(pixIDs[k] >= 0 && pixIDs[k] < nPixels) storedPixelID.push_back(pixIDs[k]);
+	}
+	std::sort(storedPixelID.begin(), storedPixelID.end());
+	storedPixelID.erase(std::unique(storedPixelID.begin(), storedPixelID.end()), storedPixelID.end());
+
+	// traces move towards the front only, in increasing pixel order
+	for(size_t k = 0; k < storedPixelID.size(); k++){
+		std::copy(traces.begin()+(size_t)storedPixelID[k]*nSamples, traces.begin()+(size_t)(storedPixelID[k]+1)*nSamples, traces.begin()+k*nSamples);
+	}
+	traces.resize(storedPixelID.size()*nSamples);
+	// an empty list still has to mark the event as sparse
+	if(storedPixelID.empty()) storedPixelID.push_back(-1);
+}
+
+/**
+ * Position of a pixel in the trace storage.
+ * @return -1 if the trace of the pixel is not stored
+ */
+Int_t Event::FindStoredPixel(int pixID){
+	Int_t indx = -1;
+	if(storedPixelID.empty()){
+		if(pixID >= 0 && pixID < nPixels) indx = pixID;
+	}else{
+		vector<Int_t>::iterator it = std::lower_bound(storedPixelID.begin(), storedPixelID.end(), pixID);
+		if(pixID >= 0 && it != storedPixelID.end() && *it == pixID) indx = it - storedPixelID.begin();
+	}
+	return indx;
+}
+
+/**
+ * Moves traces read from an old file into the flat storage. ROOT refills
+ * signalValue for every entry of such a file, so this runs once per entry.
+ */
+void Event::ConvertLegacyTraces(){
+	if(signalValue.empty()) return;
+	vector<vector<Int_t>> legacy;
+	legacy.swap(signalValue);
+	SetSignalValue(legacy);
+}
 
 ULong64_t Event::GetCoBoTime(){
 	return cobo_time;
@@ -70,10 +180,103 @@ vector<Int_t> Event::GetROIPixelID(){
 	return roiPixelID;
 }
 vector<vector<Int_t>> Event::GetSignalValue(){
-	return signalValue;
+	ConvertLegacyTraces();
+	vector<vector<Int_t>> signalTrace(nPixels);
+	for(Int_t i = 0; i < nPixels; i++){
+		signalTrace[i] = GetSignalValue(i);
+	}
+	return signalTrace;
 }
 
+/**
+ * Copy of the trace of one pixel. Pixels beyond the stored ones (e.g. an AsAd
+ * that was not read out) give a trace of zeros, pixels dropped from a sparse
+ * event a flat trace at their pedestal mean.
+ */
 vector<Int_t> Event::GetSignalValue(int pixID){
-	return signalValue[pixID];
+	ConvertLegacyTraces();
+	Int_t indx = FindStoredPixel(pixID);
+	vector<Int_t> signalTrace;
+	if(indx >= 0){
+		signalTrace.assign(traces.begin()+indx*nSamples, traces.begin()+(indx+1)*nSamples);
+	}else if(pixID >= 0 && pixID < nPixels){
+		signalTrace.assign(nSamples, TMath::Nint(pedestalMean[pixID]));
+	}else{
+		signalTrace.assign(nSamples, 0);
+	}
+	return signalTrace;
 }
 
+/**
+ * Trace of one pixel without copy, GetNSamples() samples long.
+ * The pointer stays valid until the next entry is read or the shape changes.
+ * @return NULL for pixels beyond the stored ones and pixels dropped from a sparse event
+ */
+const UShort_t *Event::GetTrace(int pixID){
+	ConvertLegacyTraces();
+	Int_t indx = FindStoredPixel(pixID);
+	if(indx < 0) return 0;
+	return &traces[indx*nSamples];
+}
+
+/**
+ * Trace of one pixel as GetSignalValue(pixID) gives it, GetNSamples() samples long,
+ * without copying stored traces. Pixels without a stored trace get their flat trace
+ * written to flatTrace, so a buffer reused for every pixel allocates once.
+ * The pointer stays valid until the next entry is read, or flatTrace is changed.
+ */
+const UShort_t *Event::GetSignalRow(int pixID, vector<UShort_t> &flatTrace){
+	const UShort_t *row = GetTrace(pixID);
+	if(row == 0){
+		UShort_t flat = 0;
+		if(pixID >= 0 && pixID < (Int_t)pedestalMean.size()) flat = TMath::Nint(pedestalMean[pixID]);
+		flatTrace.assign(nSamples, flat);
+		row = nSamples > 0 ? &flatTrace[0] : 0;
+	}
+	return row;
+}
+
+Int_t Event::GetNPixels(){
+	ConvertLegacyTraces();
+	return nPixels;
+}
+
+Int_t Event::GetNSamples(){
+	ConvertLegacyTraces();
+	return nSamples;
+}
+
+Bool_t Event::IsTraceStored(int pixID){
+	ConvertLegacyTraces();
+	return FindStoredPixel(pixID) >= 0;
+}
+
+/**
+ * Pixels whose traces are stored, all pixels for events that are not sparse.
+ */
+vector<Int_t> Event::GetStoredPixelID(){
+	ConvertLegacyTraces();
+	vector<Int_t> pixIDs;
+	if(storedPixelID.empty()){
+		for(Int_t i = 0; i < nPixels; i++) pixIDs.push_back(i);
+	}else if(storedPixelID[0] >= 0){
+		pixIDs = storedPixelID;
+	}
+	return pixIDs;
+}
+
+/**
+ * Mean of the trace of a pixel, only recorded for sparse events.
+ * @return 0 for events holding all traces
+ */
+Float_t Event::GetPedestalMean(int pixID){
+	Float_t mean = 0.;
+	if(pixID >= 0 && pixID < (Int_t)pedestalMean.size()) mean = pedestalMean[pixID];
+	return mean;
+}
+
+Float_t Event::GetPedestalRMS(int pixID){
+	Float_t rms = 0.;
+	if(pixID >= 0 && pixID < (Int_t)pedestalRMS.size()) rms = pedestalRMS[pixID];
+	return rms;
+}
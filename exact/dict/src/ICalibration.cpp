@@ -1,5 +1,9 @@
 #include "ICalibration.h"
 
+#include <cmath>
+#include <map>
+#include <mutex>
+
 
 ICalibration::ICalibration(const std::string& filename)
 {
@@ -65,112 +69,198 @@ std::vector<double> ICalibration::GetVOffsetPx(){
     return volOffsets;
 }
 
-double ICalibration::GetMeasurementFromFile(int pixelID, double sipmTemp, double OperatingVol, std::string filename, std::string measurement, std::string biasVoltageRef){
+std::vector<double> ICalibration::GetRelativeGain(double sipmTemp, double OperatingVol){
+    int size = sizeof(VOffsetPx)/sizeof(VOffsetPx[0]);
+    std::vector<double> relativeGains(size);
+    for(int pixelID = 0; pixelID < size; pixelID++){
+        relativeGains[pixelID] = GetRelativeGain(pixelID, sipmTemp, OperatingVol);
+    }
+    return relativeGains;
+}
 
-    std::transform(biasVoltageRef.begin(), biasVoltageRef.end(), biasVoltageRef.begin(), ::toupper);
+/*
+ * Calibration files are read once and kept as tables: for every measurement asked for, the
+ * curves of operating voltage against measured value, one per temperature, sorted by
+ * temperature. Lookups are binary searches on these tables.
+ */
+namespace {
+
+struct CalibrationCurve {
+    double temperature;
+    // position in the file, the first of two equally close temperatures is used
+    int order;
+    std::vector<double> opVol;
+    std::vector<double> meas;
+};
+
+bool CompareTemperature(const CalibrationCurve &a, const CalibrationCurve &b){
+    return a.temperature < b.temperature || (a.temperature == b.temperature && a.order < b.order);
+}
 
-    if(biasVoltageRef.compare("ABS")==0){
-        OperatingVol = OperatingVol - VOffsetPx[pixelID]/1000.0;
-    }else if(biasVoltageRef.compare("REL")==0){
-        OperatingVol = GetOverVoltage(pixelID, OperatingVol)/GetRelativeGain(pixelID,sipmTemp,OperatingVol);
+std::map<std::string, std::vector<std::string> > calibrationFiles;
+std::map<std::string, std::vector<CalibrationCurve> > calibrationTables;
+std::mutex calibrationMutex;
+
+const std::vector<std::string>& GetCalibrationFileLines(const std::string &filename){
+    std::map<std::string, std::vector<std::string> >::iterator it = calibrationFiles.find(filename);
+    if(it == calibrationFiles.end()){
+        std::vector<std::string> lines;
+        std::ifstream file(filename);
+        std::string line;
+        while(std::getline(file, line)){
+            lines.push_back(line);
+        }
+        file.close();
+        it = calibrationFiles.insert(std::make_pair(filename, lines)).first;
     }
+    return it->second;
+}
 
-    int closestTempLine = GetClosestTemperatureLine(sipmTemp,filename,measurement);
-
-    //std::cout<<closestTempLine<<std::endl;
-    int iLine = 0;
-    std::ifstream file(filename);
+// 1-based line of the measurement name, compared in upper case, 0 if it is not in the file
+int FindMeasurementLine(const std::vector<std::string> &lines, const std::string &measurement){
     std::string line;
+    int iLine = 0;
+    for(size_t i = 0; i < lines.size() && iLine == 0; i++){
+        line = lines[i];
+        std::transform(line.begin(),line.end(),line.begin(), ::toupper);
+        if(line.compare(measurement)==0){
+            iLine = i + 1;
+        }
+    }
+    return iLine;
+}
 
-    bool isMeasurementFound = false;
-    std::istringstream iss;
-    double opVol, opVolErr, meas, measErr;
-    double measuredValue;
-
-    std::vector<double> vOpVol, vMeas;
-    while(std::getline(file, line) && !isMeasurementFound){
-        if(iLine == closestTempLine){
-            std::getline(file, line);
-            std::getline(file, line);
-            std::getline(file, line);
-            do{ 
-                //std::cout<<line<<std::endl;
-                iss = std::istringstream(line);
+/*
+ * Parses the temperature blocks of a measurement as the file scan did: the line after the
+ * measurement name is not looked at, each "# Temperature" is followed by its value, two
+ * header lines and the data lines up to an empty line, and "***" ends the measurement.
+ */
+std::vector<CalibrationCurve> ParseCalibrationCurves(const std::vector<std::string> &lines, size_t measurementLine){
+    std::vector<CalibrationCurve> curves;
+    for(size_t iLine = measurementLine + 2; iLine < lines.size() && lines[iLine].compare("***") != 0; iLine++){
+        if(lines[iLine] == "# Temperature" && iLine + 1 < lines.size()){
+            CalibrationCurve curve;
+            iLine++;
+            curve.temperature = std::stod(lines[iLine]);
+            curve.order = curves.size();
+
+            double opVol = 0, opVolErr, meas = 0, measErr;
+            size_t iData = iLine + 3;
+            do{
+                std::istringstream iss(iData < lines.size() ? lines[iData] : "");
                 iss >> opVol >> opVolErr >> meas >> measErr;
-                vOpVol.push_back(opVol);
-                vMeas.push_back(meas);
-                std::getline(file, line);
-            }while(!line.empty());
-            isMeasurementFound = true;
+                curve.opVol.push_back(opVol);
+                curve.meas.push_back(meas);
+                iData++;
+            }while(iData < lines.size() && !lines[iData].empty());
+            curves.push_back(curve);
         }
-        iLine++;
     }
+    std::sort(curves.begin(), curves.end(), CompareTemperature);
+    return curves;
+}
 
-    int i = 0;
+const std::vector<CalibrationCurve>& GetCalibrationCurves(const std::string &filename, std::string measurement){
+    std::transform(measurement.begin(), measurement.end(), measurement.begin(), ::toupper);
+
+    std::lock_guard<std::mutex> lock(calibrationMutex);
+    std::string key = filename + "\n" + measurement;
+    std::map<std::string, std::vector<CalibrationCurve> >::iterator it = calibrationTables.find(key);
+    if(it == calibrationTables.end()){
+        const std::vector<std::string> &lines = GetCalibrationFileLines(filename);
+        std::vector<CalibrationCurve> curves;
+        int iLine = FindMeasurementLine(lines, measurement);
+        if(iLine > 0){
+            curves = ParseCalibrationCurves(lines, iLine - 1);
+        }else{
+            std::cout<<"Measurement "<<measurement<<" not found in "<<filename<<std::endl;
+        }
+        it = calibrationTables.insert(std::make_pair(key, curves)).first;
+    }
+    return it->second;
+}
 
-    while(OperatingVol > vOpVol[i] && i < vOpVol.size()){
-        i++;
+// Curve of the temperature closest to sipmTemp, NULL if the measurement has none
+const CalibrationCurve* GetClosestTemperatureCurve(double sipmTemp, const std::vector<CalibrationCurve> &curves){
+    const CalibrationCurve *closest = NULL;
+    CalibrationCurve probe;
+    probe.temperature = sipmTemp;
+    probe.order = -1;
+    std::vector<CalibrationCurve>::const_iterator above = std::lower_bound(curves.begin(), curves.end(), probe, CompareTemperature);
+    if(above != curves.end()){
+        closest = &*above;
+    }
+    if(above != curves.begin()){
+        // first in the file of the temperatures just below
+        probe.temperature = (above - 1)->temperature;
+        const CalibrationCurve *below = &*std::lower_bound(curves.begin(), curves.end(), probe, CompareTemperature);
+        if(closest == NULL || std::abs(sipmTemp - below->temperature) < std::abs(sipmTemp - closest->temperature)
+            || (std::abs(sipmTemp - below->temperature) == std::abs(sipmTemp - closest->temperature) && below->order < closest->order)){
+            closest = below;
+        }
     }
+    return closest;
+}
 
-    measuredValue = IUtilities::Interpolate(vOpVol[i-1],vMeas[i-1],vOpVol[i],vMeas[i],OperatingVol);
-    file.close();
+// Interpolation between the points around OperatingVol, the end segments extrapolate
+double InterpolateCurve(const CalibrationCurve &curve, double OperatingVol){
+    double measuredValue;
+    size_t n = curve.opVol.size();
+    if(n < 2){
+        measuredValue = n == 1 ? curve.meas[0] : 0;
+    }else{
+        size_t i = std::lower_bound(curve.opVol.begin(), curve.opVol.end(), OperatingVol) - curve.opVol.begin();
+        i = std::min(std::max(i, (size_t)1), n - 1);
+        measuredValue = IUtilities::Interpolate(curve.opVol[i-1],curve.meas[i-1],curve.opVol[i],curve.meas[i],OperatingVol);
+    }
     return measuredValue;
 }
 
-int ICalibration::GetMeasurementLine(std::string filename, std::string measurement){
-    std::transform(measurement.begin(), measurement.end(), measurement.begin(), ::toupper);
+double BiasVoltage(int pixelID, double sipmTemp, double OperatingVol, const std::string &biasVoltageRef){
+    if(biasVoltageRef.compare("ABS")==0){
+        OperatingVol = OperatingVol - VOffsetPx[pixelID]/1000.0;
+    }else if(biasVoltageRef.compare("REL")==0){
+        OperatingVol = ICalibration::GetOverVoltage(pixelID, OperatingVol)/ICalibration::GetRelativeGain(pixelID,sipmTemp,OperatingVol);
+    }
+    return OperatingVol;
+}
 
-    std::ifstream file(filename);
-    std::string line;
-    int iLine = 0;
-    int ctr = 0;
-    do{
-        std::getline(file,line);
-       //std::cout<<line<<std::endl;
-        iLine = ++ctr;
-        std::transform(line.begin(),line.end(),line.begin(), ::toupper);
-    }while(line.compare(measurement)!=0);
-    
-    file.close();
+}
 
-    return iLine;
+double ICalibration::GetMeasurementFromFile(int pixelID, double sipmTemp, double OperatingVol, std::string filename, std::string measurement, std::string biasVoltageRef){
+
+    std::transform(biasVoltageRef.begin(), biasVoltageRef.end(), biasVoltageRef.begin(), ::toupper);
+
+    OperatingVol = BiasVoltage(pixelID, sipmTemp, OperatingVol, biasVoltageRef);
+
+    double measuredValue = 0;
+    const CalibrationCurve *curve = GetClosestTemperatureCurve(sipmTemp, GetCalibrationCurves(filename, measurement));
+    if(curve){
+        measuredValue = InterpolateCurve(*curve, OperatingVol);
+    }
+    return measuredValue;
 }
 
-int ICalibration::GetClosestTemperatureLine(double sipmTemp, std::string filename, std::string measurement){
+std::vector<double> ICalibration::GetMeasurementFromFile(double sipmTemp, double OperatingVol, std::string filename, std::string measurement, std::string biasVoltageRef){
 
-    int iMeasurementLine = GetMeasurementLine(filename, measurement);
-    //std::cout<<iMeasurementLine<<std::endl;
-    std::ifstream file(filename);
-    std::string line;
-    double difference = 1000;
-    int closestTemp = 0;
-    bool isMeasurementFound = false;
-    bool isMeasurementFinished = false;
-    int iLine = 0;
+    std::transform(biasVoltageRef.begin(), biasVoltageRef.end(), biasVoltageRef.begin(), ::toupper);
 
-    while(std::getline(file,line) && !isMeasurementFound){
-        if(iLine == iMeasurementLine){
-            isMeasurementFound = true;
-            while(std::getline(file,line) && !isMeasurementFinished){
-                iLine++;
-                if(line == "# Temperature"){
-                    std::getline(file, line);
-                    iLine++;
-                    if(std::abs(sipmTemp - std::stod(line)) < difference){
-                        difference = std::abs(sipmTemp - std::stod(line));
-                        closestTemp = iLine;
-                    }
-                }else if(line.compare("***") == 0){
-                    isMeasurementFinished = true;
-                }
-            }
+    int size = sizeof(VOffsetPx)/sizeof(VOffsetPx[0]);
+    std::vector<double> measuredValues(size, 0);
+    const CalibrationCurve *curve = GetClosestTemperatureCurve(sipmTemp, GetCalibrationCurves(filename, measurement));
+    if(curve){
+        for(int pixelID = 0; pixelID < size; pixelID++){
+            measuredValues[pixelID] = InterpolateCurve(*curve, BiasVoltage(pixelID, sipmTemp, OperatingVol, biasVoltageRef));
         }
-        iLine++;
     }
+    return measuredValues;
+}
 
-    file.close();
+int ICalibration::GetMeasurementLine(std::string filename, std::string measurement){
+    std::transform(measurement.begin(), measurement.end(), measurement.begin(), ::toupper);
 
-    return closestTemp;
+    std::lock_guard<std::mutex> lock(calibrationMutex);
+    return FindMeasurementLine(GetCalibrationFileLines(filename), measurement);
 }
 
 
@@ -1,5 +1,7 @@
 #include "IEvent.h"
 
+#include <stdexcept>
+
 IEvent::IEvent(){
 	//Iazimuth = 0;
 	//Ialtitude = 0;
@@ -129,102 +131,93 @@ IEvent::IEvent(){
 //     file2.close();
 // }
 
-void IEvent::SetParametersFromTimestamp(int timestamp,std::vector<std::vector<std::string>> data, std::vector<std::vector<std::string>> data2) {
-    // Find closest timestamp in the first file
-    int closestTimestamp1 = findClosestTimestamp(data, timestamp);
-   /* if (closestTimestamp1 != timestamp) {
-        std::cout << "Given timestamp not found in the first file. Closest timestamp is: " << closestTimestamp1 << std::endl;
-    }*/
-
-    // Find closest timestamp in the second file
-    int closestTimestamp2 = findClosestTimestamp(data2, timestamp);
-    /*if (closestTimestamp2 != timestamp) {
-        std::cout << "Given timestamp not found in the second file. Closest timestamp is: " << closestTimestamp2 << std::endl;
-    }*/
-
-    // Set parameters from the first file
-    for (int i = 0; i < data.size(); ++i) {
-        if (std::stoi(data[i][0]) == closestTimestamp1) {
-            latitude = std::stof(data[i][1]);
-            longitude = std::stof(data[i][2]);
-            altitude = std::stoi(data[i][3]);
-            sunAzimuth = std::stof(data[i][4]);
-            sunElevation = std::stof(data[i][5]);
-            moonAzimuth = std::stof(data[i][6]);
-            moonElevation = std::stof(data[i][7]);
-            horizon = std::stof(data[i][8]);
-            azimuth = std::stof(data[i][9]);
-            break;
-        }
+void IEvent::SetParametersFromTimestamp(int timestamp,const std::vector<std::vector<std::string>> &data, const std::vector<std::vector<std::string>> &data2) {
+    SetParametersFromTimestamp(timestamp, IHousekeeping(data), IHousekeeping(data2));
+}
+
+void IEvent::SetParametersFromTimestamp(int timestamp, const IHousekeeping &data, const IHousekeeping &data2) {
+    // Set parameters from the closest record of the first file
+    int i = data.FindClosestEntry(timestamp);
+    if (i >= 0) {
+        latitude = data.GetValue(i, 1);
+        longitude = data.GetValue(i, 2);
+        altitude = data.GetValue(i, 3);
+        sunAzimuth = data.GetValue(i, 4);
+        sunElevation = data.GetValue(i, 5);
+        moonAzimuth = data.GetValue(i, 6);
+        moonElevation = data.GetValue(i, 7);
+        horizon = data.GetValue(i, 8);
+        azimuth = data.GetValue(i, 9);
     }
 
-    // Set parameters from the second file
-    for (int i = 0; i < data2.size(); ++i) {
-        if (std::stoi(data2[i][0]) == closestTimestamp2) {
-            TrigEvent = std::stoi(data2[i][1]);
-            TempFlag = std::stoi(data2[i][2]);
-            emon1 = std::stoi(data2[i][3]);
-            emon2 = std::stoi(data2[i][4]);
-            for (int j = 0; j < 8; ++j) {
-                hv[j] = std::stof(data2[i][j + 5]);
-            }
-            for (int j = 0; j < 8; ++j) {
-                hvc[j] = std::stof(data2[i][j + 13]);
-            }
-            for (int j = 0; j < 32; ++j) {
-                ucTemp[j] = std::stof(data2[i][j + 21]);
-            }
-            CpuTemp = std::stoi(data2[i][53]);
-            CoboTemp = std::stoi(data2[i][54]);
-            RadTemp = std::stoi(data2[i][55]);
-            lvpsVol = std::stof(data2[i][56]);
-            pumpVol = std::stof(data2[i][58]);
-            lvpsCur = std::stoi(data2[i][57]);
-            pumpCur = std::stoi(data2[i][59]);
-            for (int j = 0; j < 32; ++j) {
-                siabMPWR[j] = std::stoi(data2[i][j + 60]);
-            }
-            for (int j = 0; j < 32; ++j) {
-                hvSW[j] = std::stoi(data2[i][j + 91]);
-            }
-            for (int j = 0; j < 32; ++j) {
-                sipmTemp[j] = std::stof(data2[i][j + 122]);
-            }
-            break;
+    // Set parameters from the closest record of the second file
+    i = data2.FindClosestEntry(timestamp);
+    if (i >= 0) {
+        TrigEvent = data2.GetValue(i, 1);
+        TempFlag = data2.GetValue(i, 2);
+        emon1 = data2.GetValue(i, 3);
+        emon2 = data2.GetValue(i, 4);
+        for (int j = 0; j < 8; ++j) {
+            hv[j] = data2.GetValue(i, j + 5);
+        }
+        for (int j = 0; j < 8; ++j) {
+            hvc[j] = data2.GetValue(i, j + 13);
+        }
+        for (int j = 0; j < 32; ++j) {
+            ucTemp[j] = data2.GetValue(i, j + 21);
+        }
+        CpuTemp = data2.GetValue(i, 53);
+        CoboTemp = data2.GetValue(i, 54);
+        RadTemp = data2.GetValue(i, 55);
+        lvpsVol = data2.GetValue(i, 56);
+        pumpVol = data2.GetValue(i, 58);
+        lvpsCur = data2.GetValue(i, 57);
+        pumpCur = data2.GetValue(i, 59);
+        for (int j = 0; j < 32; ++j) {
+            siabMPWR[j] = data2.GetValue(i, j + 60);
+        }
+        for (int j = 0; j < 32; ++j) {
+            hvSW[j] = data2.GetValue(i, j + 91);
+        }
+        for (int j = 0; j < 32; ++j) {
+            sipmTemp[j] = data2.GetValue(i, j + 122);
         }
     }
 }
 
-void IEvent::SetTelescopePointing (int timestamp,std::vector<std::vector<std::string>> data){
-
-    int nearTimeStamp = findClosestTimestamp(data, timestamp);
-    bool isFound = false;
-    int i = 0;
+void IEvent::SetTelescopePointing (int timestamp,const std::vector<std::vector<std::string>> &data){
+    SetTelescopePointing(timestamp, IHousekeeping(data));
+}
 
-   while(!isFound && i<data.size()){
-        if (std::stoi(data[i][0]) == nearTimeStamp) {
-            tiltAngle = std::stof(data[i][3]);
-            isFound = true;
+void IEvent::SetTelescopePointing(int timestamp, const IHousekeeping &data){
+    int i = data.FindClosestEntry(timestamp);
+    if (i >= 0) {
+        // the tilt angle is the fourth column, GetValue() would give 0 for a shorter table
+        if (data.GetNColumns() < 4) {
+            throw std::runtime_error("Tilt table has no tilt angle column (4 columns expected)");
         }
-        i++;
+        tiltAngle = data.GetValue(i, 3);
     }
-
 }
 
-void IEvent::SetTelescopePointingRaw(int timestamp,std::vector<std::vector<std::string>> data){
-
-    int nearTimeStamp = findClosestTimestamp(data, timestamp);
-    bool isFound = false;
-    int i = 0;
+void IEvent::SetTelescopePointingRaw(int timestamp,const std::vector<std::vector<std::string>> &data){
+    SetTelescopePointingRaw(timestamp, IHousekeeping(data));
+}
 
-   while(!isFound && i<data.size()){
-        if (std::stoi(data[i][0]) == nearTimeStamp) {
-            tiltAngleRaw = std::stof(data[i][1]);
-            isFound = true;
+void IEvent::SetTelescopePointingRaw(int timestamp, const IHousekeeping &data){
+    int i = data.FindClosestEntry(timestamp);
+    if (i >= 0) {
+        if (data.GetNColumns() < 2) {
+            throw std::runtime_error("Raw tilt table has no tilt angle column (2 columns expected)");
         }
-        i++;
+        tiltAngleRaw = data.GetValue(i, 1);
     }
+}
 
+void IEvent::SetHousekeeping(int timestamp, const IHousekeeping &data, const IHousekeeping &data2, const IHousekeeping &dataTilt, const IHousekeeping &dataTiltRaw){
+    SetParametersFromTimestamp(timestamp, data, data2);
+    SetTelescopePointing(timestamp, dataTilt);
+    SetTelescopePointingRaw(timestamp, dataTiltRaw);
 }
 
 int IEvent::GetclosestTimestamp1() const {
@@ -339,23 +332,6 @@ const std::vector<float>& IEvent::GetSiPMTemp() const {
     return sipmTemp;
 }
 
-int IEvent::findClosestTimestamp(const std::vector<std::vector<std::string>>& data, int timestamp) const {
-    int closestTimestamp = std::stoi(data[0][0]);
-    int minDifference = std::abs(timestamp - closestTimestamp);
-
-    for (int i = 1; i < data.size(); ++i) {
-        int currentTimestamp = std::stoi(data[i][0]);
-        int difference = std::abs(timestamp - currentTimestamp);
-
-        if (difference < minDifference) {
-            minDifference = difference;
-            closestTimestamp = currentTimestamp;
-        }
-    }
-
-    return closestTimestamp;
-}
-
 int IEvent::FindClosestTimestampIndex(std::vector<unsigned long long> timeArray, unsigned long long eventTime){
     unsigned long long closestTimestamp = timeArray[0];
     unsigned long long minDifference = std::abs((long long int)(eventTime - closestTimestamp));
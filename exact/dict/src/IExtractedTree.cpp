@@ -0,0 +1,184 @@
+#include "IExtractedTree.h"
+
+#include <TString.h>
+#include <TLeaf.h>
+#include <iostream>
+
+IExtractedTree::IExtractedTree(TTree *tree, int nPix){
+	ITTree = tree;
+	Init(nPix, IsColumnar(tree));
+
+	if(isColumnar){
+		// ROOT fills the whole array of the file, the buffers must hold it
+		ResizeToLeaf("Amplitude", amplitude);
+		ResizeToLeaf("Charge", charge);
+		ResizeToLeaf("TimePeak", timePeak);
+		ResizeToLeaf("Pedestal", pedestal);
+		ResizeToLeaf("PedestalRMS", pedestalRMS);
+
+		ITTree->SetBranchAddress("Amplitude", &amplitude[0]);
+		ITTree->SetBranchAddress("Charge", &charge[0]);
+		ITTree->SetBranchAddress("TimePeak", &timePeak[0]);
+		ITTree->SetBranchAddress("Pedestal", &pedestal[0]);
+		ITTree->SetBranchAddress("PedestalRMS", &pedestalRMS[0]);
+	}else{
+		for(int i = 0; i<nPixels; i++){
+			ITTree->SetBranchAddress(TString::Format("Pixel[%d]",i), &pixels[i]);
+		}
+	}
+	ITTree->SetBranchAddress("TriggerTime", &triggerTime);
+	if(ITTree->GetBranch("TriggerRegion")){
+		triggerRegion = new BiFocal();
+		ITTree->SetBranchAddress("TriggerRegion", &triggerRegion);
+	}
+}
+
+IExtractedTree::IExtractedTree(TTree *tree, int nPix, bool columnar, bool withTriggerRegion){
+	ITTree = tree;
+	Init(nPix, columnar);
+
+	if(isColumnar){
+		ITTree->Branch("Amplitude", &amplitude[0], TString::Format("Amplitude[%d]/s",nPixels), 64000);
+		ITTree->Branch("Charge", &charge[0], TString::Format("Charge[%d]/s",nPixels), 64000);
+		ITTree->Branch("TimePeak", &timePeak[0], TString::Format("TimePeak[%d]/s",nPixels), 64000);
+		ITTree->Branch("Pedestal", &pedestal[0], TString::Format("Pedestal[%d]/s",nPixels), 64000);
+		ITTree->Branch("PedestalRMS", &pedestalRMS[0], TString::Format("PedestalRMS[%d]/F",nPixels), 64000);
+	}else{
+		for(int i = 0; i<nPixels; i++){
+			ITTree->Branch(TString::Format("Pixel[%d]",i), "ExtractedData", &pixels[i], 64000, 0);
+		}
+	}
+	ITTree->Branch("TriggerTime", &triggerTime);
+	if(withTriggerRegion){
+		triggerRegion = new BiFocal();
+		ITTree->Branch("TriggerRegion", "BiFocal", &triggerRegion, 64000, 0);
+	}
+}
+
+void IExtractedTree::Init(int nPix, bool columnar){
+	nPixels = nPix;
+	isColumnar = columnar;
+	triggerTime = 0;
+	triggerRegion = 0;
+
+	pixels = std::vector<ExtractedData*>(nPixels);
+	for(int i = 0; i<nPixels; i++){
+		pixels[i] = new ExtractedData();
+	}
+	if(isColumnar){
+		amplitude = std::vector<unsigned short>(nPixels, 0);
+		charge = std::vector<unsigned short>(nPixels, 0);
+		timePeak = std::vector<unsigned short>(nPixels, 0);
+		pedestal = std::vector<unsigned short>(nPixels, 0);
+		pedestalRMS = std::vector<float>(nPixels, 0);
+	}
+}
+
+template<typename T> void IExtractedTree::ResizeToLeaf(const char *name, std::vector<T> &buffer){
+	TLeaf *leaf = ITTree->GetLeaf(name);
+	int length = leaf ? leaf->GetLen() : 0;
+	if(length != nPixels){
+		std::cout<<"Warning: branch "<<name<<" holds "<<length<<" pixels, "<<nPixels<<" expected"<<std::endl;
+	}
+	if(length > (int)buffer.size()){
+		buffer.resize(length, 0);
+	}
+}
+
+IExtractedTree::~IExtractedTree(){
+	for(int i = 0; i<nPixels; i++){
+		delete pixels[i];
+	}
+	delete triggerRegion;
+}
+
+bool IExtractedTree::IsColumnar(TTree *tree){
+	return tree->GetBranch("Amplitude") != 0;
+}
+
+bool IExtractedTree::IsColumnar(){
+	return isColumnar;
+}
+
+int IExtractedTree::GetNPixels(){
+	return nPixels;
+}
+
+Long64_t IExtractedTree::GetEntries(){
+	return ITTree->GetEntries();
+}
+
+Int_t IExtractedTree::GetEntry(Long64_t entry){
+	Int_t nBytes = ITTree->GetEntry(entry);
+
+	// GetPixel serves both layouts
+	if(isColumnar){
+		for(int i = 0; i<nPixels; i++){
+			pixels[i]->SetAmplitude(amplitude[i]);
+			pixels[i]->SetCharge(charge[i]);
+			pixels[i]->SetTimePeak(timePeak[i]);
+			pixels[i]->SetPedestal(pedestal[i]);
+			pixels[i]->SetPedestalRMS(pedestalRMS[i]);
+		}
+	}
+	return nBytes;
+}
+
+ExtractedData* IExtractedTree::GetPixel(int pixID){
+	return pixels[pixID];
+}
+
+unsigned short IExtractedTree::GetAmplitude(int pixID){
+	return pixels[pixID]->GetAmplitude();
+}
+
+unsigned short IExtractedTree::GetCharge(int pixID){
+	return pixels[pixID]->GetCharge();
+}
+
+unsigned short IExtractedTree::GetTimePeak(int pixID){
+	return pixels[pixID]->GetTimePeak();
+}
+
+unsigned short IExtractedTree::GetPedestal(int pixID){
+	return pixels[pixID]->GetPedestal();
+}
+
+float IExtractedTree::GetPedestalRMS(int pixID){
+	return pixels[pixID]->GetPedestalRMS();
+}
+
+unsigned long long IExtractedTree::GetTriggerTime(){
+	return triggerTime;
+}
+
+BiFocal* IExtractedTree::GetTriggerRegion(){
+	return triggerRegion;
+}
+
+void IExtractedTree::SetPixel(int pixID, ExtractedData *ex){
+	if(isColumnar){
+		amplitude[pixID] = ex->GetAmplitude();
+		charge[pixID] = ex->GetCharge();
+		timePeak[pixID] = ex->GetTimePeak();
+		pedestal[pixID] = ex->GetPedestal();
+		pedestalRMS[pixID] = ex->GetPedestalRMS();
+	}else{
+		pixels[pixID]->Copy(ex);
+	}
+}
+
+void IExtractedTree::SetTriggerTime(unsigned long long time){
+	triggerTime = time;
+}
+
+void IExtractedTree::SetTriggerRegion(vector<int> roiPixelIDs, vector<int> trigMusicIDs){
+	if(triggerRegion){
+		triggerRegion->SetROIPixelIDs(roiPixelIDs);
+		triggerRegion->SetTrigMUSICIDs(trigMusicIDs);
+	}
+}
+
+Int_t IExtractedTree::Fill(){
+	return ITTree->Fill();
+}
@@ -0,0 +1,152 @@
+#include "IHealthScanResult.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+IHealthScanResult::IHealthScanResult(int nPix, bool keep){
+	Reset(nPix, keep);
+}
+
+void IHealthScanResult::Reset(int nPix, bool keep){
+	nPixels = nPix;
+	keepValues = keep;
+	nRejected = 0;
+	nGoodEvents = 0;
+
+	entries.clear();
+	eventTimes.clear();
+	badEvents.clear();
+	values.assign(kNMeasurements, std::vector<float>());
+	cameraMeans.assign(kNMeasurements, std::vector<float>());
+	sums.assign(kNMeasurements, std::vector<double>(nPixels, 0.));
+	sumsSquared.assign(kNMeasurements, std::vector<double>(nPixels, 0.));
+}
+
+void IHealthScanResult::AddEntry(int entry, unsigned long long eventTime, bool isBadEvent, const std::vector<std::vector<float>> &entryValues){
+	entries.push_back(entry);
+	eventTimes.push_back(eventTime);
+	badEvents.push_back(isBadEvent);
+	if(!isBadEvent){
+		nGoodEvents++;
+	}
+
+	for(int k = 0; k < kNMeasurements; k++){
+		const std::vector<float> &v = entryValues[k];
+		double cameraSum = 0;
+		for(int j = 0; j < nPixels; j++){
+			cameraSum += v[j];
+		}
+		cameraMeans[k].push_back(nPixels > 0 ? cameraSum/nPixels : 0.);
+
+		if(!isBadEvent){
+			for(int j = 0; j < nPixels; j++){
+				sums[k][j] += v[j];
+				sumsSquared[k][j] += (double)v[j]*v[j];
+			}
+		}
+		if(keepValues){
+			values[k].insert(values[k].end(), v.begin(), v.begin() + nPixels);
+		}
+	}
+}
+
+void IHealthScanResult::AddRejected(){
+	nRejected++;
+}
+
+int IHealthScanResult::GetNPixels() const{
+	return nPixels;
+}
+
+int IHealthScanResult::GetNEntries() const{
+	return entries.size();
+}
+
+int IHealthScanResult::GetNRejected() const{
+	return nRejected;
+}
+
+int IHealthScanResult::GetNBadEvents() const{
+	return entries.size() - nGoodEvents;
+}
+
+int IHealthScanResult::GetEntry(int i) const{
+	return entries[i];
+}
+
+unsigned long long IHealthScanResult::GetEventTime(int i) const{
+	return eventTimes[i];
+}
+
+bool IHealthScanResult::IsBadEvent(int i) const{
+	return badEvents[i];
+}
+
+std::vector<float> IHealthScanResult::GetCameraValues(int measurementID, int i) const{
+	std::vector<float> cameraValues;
+	if(keepValues){
+		std::vector<float>::const_iterator first = values[measurementID].begin() + (size_t)i*nPixels;
+		cameraValues.assign(first, first + nPixels);
+	}
+	return cameraValues;
+}
+
+float IHealthScanResult::GetValue(int measurementID, int i, int pixID) const{
+	float value = 0;
+	if(keepValues){
+		value = values[measurementID][(size_t)i*nPixels + pixID];
+	}
+	return value;
+}
+
+float IHealthScanResult::GetCameraMean(int measurementID, int i) const{
+	return cameraMeans[measurementID][i];
+}
+
+std::vector<float> IHealthScanResult::GetPixelMean(int measurementID) const{
+	std::vector<float> mean(nPixels, 0);
+	if(nGoodEvents > 0){
+		for(int j = 0; j < nPixels; j++){
+			mean[j] = sums[measurementID][j]/nGoodEvents;
+		}
+	}
+	return mean;
+}
+
+std::vector<float> IHealthScanResult::GetPixelRMS(int measurementID) const{
+	std::vector<float> rms(nPixels, 0);
+	if(nGoodEvents > 0){
+		for(int j = 0; j < nPixels; j++){
+			double mean = sums[measurementID][j]/nGoodEvents;
+			rms[j] = std::sqrt(std::max(0., sumsSquared[measurementID][j]/nGoodEvents - mean*mean));
+		}
+	}
+	return rms;
+}
+
+int IHealthScanResult::GetMeasurementID(std::string measurement){
+	std::transform(measurement.begin(),measurement.end(),measurement.begin(),::toupper);
+	measurement.erase(std::remove(measurement.begin(),measurement.end(),' '),measurement.end());
+	int measurementID = -1;
+
+	if(measurement.compare("PEDESTAL")==0){
+		measurementID = kPedestal;
+	}else if(measurement.compare("PEDESTALRMS")==0){
+		measurementID = kPedestalRMS;
+	}else if(measurement.compare("AMPLITUDE")==0){
+		measurementID = kAmplitude;
+	}else if(measurement.compare("CHARGE")==0){
+		measurementID = kCharge;
+	}else if(measurement.compare("PEAKINGTIME")==0){
+		measurementID = kPeakingTime;
+	}else{
+		std::cout<<"Measurement Name not found!"<<std::endl;
+	}
+
+	return measurementID;
+}
+
+IHealthScanResult::~IHealthScanResult(){
+
+}
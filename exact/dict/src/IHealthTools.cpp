@@ -15,6 +15,40 @@ bool IHealthTools::IsTiltInRange(float fTilt,float fTiltLow,float fTiltHigh){
 
 	return (fTilt>=fTiltLow && fTilt<=fTiltHigh);
 }
+TTree* IHealthTools::GetTree(IFile *file, std::string treeName){
+	TTree *treeIn = NULL;
+	switch(IFile::GetTreeID(treeName)){
+		case 0:
+			treeIn = file->treeHLED;
+			break;
+		case 1:
+			treeIn = file->treeBiFocal;
+			break;
+		case 2:
+			treeIn = file->treeTest;
+			break;
+		case 3:
+			treeIn = file->treeForced;
+			break;
+		default:
+			break;
+	}
+	return treeIn;
+}
+bool IHealthTools::IsFlatTrace(const UShort_t *trace, int iTWStart, int iTWEnd, int nSamplesTolerance){
+	int nTraceSamplesBad = 0;
+	int j = iTWStart;
+	while(j<iTWEnd && nTraceSamplesBad < nSamplesTolerance){
+		if(trace[j] == trace[j+1]){
+			nTraceSamplesBad++;
+		}
+		else{
+			nTraceSamplesBad = 0;
+		}
+		j++;
+	}
+	return (nTraceSamplesBad == nSamplesTolerance);
+}
 
 std::vector<float> IHealthTools::CameraPeakingTime(IFile *file, int entry,unsigned long long lTimeStart, unsigned long long lTimeEnd, std::string treeName, float voltage, unsigned long long *eventTime,int iTWStart, int iTWEnd,float fTiltLow,float fTiltHigh){
 
@@ -29,6 +63,7 @@ std::vector<float> IHealthTools::CameraPeakingTime(IFile *file, int entry,unsign
 	//TH2 *h = new TH2D("h","",nBinsX,lTimeStart,lTimeEnd,nBinsY,0,nADC);
 
 	Pulse *p;
+	std::vector<UShort_t> row;
 
 	int selectedTree = IFile::GetTreeID(treeName);
 
@@ -45,7 +80,7 @@ std::vector<float> IHealthTools::CameraPeakingTime(IFile *file, int entry,unsign
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pkTime[j] = p->GetTimePeak();
 					delete p;
 				}
@@ -67,7 +102,7 @@ std::vector<float> IHealthTools::CameraPeakingTime(IFile *file, int entry,unsign
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pkTime[j] = p->GetTimePeak();
 					delete p;
 				}
@@ -89,7 +124,7 @@ std::vector<float> IHealthTools::CameraPeakingTime(IFile *file, int entry,unsign
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pkTime[j] = p->GetTimePeak();
 					delete p;
 				}
@@ -111,7 +146,7 @@ std::vector<float> IHealthTools::CameraPeakingTime(IFile *file, int entry,unsign
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pkTime[j] = p->GetTimePeak();
 					delete p;
 				}
@@ -142,6 +177,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry,unsigned
 	//TH2 *h = new TH2D("h","",nBinsX,lTimeStart,lTimeEnd,nBinsY,0,nADC);
 
 	Pulse *p;	
+	std::vector<UShort_t> row;
 
 	int selectedTree = IFile::GetTreeID(treeName);
 
@@ -158,7 +194,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry,unsigned
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.2 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					amplitude[j] = p->GetAmplitude();
 					delete p;
 				}
@@ -180,7 +216,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry,unsigned
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					amplitude[j] = p->GetAmplitude();
 					delete p;
 				}
@@ -202,7 +238,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry,unsigned
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					amplitude[j] = p->GetAmplitude();
 					delete p;
 				}
@@ -224,7 +260,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry,unsigned
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					amplitude[j] = p->GetAmplitude();
 					delete p;
 				}
@@ -256,6 +292,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry, std::st
 	//TH2 *h = new TH2D("h","",nBinsX,lTimeStart,lTimeEnd,nBinsY,0,nADC);
 
 	Pulse *p;	
+	std::vector<UShort_t> row;
 
 	int selectedTree = IFile::GetTreeID(treeName);
 
@@ -268,7 +305,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry, std::st
 			//cout<<"HV: "<<hv[0]<<endl;
 			
 			for(int j= 0; j<nPixelsCamera; j++){
-				p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+				p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 				amplitude[j] = p->GetAmplitude();
 				delete p;
 			}
@@ -280,7 +317,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry, std::st
 			file->treeBiFocal->GetEntry(entry);
 			
 			for(int j= 0; j<nPixelsCamera; j++){
-				p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+				p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 				amplitude[j] = p->GetAmplitude();
 				delete p;
 			}
@@ -291,7 +328,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry, std::st
 			file->treeTest->GetEntry(entry);
 			
 			for(int j= 0; j<nPixelsCamera; j++){
-				p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+				p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 				amplitude[j] = p->GetAmplitude();
 				delete p;
 			}
@@ -302,7 +339,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry, std::st
 			file->treeForced->GetEntry(entry);
 			
 			for(int j= 0; j<nPixelsCamera; j++){
-				p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+				p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 				amplitude[j] = p->GetAmplitude();
 				delete p;
 			}
@@ -315,7 +352,7 @@ std::vector<float> IHealthTools::CameraAmplitude(IFile *file, int entry, std::st
 	return amplitude;
 }
 
-std::vector<float> IHealthTools::CameraAmplitude(std::vector<std::vector<int>>traces, int iTWStart, int iTWEnd){
+std::vector<float> IHealthTools::CameraAmplitude(const std::vector<std::vector<int>> &traces, int iTWStart, int iTWEnd){
 
 	
 	int nPixelsCamera = 512;
@@ -348,6 +385,7 @@ std::vector<float> IHealthTools::CameraPedestal(IFile *file,int entry,unsigned l
 	//TH2 *h = new TH2D("h","",nBinsX,lTimeStart,lTimeEnd,nBinsY,0,nADC);
 
 	Pulse *p;
+	std::vector<UShort_t> row;
 
 	int selectedTree = IFile::GetTreeID(treeName);
 
@@ -364,7 +402,7 @@ std::vector<float> IHealthTools::CameraPedestal(IFile *file,int entry,unsigned l
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestal[j] = (float)p->GetPedestal();
 					delete p;
 				}
@@ -386,7 +424,7 @@ std::vector<float> IHealthTools::CameraPedestal(IFile *file,int entry,unsigned l
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestal[j] = p->GetPedestal();
 					delete p;
 				}
@@ -408,7 +446,7 @@ std::vector<float> IHealthTools::CameraPedestal(IFile *file,int entry,unsigned l
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestal[j] = p->GetPedestal();
 					delete p;
 				}
@@ -430,7 +468,7 @@ std::vector<float> IHealthTools::CameraPedestal(IFile *file,int entry,unsigned l
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestal[j] = p->GetPedestal();
 					delete p;
 				}
@@ -463,6 +501,7 @@ std::vector<float> IHealthTools::CameraCharge(IFile *file,int entry,unsigned lon
 	//TH2 *h = new TH2D("h","",nBinsX,lTimeStart,lTimeEnd,nBinsY,0,nADC);
 
 	Pulse *p;
+	std::vector<UShort_t> row;
 	
 
 	int selectedTree = IFile::GetTreeID(treeName);
@@ -480,7 +519,7 @@ std::vector<float> IHealthTools::CameraCharge(IFile *file,int entry,unsigned lon
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					charge[j] = p->GetCharge();
 					delete p;
 				}
@@ -502,7 +541,7 @@ std::vector<float> IHealthTools::CameraCharge(IFile *file,int entry,unsigned lon
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					charge[j] = p->GetCharge();
 					delete p;
 				}
@@ -524,7 +563,7 @@ std::vector<float> IHealthTools::CameraCharge(IFile *file,int entry,unsigned lon
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					charge[j] = p->GetCharge();
 					delete p;
 				}
@@ -546,7 +585,7 @@ std::vector<float> IHealthTools::CameraCharge(IFile *file,int entry,unsigned lon
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					charge[j] = p->GetCharge();
 					delete p;
 				}
@@ -578,6 +617,7 @@ std::vector<float> IHealthTools::CameraPedestalRMS(IFile *file, int entry, unsig
 	
 	//TH2 *h = new TH2D("h","",nBinsX,lTimeStart,lTimeEnd,nBinsY,0,nADC);
 	Pulse *p;
+	std::vector<UShort_t> row;
 
 	
 
@@ -596,7 +636,7 @@ std::vector<float> IHealthTools::CameraPedestalRMS(IFile *file, int entry, unsig
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestalRMS[j] = p->GetPedestalRMS();
 					delete p;
 				}
@@ -618,7 +658,7 @@ std::vector<float> IHealthTools::CameraPedestalRMS(IFile *file, int entry, unsig
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<=0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestalRMS[j] = p->GetPedestalRMS();
 					delete p;
 				}
@@ -640,7 +680,7 @@ std::vector<float> IHealthTools::CameraPedestalRMS(IFile *file, int entry, unsig
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestalRMS[j] = p->GetPedestalRMS();
 					delete p;
 				}
@@ -662,7 +702,7 @@ std::vector<float> IHealthTools::CameraPedestalRMS(IFile *file, int entry, unsig
 			if(timeStamp>=lTimeStart && timeStamp<=lTimeEnd && (TMath::Abs(hv[0]-voltage))<0.1 && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
 				*eventTime = timeStamp;
 				for(int j= 0; j<nPixelsCamera; j++){
-					p = new Pulse(event->GetSignalValue(j),iTWStart,iTWEnd);
+					p = new Pulse(event->GetSignalRow(j,row),event->GetNSamples(),iTWStart,iTWEnd);
 					pedestalRMS[j] = p->GetPedestalRMS();
 					delete p;
 				}
@@ -681,7 +721,7 @@ std::vector<float> IHealthTools::CameraPedestalRMS(IFile *file, int entry, unsig
 	return pedestalRMS;
 }
 
-bool IHealthTools::IsBadEvent(std::vector<std::vector<int>> traces, int iTWStart, int iTWEnd, int nPixelsTolerance, int nSamplesTolerance){
+bool IHealthTools::IsBadEvent(const std::vector<std::vector<int>> &traces, int iTWStart, int iTWEnd, int nPixelsTolerance, int nSamplesTolerance){
 	int nPixelsCamera = 512;
 
 	int nTraceSamplesBad = 0;
@@ -716,53 +756,24 @@ bool IHealthTools::IsBadEvent(std::vector<std::vector<int>> traces, int iTWStart
 bool IHealthTools::IsBadEvent(IFile *file,int entry, std::string treeName, int iTWStart, int iTWEnd, int nPixelsTolerance, int nSamplesTolerance){
 	int nPixelsCamera = 512;
 
-	int nTraceSamplesBad = 0;
 	int nPixelsBad = 0;
 
 	bool isBadEvent = false;
-	int selectedTree = IFile::GetTreeID(treeName);
-	TTree *treeIn;
-	switch(selectedTree){
-		case 0:
-			treeIn = file->treeHLED;
-			break;
-		case 1:
-			treeIn = file->treeBiFocal;
-			break;
-		case 2:
-			treeIn = file->treeTest;
-			break;
-		case 3:
-			treeIn = file->treeForced;
-			break;
-		default:
-			cout<<"No such tree"<<endl;
-			break;
+	TTree *treeIn = GetTree(file, treeName);
+	if(treeIn == NULL){
+		cout<<"No such tree"<<endl;
+		return isBadEvent;
 	}
-	int j = 0;
 	IEvent *ev;
-	std::vector<std::vector<int>> traces;
+	std::vector<UShort_t> row;
 	ev = new IEvent();
 	treeIn->SetBranchAddress("Events", &ev);
 	treeIn->GetEntry(entry);
 
-	traces = ev->GetSignalValue();
-
 	for(int i = 0; i<nPixelsCamera; i++){
-		j = iTWStart;
-		while(j<iTWEnd && nTraceSamplesBad < nSamplesTolerance){
-			if(traces[i][j] == traces[i][j+1]){
-				nTraceSamplesBad++;
-			}
-			else{
-				nTraceSamplesBad = 0;
-			}
-			j++;
-		}
-		if(nTraceSamplesBad == nSamplesTolerance){
+		if(IsFlatTrace(ev->GetSignalRow(i,row),iTWStart,iTWEnd,nSamplesTolerance)){
 			nPixelsBad++;
 		}
-		nTraceSamplesBad = 0;	
 	}
 
 	if(nPixelsBad > nPixelsTolerance){
@@ -773,3 +784,57 @@ bool IHealthTools::IsBadEvent(IFile *file,int entry, std::string treeName, int i
 	return isBadEvent;
 }
 
+IHealthScanResult IHealthTools::CameraHealthScan(IFile *file, std::string treeName, unsigned long long lTimeStart, unsigned long long lTimeEnd, float voltage, int iTWStart, int iTWEnd, float fTiltLow, float fTiltHigh, bool tiltRelativeToHorizon, float voltageTolerance, bool keepValues, int nPixelsTolerance, int nSamplesTolerance){
+	int nPixelsCamera = 512;
+
+	IHealthScanResult result(nPixelsCamera, keepValues);
+	TTree *treeIn = GetTree(file, treeName);
+	if(treeIn == NULL){
+		cout<<"No such tree"<<endl;
+		return result;
+	}
+
+	IEvent *event = 0;
+	std::vector<UShort_t> row;
+	unsigned long long timeStamp;
+	float tiltAngle;
+	int nPixelsBad;
+
+	// values[measurementID][pixID] of the entry being scanned
+	std::vector<std::vector<float>> values(IHealthScanResult::kNMeasurements, std::vector<float>(nPixelsCamera));
+
+	treeIn->SetBranchAddress("Events",&event);
+	Long64_t nEntries = treeIn->GetEntries();
+	for(Long64_t i = 0; i<nEntries; i++){
+		treeIn->GetEntry(i);
+		timeStamp = event->GetTBTime();
+		tiltAngle = event->GetTiltAngle();
+		if(tiltRelativeToHorizon){
+			tiltAngle = tiltAngle - event->GetHorizon();
+		}
+
+		if(IsTimeInRange(timeStamp,lTimeStart,lTimeEnd) && TMath::Abs(event->Gethv()[0]-voltage)<=voltageTolerance && IsTiltInRange(tiltAngle,fTiltLow,fTiltHigh)){
+			nPixelsBad = 0;
+			for(int j= 0; j<nPixelsCamera; j++){
+				const UShort_t *trace = event->GetSignalRow(j,row);
+				Pulse p(trace,event->GetNSamples(),iTWStart,iTWEnd);
+				values[IHealthScanResult::kPedestal][j] = (float)p.GetPedestal();
+				values[IHealthScanResult::kPedestalRMS][j] = p.GetPedestalRMS();
+				values[IHealthScanResult::kAmplitude][j] = p.GetAmplitude();
+				values[IHealthScanResult::kCharge][j] = p.GetCharge();
+				values[IHealthScanResult::kPeakingTime][j] = p.GetTimePeak();
+				if(IsFlatTrace(trace,iTWStart,iTWEnd,nSamplesTolerance)){
+					nPixelsBad++;
+				}
+			}
+			result.AddEntry(i, timeStamp, nPixelsBad > nPixelsTolerance, values);
+		}else{
+			result.AddRejected();
+		}
+	}
+
+	// the branch must not keep the address of the local event
+	treeIn->ResetBranchAddresses();
+	delete event;
+	return result;
+}
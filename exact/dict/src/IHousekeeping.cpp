@@ -0,0 +1,124 @@
+#include "IHousekeeping.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+IHousekeeping::IHousekeeping(std::string filename){
+	std::ifstream file(filename);
+	if(!file.is_open()){
+		throw std::runtime_error("Failed to open file: " + filename);
+	}
+
+	std::string line;
+	std::string cell;
+	if(std::getline(file, line)){
+		std::stringstream ss(line);
+		while(ss >> cell){
+			headers.push_back(cell);
+		}
+	}
+	if(headers.empty()){
+		throw std::runtime_error("Invalid file format: " + filename);
+	}
+
+	std::vector<std::vector<std::string>> data;
+	while(std::getline(file, line)){
+		std::stringstream ss(line);
+		std::vector<std::string> row;
+		while(ss >> cell){
+			row.push_back(cell);
+		}
+		if(row.size() != headers.size()){
+			throw std::runtime_error("Invalid file format: " + filename);
+		}
+		data.push_back(row);
+	}
+	file.close();
+
+	Init(data);
+}
+
+IHousekeeping::IHousekeeping(const std::vector<std::vector<std::string>> &data){
+	Init(data);
+}
+
+void IHousekeeping::Init(const std::vector<std::vector<std::string>> &data){
+	int nRows = data.size();
+	int nColumns = 0;
+	for(int i = 0; i < nRows; i++){
+		nColumns = std::max(nColumns, (int)data[i].size());
+	}
+
+	std::vector<long long> rowTimestamps(nRows, 0);
+	for(int i = 0; i < nRows; i++){
+		if(!data[i].empty()){
+			rowTimestamps[i] = std::strtoll(data[i][0].c_str(), NULL, 10);
+		}
+	}
+
+	rows.resize(nRows);
+	std::iota(rows.begin(), rows.end(), 0);
+	std::stable_sort(rows.begin(), rows.end(), [&rowTimestamps](int a, int b){ return rowTimestamps[a] < rowTimestamps[b]; });
+
+	timestamps.resize(nRows);
+	columns.assign(nColumns, std::vector<double>(nRows, 0.));
+	for(int entry = 0; entry < nRows; entry++){
+		const std::vector<std::string> &row = data[rows[entry]];
+		timestamps[entry] = rowTimestamps[rows[entry]];
+		for(int j = 0; j < (int)row.size(); j++){
+			columns[j][entry] = std::strtod(row[j].c_str(), NULL);
+		}
+	}
+}
+
+int IHousekeeping::GetEntries() const{
+	return timestamps.size();
+}
+
+int IHousekeeping::GetNColumns() const{
+	return columns.size();
+}
+
+const std::vector<std::string>& IHousekeeping::GetHeaders() const{
+	return headers;
+}
+
+int IHousekeeping::FindClosestEntry(long long timestamp) const{
+	int entry = -1;
+
+	// first record at or after the timestamp
+	std::vector<long long>::const_iterator above = std::lower_bound(timestamps.begin(), timestamps.end(), timestamp);
+	if(above != timestamps.end()){
+		entry = above - timestamps.begin();
+	}
+	if(above != timestamps.begin()){
+		// first record of the last time before the timestamp
+		int below = std::lower_bound(timestamps.begin(), timestamps.end(), *(above - 1)) - timestamps.begin();
+		if(entry < 0 || timestamp - timestamps[below] < timestamps[entry] - timestamp
+			|| (timestamp - timestamps[below] == timestamps[entry] - timestamp && rows[below] < rows[entry])){
+			entry = below;
+		}
+	}
+
+	return entry;
+}
+
+long long IHousekeeping::GetTimestamp(int entry) const{
+	return timestamps[entry];
+}
+
+double IHousekeeping::GetValue(int entry, int column) const{
+	double value = 0;
+	if(column < (int)columns.size()){
+		value = columns[column][entry];
+	}
+	return value;
+}
+
+IHousekeeping::~IHousekeeping(){
+
+}
@@ -25,112 +25,107 @@ using namespace std;
 
 }*/
 
-Pulse::Pulse(ReadConfiguration *config, vector<Int_t> samples){
-	nSamplesPulse = config->nSamplesADC;
-	timeIntegration = config->timeWindowExtraction;
+Pulse::Pulse(ReadConfiguration *config, const vector<Int_t> &samples){
+	Init(config->nSamplesADC);
+	Extract(config, &samples[0]);
+}
 
-	trace = samples;
-	amplitude = 0;
-	charge = 0;
-	timeFWHM = 0;
-	timeFW = 0;
-	pedestalRMS = 0;
+Pulse::Pulse(const vector<Int_t> &samples){
+	Init(512);
+	Extract(&samples[0], 200, 300, true);
+}
 
-	CalcPedestal(config->nSamplesPedestal);
-	
-	if(config->amplitudeExtraction){
-		FindPeakTime(config->timeWindowStart, config->timeWindowEnd);
-		FindPeak();
-		CalcAmplitude();
-		//cout<<amplitude<<" ";
-	}
-	if(config->chargeExtraction){
-		CalcCharge(config->timeWindowStart,config->timeWindowEnd,config->timeWindowExtraction,config->revolvingTimeWindow);
-	}
+Pulse::Pulse(const vector<Int_t> &samples, Int_t tStart, Int_t tEnd, int nSamples, bool isPedestalSub){
+	Init(nSamples);
+	Extract(&samples[0], tStart, tEnd, isPedestalSub);
+}
 
+Pulse::Pulse(const vector<float> &samples, Int_t tStart, Int_t tEnd, int nSamples, bool isPedestalSub){
+	Init(nSamples);
+	Extract(&samples[0], tStart, tEnd, isPedestalSub);
 }
 
-Pulse::Pulse(vector<Int_t> samples){
-	nSamplesPulse = 512;
-	timeIntegration = 3;
+Pulse::Pulse(ReadConfiguration *config, const UShort_t *samples, Int_t nSamples){
+	Init(nSamples);
+	Extract(config, samples);
+}
 
-	trace = samples;
-	amplitude = 0;
-	charge = 0;
-	timeFWHM = 0;
-	timeFW = 0;
-	pedestalRMS = 0;
+Pulse::Pulse(ReadConfiguration *config, const Int_t *samples, Int_t nSamples){
+	Init(nSamples);
+	Extract(config, samples);
+}
 
-	CalcPedestal(100);
-	
-	FindPeakTime(200, 300);
-	FindPeak();
-	CalcAmplitude();
-		//cout<<amplitude<<" ";
-	
-	CalcCharge(200,300,3,1);
-	
+Pulse::Pulse(const UShort_t *samples, Int_t nSamples, Int_t tStart, Int_t tEnd, bool isPedestalSub){
+	Init(nSamples);
+	Extract(samples, tStart, tEnd, isPedestalSub);
+}
+
+Pulse::Pulse(const Int_t *samples, Int_t nSamples, Int_t tStart, Int_t tEnd, bool isPedestalSub){
+	Init(nSamples);
+	Extract(samples, tStart, tEnd, isPedestalSub);
+}
+
+Pulse::Pulse(const float *samples, Int_t nSamples, Int_t tStart, Int_t tEnd, bool isPedestalSub){
+	Init(nSamples);
+	Extract(samples, tStart, tEnd, isPedestalSub);
 }
 
-Pulse::Pulse(vector<Int_t> samples, Int_t tStart, Int_t tEnd, int nSamples, bool isPedestalSub){
+void Pulse::Init(Int_t nSamples){
 	nSamplesPulse = nSamples;
 	timeIntegration = 3;
 
-	trace = samples;
 	amplitude = 0;
 	charge = 0;
+	timePeak = 0;
 	timeFWHM = 0;
 	timeFW = 0;
 	pedestalRMS = 0;
+}
+
+/**
+ * Extraction with the settings of the configuration file.
+ */
+template<typename T>
+void Pulse::Extract(ReadConfiguration *config, const T *trace){
+	timeIntegration = config->timeWindowExtraction;
 
-	CalcPedestal(100);
+	CalcPedestal(trace, config->nSamplesPedestal);
 	
-	FindPeakTime(tStart, tEnd);
-	FindPeak();
-	if(isPedestalSub){
+	if(config->amplitudeExtraction){
+		FindPeakTime(trace, config->timeWindowStart, config->timeWindowEnd);
+		FindPeak(trace);
 		CalcAmplitude();
-	}
 		//cout<<amplitude<<" ";
-	
-	CalcCharge(tStart,tEnd,3,1);
-	
+	}
+	if(config->chargeExtraction){
+		CalcCharge(trace, config->timeWindowStart,config->timeWindowEnd,config->timeWindowExtraction,config->revolvingTimeWindow);
+	}
 }
 
-Pulse::Pulse(vector<float> samples, Int_t tStart, Int_t tEnd, int nSamples, bool isPedestalSub){
-	nSamplesPulse = nSamples;
-	timeIntegration = 3;
-
-	trace = std::vector<int>(samples.begin(), samples.end());
-	amplitude = 0;
-	charge = 0;
-	timeFWHM = 0;
-	timeFW = 0;
-	pedestalRMS = 0;
-
-	CalcPedestal(100);
+/**
+ * Extraction with a 100 sample pedestal and a revolving charge window of 3 samples in [tStart, tEnd).
+ * Without isPedestalSub the amplitude is the minimum sample.
+ */
+template<typename T>
+void Pulse::Extract(const T *trace, Int_t tStart, Int_t tEnd, bool isPedestalSub){
+	CalcPedestal(trace, 100);
 	
-	FindPeakTime(tStart, tEnd);
-	FindPeak();
+	FindPeakTime(trace, tStart, tEnd);
+	FindPeak(trace);
 	if(isPedestalSub){
 		CalcAmplitude();
 	}
-	
 		//cout<<amplitude<<" ";
 	
-	CalcCharge(tStart,tEnd,3,1);
-	
+	CalcCharge(trace, tStart,tEnd,3,1);
 }
 
-
-
-
-
-
 Pulse::~Pulse(){
 
 }
 
-void Pulse::FindPeakTime(Int_t tWinSt, Int_t tWinEnd){
+template<typename T>
+void Pulse::FindPeakTime(const T *trace, Int_t tWinSt, Int_t tWinEnd){
 	Double_t aCalc, aTmp;
 	Double_t pkTmp = tWinSt;
 
@@ -138,7 +133,7 @@ void Pulse::FindPeakTime(Int_t tWinSt, Int_t tWinEnd){
 
 	
 	for(int i = tWinSt; i<tWinEnd; i++){
-		aTmp = trace[i];
+		aTmp = (Int_t)trace[i];
 		if (aTmp<aCalc){
 			aCalc = aTmp;
 			pkTmp = i;
@@ -149,15 +144,17 @@ void Pulse::FindPeakTime(Int_t tWinSt, Int_t tWinEnd){
 }
 
 //Calculate desired properties of Pulse
-void Pulse::FindPeak(){
-	amplitude = trace[(int)timePeak];
+template<typename T>
+void Pulse::FindPeak(const T *trace){
+	amplitude = (Int_t)trace[(int)timePeak];
 }
 
-void Pulse::CalcPedestal(Int_t nSamplesPedestal){
+template<typename T>
+void Pulse::CalcPedestal(const T *trace, Int_t nSamplesPedestal){
 	Double_t pCalc = 0;
 
 	for(int i = 0; i<nSamplesPedestal; i++){
-		pCalc += trace[i];
+		pCalc += (Int_t)trace[i];
 	}
 
 	pCalc = pCalc/nSamplesPedestal;
@@ -165,7 +162,7 @@ void Pulse::CalcPedestal(Int_t nSamplesPedestal){
 	pedestal = pCalc;
 
 	for(int i = 0; i<nSamplesPedestal; i++){
-		pedestalRMS += (trace[i] - pedestal)*(trace[i] - pedestal);
+		pedestalRMS += ((Int_t)trace[i] - pedestal)*((Int_t)trace[i] - pedestal);
 	}
 	pedestalRMS = sqrt(pedestalRMS/(float)nSamplesPedestal);
 	//cout<<pedestalRMS<<endl;
@@ -185,17 +182,18 @@ void Pulse::CalcAmplitude(){
 //>>>>>>> main
 }
 
-void Pulse::CalcCharge(Int_t tWinSt, Int_t tWinEnd, Int_t tWinExt, Bool_t isRevolving){
+template<typename T>
+void Pulse::CalcCharge(const T *trace, Int_t tWinSt, Int_t tWinEnd, Int_t tWinExt, Bool_t isRevolving){
 	if(isRevolving){
-		FindPeakTime(tWinSt, tWinEnd);
+		FindPeakTime(trace, tWinSt, tWinEnd);
 		for(int i = timePeak - tWinExt/2; i<timePeak+tWinExt/2+tWinExt%2; i++){
-			charge += (pedestal - trace[i]);
+			charge += (pedestal - (Int_t)trace[i]);
 		}
 
 	}
 	else{
 		for(int i = tWinSt; i<tWinSt+tWinExt; i++){
-			charge += (pedestal - trace[i]);
+			charge += (pedestal - (Int_t)trace[i]);
 		}
 	}
 
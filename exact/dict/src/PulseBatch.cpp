@@ -0,0 +1,298 @@
+#include "PulseBatch.h"
+#include <TMath.h>
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PULSEBATCH_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// pixels per block, one per lane of an AVX2 register of Int_t
+#define PulseBatchLanes 8
+
+enum { kScalar, kSSE2, kAVX2 };
+
+/*
+ * The kernels compute, for the 8 traces of a block, what Pulse computes for one:
+ * the pedestal as the double sum of the samples divided by their number, the RMS
+ * accumulated in a float with every step done in double, and the first minimum of
+ * the peak window, starting from 5000 as Pulse does. Samples are 12-bit, so the
+ * Int_t sums of the vector kernels are exact and equal to the double sums.
+ */
+static void PedestalScalar(const Int_t *block, Int_t nSamplesPedestal, Double_t *pedestal, float *pedestalRMS){
+	for(int k = 0; k<PulseBatchLanes; k++){
+		Double_t pCalc = 0;
+		for(int i = 0; i<nSamplesPedestal; i++){
+			pCalc += block[i*PulseBatchLanes+k];
+		}
+		pedestal[k] = pCalc/nSamplesPedestal;
+
+		float rms = 0;
+		for(int i = 0; i<nSamplesPedestal; i++){
+			rms += (block[i*PulseBatchLanes+k] - pedestal[k])*(block[i*PulseBatchLanes+k] - pedestal[k]);
+		}
+		pedestalRMS[k] = sqrt(rms/(float)nSamplesPedestal);
+	}
+}
+
+static void PeakScalar(const Int_t *block, Int_t tWinSt, Int_t tWinEnd, int *timePeak){
+	for(int k = 0; k<PulseBatchLanes; k++){
+		Int_t aCalc = 5000;
+		int pkTmp = tWinSt;
+		for(int i = tWinSt; i<tWinEnd; i++){
+			if(block[i*PulseBatchLanes+k]<aCalc){
+				aCalc = block[i*PulseBatchLanes+k];
+				pkTmp = i;
+			}
+		}
+		timePeak[k] = pkTmp;
+	}
+}
+
+#ifdef PULSEBATCH_X86
+__attribute__((target("sse2")))
+static void PedestalSSE2(const Int_t *block, Int_t nSamplesPedestal, Double_t *pedestal, float *pedestalRMS){
+	// two halves of 4 pixels
+	for(int h = 0; h<2; h++){
+		const Int_t *lanes = block + 4*h;
+		__m128i sum = _mm_setzero_si128();
+		for(int i = 0; i<nSamplesPedestal; i++){
+			sum = _mm_add_epi32(sum, _mm_loadu_si128((const __m128i *)(lanes + i*PulseBatchLanes)));
+		}
+		__m128d n = _mm_set1_pd(nSamplesPedestal);
+		__m128d pedLo = _mm_div_pd(_mm_cvtepi32_pd(sum), n);
+		__m128d pedHi = _mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(sum, 0x0e)), n);
+
+		__m128 rmsLo = _mm_setzero_ps();
+		__m128 rmsHi = _mm_setzero_ps();
+		for(int i = 0; i<nSamplesPedestal; i++){
+			__m128i v = _mm_loadu_si128((const __m128i *)(lanes + i*PulseBatchLanes));
+			__m128d dLo = _mm_sub_pd(_mm_cvtepi32_pd(v), pedLo);
+			__m128d dHi = _mm_sub_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(v, 0x0e)), pedHi);
+			rmsLo = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(rmsLo), _mm_mul_pd(dLo, dLo)));
+			rmsHi = _mm_cvtpd_ps(_mm_add_pd(_mm_cvtps_pd(rmsHi), _mm_mul_pd(dHi, dHi)));
+		}
+		__m128 rms = _mm_movelh_ps(rmsLo, rmsHi);
+		rms = _mm_sqrt_ps(_mm_div_ps(rms, _mm_set1_ps((float)nSamplesPedestal)));
+
+		_mm_storeu_pd(pedestal + 4*h, pedLo);
+		_mm_storeu_pd(pedestal + 4*h + 2, pedHi);
+		_mm_storeu_ps(pedestalRMS + 4*h, rms);
+	}
+}
+
+__attribute__((target("sse2")))
+static void PeakSSE2(const Int_t *block, Int_t tWinSt, Int_t tWinEnd, int *timePeak){
+	for(int h = 0; h<2; h++){
+		const Int_t *lanes = block + 4*h;
+		__m128i aCalc = _mm_set1_epi32(5000);
+		__m128i pkTmp = _mm_set1_epi32(tWinSt);
+		for(int i = tWinSt; i<tWinEnd; i++){
+			__m128i v = _mm_loadu_si128((const __m128i *)(lanes + i*PulseBatchLanes));
+			__m128i lower = _mm_cmplt_epi32(v, aCalc);
+			aCalc = _mm_or_si128(_mm_and_si128(lower, v), _mm_andnot_si128(lower, aCalc));
+			pkTmp = _mm_or_si128(_mm_and_si128(lower, _mm_set1_epi32(i)), _mm_andnot_si128(lower, pkTmp));
+		}
+		_mm_storeu_si128((__m128i *)(timePeak + 4*h), pkTmp);
+	}
+}
+
+__attribute__((target("avx2")))
+static void PedestalAVX2(const Int_t *block, Int_t nSamplesPedestal, Double_t *pedestal, float *pedestalRMS){
+	__m256i sum = _mm256_setzero_si256();
+	for(int i = 0; i<nSamplesPedestal; i++){
+		sum = _mm256_add_epi32(sum, _mm256_loadu_si256((const __m256i *)(block + i*PulseBatchLanes)));
+	}
+	__m256d n = _mm256_set1_pd(nSamplesPedestal);
+	__m256d pedLo = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sum)), n);
+	__m256d pedHi = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sum, 1)), n);
+
+	// the float accumulator is widened and rounded back at every sample, as in Pulse
+	__m128 rmsLo = _mm_setzero_ps();
+	__m128 rmsHi = _mm_setzero_ps();
+	for(int i = 0; i<nSamplesPedestal; i++){
+		__m256i v = _mm256_loadu_si256((const __m256i *)(block + i*PulseBatchLanes));
+		__m256d dLo = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), pedLo);
+		__m256d dHi = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), pedHi);
+		rmsLo = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(rmsLo), _mm256_mul_pd(dLo, dLo)));
+		rmsHi = _mm256_cvtpd_ps(_mm256_add_pd(_mm256_cvtps_pd(rmsHi), _mm256_mul_pd(dHi, dHi)));
+	}
+	__m256 rms = _mm256_insertf128_ps(_mm256_castps128_ps256(rmsLo), rmsHi, 1);
+	rms = _mm256_sqrt_ps(_mm256_div_ps(rms, _mm256_set1_ps((float)nSamplesPedestal)));
+
+	_mm256_storeu_pd(pedestal, pedLo);
+	_mm256_storeu_pd(pedestal + 4, pedHi);
+	_mm256_storeu_ps(pedestalRMS, rms);
+}
+
+__attribute__((target("avx2")))
+static void PeakAVX2(const Int_t *block, Int_t tWinSt, Int_t tWinEnd, int *timePeak){
+	__m256i aCalc = _mm256_set1_epi32(5000);
+	__m256i pkTmp = _mm256_set1_epi32(tWinSt);
+	for(int i = tWinSt; i<tWinEnd; i++){
+		__m256i v = _mm256_loadu_si256((const __m256i *)(block + i*PulseBatchLanes));
+		__m256i lower = _mm256_cmpgt_epi32(aCalc, v);
+		aCalc = _mm256_blendv_epi8(aCalc, v, lower);
+		pkTmp = _mm256_blendv_epi8(pkTmp, _mm256_set1_epi32(i), lower);
+	}
+	_mm256_storeu_si256((__m256i *)timePeak, pkTmp);
+}
+#endif
+
+PulseBatch::PulseBatch(ReadConfiguration *config){
+	this->config = config;
+	nPixels = config->nPixelsCamera;
+
+	// last sample read: pedestal, peak window, charge window around the peak or at the window start
+	Int_t tWinExt = config->timeWindowExtraction;
+	nSamplesUsed = max(config->nSamplesPedestal, config->timeWindowStart+1);
+	nSamplesUsed = max(nSamplesUsed, config->timeWindowEnd);
+	nSamplesUsed = max(nSamplesUsed, config->timeWindowEnd + tWinExt/2 + tWinExt%2);
+	nSamplesUsed = max(nSamplesUsed, config->timeWindowStart + tWinExt);
+
+	instructionSet = kScalar;
+#ifdef PULSEBATCH_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")){
+		instructionSet = kAVX2;
+	}else if(__builtin_cpu_supports("sse2")){
+		instructionSet = kSSE2;
+	}
+#endif
+
+	Int_t nPadded = (nPixels + PulseBatchLanes - 1)/PulseBatchLanes*PulseBatchLanes;
+	block.assign((size_t)nSamplesUsed*PulseBatchLanes, 0);
+	pedestal.assign(nPadded, 0);
+	pedestalRMS.assign(nPadded, 0);
+	amplitude.assign(nPadded, 0);
+	charge.assign(nPadded, 0);
+	timePeak.assign(nPadded, 0);
+}
+
+PulseBatch::~PulseBatch(){
+
+}
+
+/**
+ * Extracts the pulses of all camera pixels of an event.
+ * Pixels the event does not hold are extracted from the trace GetSignalValue()
+ * gives for them: flat at the pedestal mean for pixels dropped from a sparse
+ * event, zeros beyond the stored pixels.
+ */
+void PulseBatch::Extract(Event *event){
+	for(Int_t firstPixel = 0; firstPixel<nPixels; firstPixel += PulseBatchLanes){
+		FillBlock(event, firstPixel);
+		ExtractBlock(firstPixel);
+	}
+}
+
+/**
+ * Copies the used samples of 8 pixels into the sample-major block.
+ * Samples beyond the trace length, and lanes beyond the camera, are 0.
+ */
+void PulseBatch::FillBlock(Event *event, Int_t firstPixel){
+	Int_t n = min(nSamplesUsed, event->GetNSamples());
+	for(int k = 0; k<PulseBatchLanes; k++){
+		Int_t pixID = firstPixel + k;
+		Int_t *lane = &block[k];
+		const UShort_t *trace = (pixID<nPixels) ? event->GetTrace(pixID) : 0;
+		if(trace){
+			for(int i = 0; i<n; i++) lane[i*PulseBatchLanes] = trace[i];
+		}else{
+			Int_t flat = (pixID<nPixels) ? TMath::Nint(event->GetPedestalMean(pixID)) : 0;
+			for(int i = 0; i<n; i++) lane[i*PulseBatchLanes] = flat;
+		}
+		for(int i = n; i<nSamplesUsed; i++) lane[i*PulseBatchLanes] = 0;
+	}
+}
+
+/**
+ * Extracts the 8 pixels of the block, with the steps and roundings of the
+ * Pulse(ReadConfiguration*, trace) constructor.
+ */
+void PulseBatch::ExtractBlock(Int_t firstPixel){
+	const Int_t *samples = &block[0];
+	Double_t *ped = &pedestal[firstPixel];
+	int *pk = &timePeak[firstPixel];
+
+	switch(instructionSet){
+#ifdef PULSEBATCH_X86
+	case kAVX2: PedestalAVX2(samples, config->nSamplesPedestal, ped, &pedestalRMS[firstPixel]); break;
+	case kSSE2: PedestalSSE2(samples, config->nSamplesPedestal, ped, &pedestalRMS[firstPixel]); break;
+#endif
+	default: PedestalScalar(samples, config->nSamplesPedestal, ped, &pedestalRMS[firstPixel]);
+	}
+
+	// the revolving charge window is centred on the peak found in the same window
+	bool needPeak = config->amplitudeExtraction || (config->chargeExtraction && config->revolvingTimeWindow);
+	if(needPeak){
+		switch(instructionSet){
+#ifdef PULSEBATCH_X86
+		case kAVX2: PeakAVX2(samples, config->timeWindowStart, config->timeWindowEnd, pk); break;
+		case kSSE2: PeakSSE2(samples, config->timeWindowStart, config->timeWindowEnd, pk); break;
+#endif
+		default: PeakScalar(samples, config->timeWindowStart, config->timeWindowEnd, pk);
+		}
+	}else{
+		std::fill(pk, pk+PulseBatchLanes, 0);
+	}
+
+	Int_t tWinExt = config->timeWindowExtraction;
+	for(int k = 0; k<PulseBatchLanes; k++){
+		amplitude[firstPixel+k] = 0;
+		if(config->amplitudeExtraction){
+			amplitude[firstPixel+k] = samples[pk[k]*PulseBatchLanes+k];
+			amplitude[firstPixel+k] = ped[k] - amplitude[firstPixel+k];
+			if(amplitude[firstPixel+k]<0){
+				amplitude[firstPixel+k] = 0;
+			}
+		}
+
+		int chg = 0;
+		if(config->chargeExtraction){
+			Int_t first = config->revolvingTimeWindow ? pk[k] - tWinExt/2 : config->timeWindowStart;
+			Int_t last = config->revolvingTimeWindow ? pk[k] + tWinExt/2 + tWinExt%2 : config->timeWindowStart + tWinExt;
+			for(int i = max(first, 0); i<last; i++){
+				chg += (ped[k] - samples[i*PulseBatchLanes+k]);
+			}
+			if(chg<0){
+				chg = 0;
+			}
+		}
+		charge[firstPixel+k] = chg;
+	}
+}
+
+Int_t PulseBatch::GetNPixels(){
+	return nPixels;
+}
+
+const char *PulseBatch::GetInstructionSet(){
+	if(instructionSet == kAVX2) return "AVX2";
+	if(instructionSet == kSSE2) return "SSE2";
+	return "scalar";
+}
+
+//Getters, values of the last extracted event
+Double_t PulseBatch::GetPedestal(int pixID){
+	return pedestal[pixID];
+}
+
+float PulseBatch::GetPedestalRMS(int pixID){
+	return pedestalRMS[pixID];
+}
+
+int PulseBatch::GetAmplitude(int pixID){
+	return amplitude[pixID];
+}
+
+int PulseBatch::GetCharge(int pixID){
+	return charge[pixID];
+}
+
+int PulseBatch::GetTimePeak(int pixID){
+	return timePeak[pixID];
+}
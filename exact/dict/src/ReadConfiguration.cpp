@@ -12,6 +12,11 @@ ReadConfiguration::ReadConfiguration(string cfgFile){
 	revolvingTimeWindow = 0;
 	isDisplay = 0;
 	isFlightMode = 0;
+	nThreads = 1;
+	columnarExtracted = 0;
+	isPipeline = 0;
+	keepIntermediate = 0;
+	memoryLimitMB = 2048;
 
 
 	if(*cfgFileStream){
@@ -185,6 +190,39 @@ void ReadConfiguration::ReadLine(string iline, ifstream *cfgFileStream){
 
 		cout<<"Gold Plated Threshold level: " << goldPlatedThresholdLvl << endl;
 	}
+	if (iline.find("NTHREADS") < iline.size()){
+		lineStream>>i_dump; lineStream>>i_dump;
+		lineStream>>nThreads;
+
+		cout<<"Pulse extraction threads: " << nThreads << endl;
+	}
+	if (iline.find("COLUMNAREXTRACTED") < iline.size()){
+		lineStream>>i_dump; lineStream>>i_dump;
+		lineStream>>columnarExtracted;
+
+		status = BoolToStringAction(columnarExtracted);
+		cout<<"Extracted data in columnar layout: " << status << endl;
+	}
+	if (iline.find("PIPELINE") < iline.size()){
+		lineStream>>i_dump; lineStream>>i_dump;
+		lineStream>>isPipeline;
+
+		status = BoolToStringAction(isPipeline);
+		cout<<"Stages run as one in-memory pipeline: " << status << endl;
+	}
+	if (iline.find("KEEPINTERMEDIATE") < iline.size()){
+		lineStream>>i_dump; lineStream>>i_dump;
+		lineStream>>keepIntermediate;
+
+		status = BoolToStringAction(keepIntermediate);
+		cout<<"Pipeline intermediate files written: " << status << endl;
+	}
+	if (iline.find("MEMORYLIMITMB") < iline.size()){
+		lineStream>>i_dump; lineStream>>i_dump;
+		lineStream>>memoryLimitMB;
+
+		cout<<"Pipeline memory limit: " << memoryLimitMB << " MB" << endl;
+	}
 	if (iline.find("ROI") < iline.size()){
 		lineStream>>i_dump; lineStream>>i_dump;
 		lineStream>>nRegionOfInterest;
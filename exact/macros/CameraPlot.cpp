@@ -8,7 +8,8 @@ int iLastPixHLED = -1;
 TLatex *text = 0;
 TTree *tree = 0;
 TTree *tree_c = 0;
-ExtractedData *ex[512];
+// Pixel[i] branches or columnar, as written by ExACT
+IExtractedTree *extracted = 0;
 
 vector<float> *correctionFactors = 0;//vector<float>(512,1.0);
 
@@ -21,7 +22,7 @@ TCanvas *c_disp = 0;
 int MaxNofChannels = 512;
 
 void LoadEvents(std::string filename, std::string treeString);
-void SetBranches(ExtractedData **exD, long *timeTrig, BiFocal *bfF);
+void SetBranches(long *timeTrig, BiFocal *bfF);
 void PlotEvent();
 void ShowInfoAtCursor(int x, int y);
 
@@ -40,12 +41,8 @@ void CameraPlot(std::string filename,std::string treeString){
 	c_disp = new TCanvas("Display","CameraPlot",950,1000);
 	c_disp->Divide(1,2);
 
-	for(int i = 0; i<512; i++){
-		ex[i] = new ExtractedData();
-	}
-
 	LoadEvents(filename, treeString);
-	SetBranches(ex,&triggerTime, bf);
+	SetBranches(&triggerTime, bf);
 	PlotEvent();
 
 }
@@ -152,7 +149,7 @@ void PlotEvent()
     while(1)
     {	
     	//cout<<"Here"<<endl;
-        tree->GetEntry(EventCounter);
+        extracted->GetEntry(EventCounter);
         //tree_c->GetEntry(EventCounter);
         cout << "Event# " << EventCounter <<" is displayed." << endl;
         hcam->Reset();
@@ -169,12 +166,12 @@ void PlotEvent()
                 tmp += Hled_struct.SignalValue[i][j] - SingleEventPedestal[i];
             }*/
             	//cout<<"Correction Factor "<<correctionFactors->at(i)<<endl;
-              	hcam->SetBinContent(nx+1,ny+1,ex[i]->GetAmplitude());
+              	hcam->SetBinContent(nx+1,ny+1,extracted->GetAmplitude(i));
 				if(i==195){
-					cout<<ex[195]->GetAmplitude()<<endl; 
+					cout<<extracted->GetAmplitude(195)<<endl; 
 				}
 				     
-           	hChg->Fill(ex[i]->GetAmplitude());
+           	hChg->Fill(extracted->GetAmplitude(i));
         }
 
         c_disp->cd(1);
@@ -196,12 +193,10 @@ void PlotEvent()
             break;
     }
 }
-void SetBranches(ExtractedData **exD, long *timeTrig, BiFocal *bfF)
+void SetBranches(long *timeTrig, BiFocal *bfF)
 {
     //tree->SetBranchAddress("TriggerTime", &timeTrig);
-    for(int i = 0; i < 512; i++){
-    	tree->SetBranchAddress(TString::Format("Pixel[%d]",i), &exD[i]);
-    }
+    extracted = new IExtractedTree(tree, 512);
     //tree_c->SetBranchAddress("CorectionFactors", &correctionFactors);
     //tree->SetBranchAddress("TriggerRegion", bfF);
     //tHledEvents->SetBranchAddress("SignalValue", Hled_struct->SignalValue);
@@ -129,12 +129,13 @@ std::vector<Double_t> accumulatedMean(MaxNofChannels, 0.0);
          }
 
         Pulse *pulse;
+        std::vector<UShort_t> row;
        
 		// set up variables for calculation
 		Double_t PedRMS = 0;
 		Double_t mean = 0;
         for (int j = 0; j<MaxNofChannels; j++){
-			pulse = new Pulse(ev->GetSignalValue(j));
+			pulse = new Pulse(ev->GetSignalRow(j,row),ev->GetNSamples(),200,300);
 			extractedDataHLED[j]->SetPedestalRMS(pulse->GetPedestalRMS());
       		 accumulatedMean[j] += extractedDataHLED[j]->GetPedestalRMS();
 
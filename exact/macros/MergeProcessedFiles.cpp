@@ -40,30 +40,6 @@ int MergeProcessedFiles (std::string MainDir,std::string fileNameOut){
     TTree *tForced = new TTree("Forced","Forced Triggers");
     TTree *tTest = new TTree("Test","Test Triggers");
 */
-	ExtractedData *evHLEDOut[512];
-	/*ExtractedData *evBiFocalOut[512];
-	ExtractedData *evForcedOut[512];
-	ExtractedData *evTestOut[512];
-*/
-    unsigned long long eventTimeIn, eventTimeOut;
-
-    for(int i = 0; i<512; i++){
-        evHLEDOut[i] = new ExtractedData();
-        /*evBiFocalOut[i] = new ExtractedData();
-        evForcedOut[i] = new ExtractedData();
-        evTestOut[i] = new ExtractedData();*/
-    }
-
-
-    for(int i = 0; i<512; i++){
-        tHLED->Branch(TString::Format("Pixel[%d]",i),"ExtractedData", &evHLEDOut[i],64000,0);
-       /* tBiFocal->Branch(TString::Format("Pixel[%d]",i),"ExtractedData", &evBiFocalOut[i],64000,0);
-        tForced->Branch(TString::Format("Pixel[%d]",i),"ExtractedData", &evForcedOut[i],64000,0);
-        tTest->Branch(TString::Format("Pixel[%d]",i),"ExtractedData", &evTestOut[i],64000,0);*/
-
-    }
-	tHLED->Branch("TriggerTime", &eventTimeOut);
-
 
 
     TList *lst_Files = new TList();
@@ -86,6 +62,15 @@ int MergeProcessedFiles (std::string MainDir,std::string fileNameOut){
 
     TFile *source = (TFile*)lst_Files->First();
     source->cd();
+
+    // the merged tree keeps the layout of the first file, Pixel[i] branches or columnar
+    bool columnar = IExtractedTree::IsColumnar((TTree*)source->Get("HLED"));
+    fl_merge->cd();
+    IExtractedTree *hledOut = new IExtractedTree(tHLED, 512, columnar, false);
+    /*IExtractedTree *biFocalOut = new IExtractedTree(tBiFocal, 512, columnar, true);
+    IExtractedTree *forcedOut = new IExtractedTree(tForced, 512, columnar, false);
+    IExtractedTree *testOut = new IExtractedTree(tTest, 512, columnar, true);*/
+
     TTree *tHLEDIn= 0;
     /*TTree *tBiFocalIn = 0;
     TTree *tForcedIn = 0;
@@ -104,19 +89,6 @@ int MergeProcessedFiles (std::string MainDir,std::string fileNameOut){
 //    fileBiFocal.open(fnameBiFocal.c_str(),ios::out|ios::binary);
 //    fileForced.open(fnameForced.c_str(),ios::out|ios::binary);
 //    fileTest.open(fnameTest.c_str(),ios::out|ios::binary);
-	ExtractedData *evHLED[512];
-	/*ExtractedData *evBiFocal[512];
-	ExtractedData *evForced[512];
-	ExtractedData *evTest[512];*/
-
-    
-
-    for(int i = 0; i<512; i++){
-        evHLED[i] = 0;
-        /*evBiFocal[i] = 0;
-        evForced[i] =0;
-        evTest[i] = 0;*/
-    }
 
 	
     while(source){
@@ -128,57 +100,61 @@ int MergeProcessedFiles (std::string MainDir,std::string fileNameOut){
         tBiFocalIn = (TTree*)source->Get("BiFocal");*/
         
 
-        for(int i = 0; i<512; i++){
-            tHLEDIn->SetBranchAddress(TString::Format("Pixel[%d]",i),&evHLED[i]);
-            
-            /*tBiFocalIn->SetBranchAddress(TString::Format("Pixel[%d]",i),&evBiFocal  [i]);
-            tTestIn->SetBranchAddress(TString::Format("Pixel[%d]",i),&evTest[i]);
-            tForcedIn->SetBranchAddress(TString::Format("Pixel[%d]",i),&evForced[i  ]);*/
-        }
-        tHLEDIn->SetBranchAddress(TString::Format("TriggerTime"),&eventTimeIn);
+        // either layout is read, whatever the layout of the merged tree
+        IExtractedTree *hledIn = new IExtractedTree(tHLEDIn, 512);
+        /*IExtractedTree *biFocalIn = new IExtractedTree(tBiFocalIn, 512);
+        IExtractedTree *testIn = new IExtractedTree(tTestIn, 512);
+        IExtractedTree *forcedIn = new IExtractedTree(tForcedIn, 512);*/
 	
-	   for(int i = 0; i<tHLEDIn->GetEntries(); i++){
-            tHLEDIn->GetEntry(i);
+	   for(int i = 0; i<hledIn->GetEntries(); i++){
+            hledIn->GetEntry(i);
             for(int j = 0; j<512; j++){
-                evHLEDOut[i] = evHLED[i];
+                hledOut->SetPixel(j, hledIn->GetPixel(j));
             }
-            eventTimeOut = eventTimeIn;
+            hledOut->SetTriggerTime(hledIn->GetTriggerTime());
 	   	
             fl_merge->cd();
-            tHLED->Fill();
+            hledOut->Fill();
 
             if(i%100==0){
                 cout<<"Processed Event: "<<i<<endl;
             }
 	   }
 
-	/*for(int i = 0; i<tBiFocalIn->GetEntries(); i++){
-		tBiFocalIn->GetEntry(i);
+	/*for(int i = 0; i<biFocalIn->GetEntries(); i++){
+		biFocalIn->GetEntry(i);
         for(int j = 0; j<512; j++){
-		  evBiFocalOut[i] = evBiFocal[i];
+		  biFocalOut->SetPixel(j, biFocalIn->GetPixel(j));
 		}
+		biFocalOut->SetTriggerTime(biFocalIn->GetTriggerTime());
         fl_merge->cd();
-		tBiFocal->Fill();
+		biFocalOut->Fill();
 	}
 
-	for(int i = 0; i<tForcedIn->GetEntries(); i++){
-		tForcedIn->GetEntry(i);
+	for(int i = 0; i<forcedIn->GetEntries(); i++){
+		forcedIn->GetEntry(i);
         for(int j = 0; j<512; j++){
-		  evForcedOut[i] = evForced[i];
+		  forcedOut->SetPixel(j, forcedIn->GetPixel(j));
         }
+		forcedOut->SetTriggerTime(forcedIn->GetTriggerTime());
 		fl_merge->cd();
-		tForced->Fill();
+		forcedOut->Fill();
 	}
 
-	for(int i = 0; i<tTestIn->GetEntries(); i++){
-		tTestIn->GetEntry(i);
+	for(int i = 0; i<testIn->GetEntries(); i++){
+		testIn->GetEntry(i);
         for(int j = 0; j<512; j++){
-            evTestOut[i] = evTest[i];
+            testOut->SetPixel(j, testIn->GetPixel(j));
         }
+		testOut->SetTriggerTime(testIn->GetTriggerTime());
 		fl_merge->cd();
-		tTest->Fill();
+		testOut->Fill();
 	}*/
 
+	// the buffers of hledIn go with it, the tree must not keep their addresses
+	tHLEDIn->ResetBranchAddresses();
+	delete hledIn;
+
 
 	//fileHLED.write((char*)tHLEDIn,sizeof(tHLEDIn));
 	//fileForced.write((char*)tForcedIn,sizeof(tForcedIn));
@@ -206,6 +182,7 @@ int MergeProcessedFiles (std::string MainDir,std::string fileNameOut){
     fl_merge->cd();
     //fl_merge->Write();
     fl_merge->Close();
+    delete hledOut;
 
 
     return 0;
@@ -16,7 +16,6 @@ void FindBin(int pixelID,int *nx, int *ny)
             //Float_t tmp = 0;
 
 int PlotHLEDDistribution(std::string fileName){
-	ExtractedData *ex[512];
 	vector<float> *correctionFactors = 0;
 	unsigned long long timeTrig = 0;
 
@@ -24,11 +23,8 @@ int PlotHLEDDistribution(std::string fileName){
 	TTree *t = (TTree*)f->Get("HLED");
 	//TTree *t_c = (TTree*)f->Get("CorrectionFactor");
 	//t_c->SetBranchAddress("CorectionFactors",&correctionFactors);
-	for(int i = 0; i < 512; i++){
-		ex[i] = new ExtractedData();
-		t->SetBranchAddress(TString::Format("Pixel[%d]",i),&ex[i]);
-	}
-	t->SetBranchAddress("TriggerTime",&timeTrig);
+	// Pixel[i] branches or columnar, as written by ExACT
+	IExtractedTree *extracted = new IExtractedTree(t, 512);
 
 	int nx, ny;
 
@@ -64,7 +60,8 @@ int PlotHLEDDistribution(std::string fileName){
 		h_bP[i] = new TH1F(TString::Format("h_bP[%d]",i),"",4096,0,4096);
 	}
 	for(int i = 0; i<nEntries; i++){
-		t->GetEntry(i);
+		extracted->GetEntry(i);
+		timeTrig = extracted->GetTriggerTime();
 		//t_c->GetEntry(i);
 		//cout<<timeTrig<<endl;
 		if(i==0){
@@ -79,26 +76,26 @@ int PlotHLEDDistribution(std::string fileName){
 			//cout<<timeTrig-timeTrigStart<<endl;
 			
 			if(nx>=20 && nx<= 23){
-				h_col_R[i%5]->Fill(ex[j]->GetAmplitude());
-				h_time[i%5][0]->Fill((timeTrig-timeTrigStart)/1e8,ex[j]->GetAmplitude());
+				h_col_R[i%5]->Fill(extracted->GetAmplitude(j));
+				h_time[i%5][0]->Fill((timeTrig-timeTrigStart)/1e8,extracted->GetAmplitude(j));
 			}else if(nx>=8 && nx<= 11){
-				h_col_L[i%5]->Fill(ex[j]->GetAmplitude());
-				h_time[i%5][1]->Fill((timeTrig-timeTrigStart)/1e8,ex[j]->GetAmplitude());
+				h_col_L[i%5]->Fill(extracted->GetAmplitude(j));
+				h_time[i%5][1]->Fill((timeTrig-timeTrigStart)/1e8,extracted->GetAmplitude(j));
 			}else if((nx>=16 && nx<= 19)&&(ny>=8 && ny<=11)){
-				h_bP[i%5]->Fill(ex[j]->GetAmplitude());
+				h_bP[i%5]->Fill(extracted->GetAmplitude(j));
 			}else{
-				h_time[i%5][2]->Fill((timeTrig-timeTrigStart)/1e8,ex[j]->GetAmplitude());
-				h_all[i%5]->Fill(ex[j]->GetAmplitude());
-				/*if(ex[j]->GetAmplitude()<1200 && i%5 == 3){
+				h_time[i%5][2]->Fill((timeTrig-timeTrigStart)/1e8,extracted->GetAmplitude(j));
+				h_all[i%5]->Fill(extracted->GetAmplitude(j));
+				/*if(extracted->GetAmplitude(j)<1200 && i%5 == 3){
 					cout<<j<<endl;
 				}*/
 			}
 			if(i%5 ==3){
 				// /cout<<nx<<endl;
-				p_cam->Fill(nx,ny,ex[j]->GetAmplitude());
+				p_cam->Fill(nx,ny,extracted->GetAmplitude(j));
 			}
-			h_sum[i%5]->Fill(ex[j]->GetAmplitude());
-			h_time[i%5][3]->Fill((timeTrig-timeTrigStart)/1e8,ex[j]->GetAmplitude());
+			h_sum[i%5]->Fill(extracted->GetAmplitude(j));
+			h_time[i%5][3]->Fill((timeTrig-timeTrigStart)/1e8,extracted->GetAmplitude(j));
 		}
 		
 	}
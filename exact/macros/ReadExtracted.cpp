@@ -6,18 +6,17 @@ R__LOAD_LIBRARY(libExACT.so)
 
 int ReadExtracted (){
 	std::string filename =  "Extraction.root";
-	ExtractedData *ex = new ExtractedData();
 
 	TFile *f = new TFile(filename.c_str(), "READ");
-	TTree *t = (TTree*)f->Get("t1");
+	TTree *t = (TTree*)f->Get("BiFocal");
+	// Pixel[i] branches or columnar, as written by ExACT
+	IExtractedTree *extracted = new IExtractedTree(t, 512);
 
 	TH1 *h = new TH1F("h","hist",4096,0,4096);
 
-	t->SetBranchAddress("Pixel[100]",&ex);
-
-	for(int i = 0; i<t->GetEntries();i++){
-		t->GetEntry(i);
-		h->Fill(ex->GetAmplitude());
+	for(int i = 0; i<extracted->GetEntries();i++){
+		extracted->GetEntry(i);
+		h->Fill(extracted->GetAmplitude(100));
 	}
 
 	TCanvas *c = new TCanvas("c","Canvas",800,500);
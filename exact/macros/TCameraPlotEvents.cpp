@@ -213,8 +213,9 @@ void PlotEvent()
          }
 
         Pulse *pulse;
+        std::vector<UShort_t> row;
         for(int j = 0; j<MaxNofChannels; j++){
-                pulse = new Pulse(ev->GetSignalValue(j));
+                pulse = new Pulse(ev->GetSignalRow(j,row),ev->GetNSamples(),200,300);
 
                 extractedDataHLED[j]->SetAmplitude(pulse->GetAmplitude());
                 int nx, ny;
@@ -6,195 +6,22 @@ R__LOAD_LIBRARY(libExACT.so)
 
 int TelescopeInformationMerge (std::string filename1, std::string filename2, std::string filenameTilt, std::string filenameTiltRaw ,std::string filename, std::string fileOut){
 
-	std::vector<std::string> headers;
-	std::vector<std::vector<std::string>> data;
-	std::vector<std::string> headers2;
-	std::vector<std::vector<std::string>> data2;
-    std::vector<std::string> headersTilt;
-    std::vector<std::vector<std::string>> dataTilt;
-    std::vector<std::string> headersTiltRaw;
-    std::vector<std::vector<std::string>> dataTiltRaw;
-
-	std::ifstream file1(filename1);
-
-    int timestamp2Index, timestampIndex;
-    if (!file1.is_open()) {
-        throw std::runtime_error("Failed to open file: " + filename1);
-    }
-
-    std::string line;
-    if (std::getline(file1, line)) {
-        std::stringstream ss(line);
-        std::string header;
-        while (ss >> header) {
-            headers.push_back(header);
-        }
-    }
-
-    if (headers.empty() || headers.size() != 9) {
+    // Housekeeping tables, parsed once and searched by time for every event
+    IHousekeeping data(filename1);
+    if (data.GetHeaders().size() != 9) {
         throw std::runtime_error("Invalid file format: " + filename1);
     }
-
-    timestampIndex = 0;
-    for (int i = 0; i < headers.size(); ++i) {
-        if (headers[i] == "timestamp") {
-            timestampIndex = i;
-            break;
-        }
-    }
-
-    while (std::getline(file1, line)) {
-        std::stringstream ss(line);
-        std::string cell;
-        std::vector<std::string> row;
-
-        while (ss >> cell) {
-            row.push_back(cell);
-        }
-
-        if (row.size() != headers.size()) {
-            throw std::runtime_error("Invalid file format: " + filename1);
-        }
-
-        data.push_back(row);
+    IHousekeeping data2(filename2);
+    // IEvent reads the tilt angle from column 3 of the tilt table and column 1 of the raw one
+    IHousekeeping dataTilt(filenameTilt);
+    if (dataTilt.GetHeaders().size() < 4) {
+        throw std::runtime_error("Invalid file format, no tilt angle column: " + filenameTilt);
     }
-
-    file1.close();
-
-    std::ifstream file2(filename2);
-    if (!file2.is_open()) {
-        throw std::runtime_error("Failed to open file: " + filename2);
-    }
-
-    if (std::getline(file2, line)) {
-        std::stringstream ss(line);
-        std::string header;
-        while (ss >> header) {
-            headers2.push_back(header);
-        }
-    }
-
-    if (headers2.empty()) {
-        throw std::runtime_error("Invalid file format: " + filename2);
-    }
-
-    timestamp2Index = 0;
-    for (int i = 0; i < headers2.size(); ++i) {
-        if (headers2[i] == "timestamp2") {
-            timestamp2Index = i;
-            break;
-        }
-    }
-
-    while (std::getline(file2, line)) {
-        std::stringstream ss(line);
-        std::string cell;
-        std::vector<std::string> row;
-
-        while (ss >> cell) {
-            row.push_back(cell);
-        }
-
-        if (row.size() != headers2.size()) {
-            throw std::runtime_error("Invalid file format: " + filename2);
-        }
-
-        data2.push_back(row);
-    }
-
-    file2.close();
-
-
-    std::ifstream file3(filenameTilt);
-    if (!file3.is_open()) {
-        throw std::runtime_error("Failed to open file: " + filenameTilt);
-    }
-
-    if (std::getline(file3, line)) {
-        std::stringstream ss(line);
-        std::string header;
-        while (ss >> header) {
-            headersTilt.push_back(header);
-        }
-    }
-
-    if (headersTilt.empty()) {
-        cout<<"Header"<<endl;
-        throw std::runtime_error("Invalid file format: " + filenameTilt);
-    }
-
-    timestamp2Index = 0;
-   /* for (int i = 0; i < headers2.size(); ++i) {
-        if (headers2[i] == "timestamp") {
-            timestamp2Index = i;
-            break;
-        }
-    }*/
-
-    while (std::getline(file3, line)) {
-        std::stringstream ss(line);
-        std::string cell;
-        std::vector<std::string> row;
-
-        while (ss >> cell) {
-            row.push_back(cell);
-        }
-
-        if (row.size() != headersTilt.size()) {
-            cout<<"Row"<<endl;
-            throw std::runtime_error("Invalid file format: " + filenameTilt);
-        }
-
-        dataTilt.push_back(row);
-    }
-
-    file3.close();
-
-    std::ifstream file4(filenameTiltRaw);
-    if (!file4.is_open()) {
-        throw std::runtime_error("Failed to open file: " + filenameTiltRaw);
-    }
-
-    if (std::getline(file4, line)) {
-        std::stringstream ss(line);
-        std::string header;
-        while (ss >> header) {
-            headersTiltRaw.push_back(header);
-        }
-    }
-
-    if (headersTilt.empty() || headersTilt.size() != 2) {
-        cout<<"Header"<<endl;
+    IHousekeeping dataTiltRaw(filenameTiltRaw);
+    if (dataTiltRaw.GetHeaders().size() != 2) {
         throw std::runtime_error("Invalid file format: " + filenameTiltRaw);
     }
 
-    timestamp2Index = 0;
-   /* for (int i = 0; i < headers2.size(); ++i) {
-        if (headers2[i] == "timestamp") {
-            timestamp2Index = i;
-            break;
-        }
-    }*/
-
-    while (std::getline(file4, line)) {
-        std::stringstream ss(line);
-        std::string cell;
-        std::vector<std::string> row;
-
-        while (ss >> cell) {
-            row.push_back(cell);
-        }
-
-        if (row.size() != headersTiltRaw.size()) {
-            cout<<"Row"<<endl;
-            throw std::runtime_error("Invalid file format: " + filenameTiltRaw);
-        }
-
-        dataTiltRaw.push_back(row);
-    }
-
-    file4.close();
-
     ULong64_t normalizedTime = 1683936000;
     ULong64_t normalizedTimeNs = 1683936000*1e8; //Should be in 10s of ns
     ULong64_t timeAfterLaunch = 0;
@@ -253,9 +80,7 @@ int TelescopeInformationMerge (std::string filename1, std::string filename2, std
         iEvHLED->SetROIMusicID(evHLED->GetROIMusicID());
         iEvHLED->SetSignalValue(evHLED->GetSignalValue());
 
-        iEvHLED->SetParametersFromTimestamp(timeAfterLaunch,data,data2);
-        iEvHLED->SetTelescopePointing(timeAfterLaunch,dataTilt);
-        iEvHLED->SetTelescopePointingRaw(timeAfterLaunch,dataTiltRaw);
+        iEvHLED->SetHousekeeping(timeAfterLaunch,data,data2,dataTilt,dataTiltRaw);
 
 
         tMHLED->Fill();
@@ -277,9 +102,7 @@ int TelescopeInformationMerge (std::string filename1, std::string filename2, std
         iEvBiFocal->SetROIMusicID(evBiFocal->GetROIMusicID());
         iEvBiFocal->SetSignalValue(evBiFocal->GetSignalValue());
 
-        iEvBiFocal->SetParametersFromTimestamp(timeAfterLaunch,data,data2);
-        iEvBiFocal->SetTelescopePointing(timeAfterLaunch,dataTilt);
-        iEvBiFocal->SetTelescopePointingRaw(timeAfterLaunch,dataTiltRaw);
+        iEvBiFocal->SetHousekeeping(timeAfterLaunch,data,data2,dataTilt,dataTiltRaw);
 
         fOut->cd();
         tMBiFocal->Fill();
@@ -301,9 +124,7 @@ int TelescopeInformationMerge (std::string filename1, std::string filename2, std
         iEvForced->SetROIMusicID(evForced->GetROIMusicID());
         iEvForced->SetSignalValue(evForced->GetSignalValue());
 
-        iEvForced->SetParametersFromTimestamp(timeAfterLaunch,data,data2);
-        iEvForced->SetTelescopePointing(timeAfterLaunch,dataTilt);
-        iEvForced->SetTelescopePointingRaw(timeAfterLaunch,dataTiltRaw);
+        iEvForced->SetHousekeeping(timeAfterLaunch,data,data2,dataTilt,dataTiltRaw);
 
 
         fOut->cd();
@@ -326,9 +147,7 @@ int TelescopeInformationMerge (std::string filename1, std::string filename2, std
         iEvTest->SetROIMusicID(evTest->GetROIMusicID());
         iEvTest->SetSignalValue(evTest->GetSignalValue());
 
-        iEvTest->SetParametersFromTimestamp(timeAfterLaunch,data,data2);
-        iEvTest->SetTelescopePointing(timeAfterLaunch,dataTilt);
-        iEvTest->SetTelescopePointingRaw(timeAfterLaunch,dataTiltRaw);
+        iEvTest->SetHousekeeping(timeAfterLaunch,data,data2,dataTilt,dataTiltRaw);
 
         fOut->cd();
         tMTest->Fill();
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <TROOT.h>
 #include <TFile.h>
+#include <TMemFile.h>
 #include <TList.h>
 #include <TKey.h>
 #include <TTree.h>
@@ -19,6 +20,7 @@
 #include <stdio.h>
 #include <dirent.h>
 #include <sys/types.h>
+#include <thread>
 
 // libExACT objects
 #include <ExtractedData.h>
@@ -27,6 +29,8 @@
 #include <GoldPlated.h>
 #include <BiFocal.h>
 #include <Pulse.h>
+#include <PulseBatch.h>
+#include <IExtractedTree.h>
 
 // ExACT Objects
 //#include "Pulse.h"
@@ -101,6 +105,8 @@ void StarlinkFileExtraction(ReadConfiguration *readConf,string dataFilePrefix){
 	Pulse *pulse;
 
 	Pulse *pulseLeft, *pulseRight;
+	// flat trace of the pixels without stored trace
+	vector<UShort_t> row;
 
 	vector<Int_t> musicIDsROI = vector<Int_t>(2);
 	Int_t maxChg = 0;
@@ -112,7 +118,7 @@ void StarlinkFileExtraction(ReadConfiguration *readConf,string dataFilePrefix){
 		musicIDsROI = eventBifocal->GetROIMusicID();
 		//cout<<"Now here"<<endl;
 		for(int j = musicIDsROI[0]*8; j<musicIDsROI[0]*8+8; j++){
-			pulse = new Pulse(readConf,eventBifocal->GetSignalValue(j));
+			pulse = new Pulse(readConf,eventBifocal->GetSignalRow(j,row),eventBifocal->GetNSamples());
 			if(pulse->GetAmplitude()>maxChg){
 				maxPxID = j;
 				maxChg = pulse->GetAmplitude();
@@ -121,8 +127,8 @@ void StarlinkFileExtraction(ReadConfiguration *readConf,string dataFilePrefix){
 		}
 
 		//cout<<"Out of the woods"<<endl;
-		pulseLeft = new Pulse(readConf,eventBifocal->GetSignalValue(maxPxID));
-		pulseRight = new Pulse(readConf,eventBifocal->GetSignalValue(maxPxID+8));
+		pulseLeft = new Pulse(readConf,eventBifocal->GetSignalRow(maxPxID,row),eventBifocal->GetNSamples());
+		pulseRight = new Pulse(readConf,eventBifocal->GetSignalRow(maxPxID+8,row),eventBifocal->GetNSamples());
 		if(CheckTriggerGeometry(pulseLeft->GetTimePeak(),pulseRight->GetTimePeak())){
 			if(CheckIsAboveThreshold(pulseLeft->GetAmplitude(), 
 				pulseRight->GetAmplitude(),
@@ -146,13 +152,13 @@ void StarlinkFileExtraction(ReadConfiguration *readConf,string dataFilePrefix){
 		treeInTest->GetEntry(i);
 		musicIDsROI = eventTest->GetROIMusicID();
 		for(int j = musicIDsROI[0]*8; j<musicIDsROI[0]*8+8; j++){
-			pulse = new Pulse(readConf,eventTest->GetSignalValue(j));
+			pulse = new Pulse(readConf,eventTest->GetSignalRow(j,row),eventTest->GetNSamples());
 			if(pulse->GetAmplitude()>maxChg){
 				maxPxID = j;
 				maxChg = pulse->GetAmplitude();
 			}
-			pulseLeft = new Pulse(readConf,eventTest->GetSignalValue(maxPxID));
-			pulseRight = new Pulse(readConf,eventTest->GetSignalValue(maxPxID+8));
+			pulseLeft = new Pulse(readConf,eventTest->GetSignalRow(maxPxID,row),eventTest->GetNSamples());
+			pulseRight = new Pulse(readConf,eventTest->GetSignalRow(maxPxID+8,row),eventTest->GetNSamples());
 			if(CheckIsAboveThreshold(pulseLeft->GetAmplitude(),
 				pulseRight->GetAmplitude(),
 				readConf->softwareThresholdLvl)){
@@ -181,242 +187,173 @@ void StarlinkFileExtraction(ReadConfiguration *readConf,string dataFilePrefix){
 	cout<<"Done"<<endl;
 }
 
-void PulseExtraction(ReadConfiguration *readConf,string dataFilePrefix){
-	string dataFileName = dataFilePrefix + ".root";
-	
-	string extractedFileName = dataFilePrefix + "_Extracted"+".root";
-	//string treeName;
-	Int_t nEventsHLED, nEventsForced, nEventsBiFocal, nEventsTest;
-
-	nEventsHLED = 0;
-	nEventsForced = 0;
-	nEventsBiFocal = 0;
-	nEventsTest = 0;
-
-	TFile *fileIn = new TFile(dataFileName.c_str(),"READ");
-	TTree *treeInHLED = (TTree*)fileIn->Get("HLED");
-	TTree *treeInForced = (TTree*)fileIn->Get("Forced");
-	TTree *treeInBiFocal = (TTree*)fileIn->Get("BiFocal");
-	TTree *treeInTest = (TTree*)fileIn->Get("Test");
-
-	Event *eventHLED = new Event();
-	Event *eventForced = new Event();
-	Event *eventBifocal = new Event();
-	Event *eventTest = new Event();
-
-	treeInHLED->SetBranchAddress("Events", &eventHLED);
-	treeInForced->SetBranchAddress("Events", &eventForced);
-	treeInBiFocal->SetBranchAddress("Events", &eventBifocal);
-	treeInTest->SetBranchAddress("Events",&eventTest);
-
-	// TTree *treeH= (TTree*)fileIn->Get(treeName.c_str());
-
-
-
-	TFile *fileOut = new TFile	(extractedFileName.c_str(),"RECREATE");
-	TTree *treeOutHLED = new TTree("HLED","Extracted Data");
-	TTree *treeOutForced = new TTree("Forced","Extracted Data");
-	TTree *treeOutBifocal = new TTree("BiFocal","Extracted Data");
-	TTree *treeOutTest = new TTree("Test","Extracted Data");
-	//TTree *treeOutCorrectionFactor = new TTree("Corrections", "Calibration Factors");
-
-	//vector<float> corrFactor = vector<float>(readConf->nPixelsCamera);
-
-	ExtractedData *extractedDataHLED[readConf->nPixelsCamera];
-	ExtractedData *extractedDataForced[readConf->nPixelsCamera];
-	ExtractedData *extractedDataBifocal[readConf->nPixelsCamera];
-	ExtractedData *extractedDataTest[readConf->nPixelsCamera];
-
-	unsigned long long triggerTimeHLED, triggerTimeForced, triggerTimeBifocal, triggerTimeTest;
-	triggerTimeHLED = 0;
-	triggerTimeForced = 0;
-	triggerTimeBifocal = 0;
-	triggerTimeTest = 0;
-
-	BiFocal *bifocalInfo = 0;
-	bifocalInfo = new BiFocal();
-
-	BiFocal *bifocalInfoTest = 0;
-	bifocalInfoTest = new BiFocal();
-
-	for (int i = 0; i<readConf->nPixelsCamera; i++){
-		extractedDataHLED[i] = 0;
-		extractedDataForced[i] = 0;
-		extractedDataBifocal[i] = 0;
-		extractedDataTest[i] = 0;
-
-		extractedDataHLED[i] = new ExtractedData();
-		extractedDataForced[i] = new ExtractedData();
-		extractedDataBifocal[i] = new ExtractedData();
-		extractedDataTest[i] = new ExtractedData();	
-	}
-
-	for (int i = 0; i<readConf->nPixelsCamera; i++){
-		treeOutHLED->Branch(TString::Format("Pixel[%d]",i),
-			"ExtractedData",&extractedDataHLED[i],64000,0);
-		treeOutForced->Branch(TString::Format("Pixel[%d]",i),
-			"ExtractedData",&extractedDataForced[i],64000,0);
-		treeOutBifocal->Branch(TString::Format("Pixel[%d]",i),
-			"ExtractedData",&extractedDataBifocal[i],64000,0);
-		treeOutTest->Branch(TString::Format("Pixel[%d]",i),
-			"ExtractedData",&extractedDataTest[i],64000,0);
-		//treeOutCorrectionFactor->Branch(TString::Format("Pixel[%d]",i),&corrFactor[i]);
-		//cout<<&extractedData[i]<<endl;
-	}
-	treeOutHLED->Branch("TriggerTime", &triggerTimeHLED);
-	treeOutForced->Branch("TriggerTime", &triggerTimeForced);
-	treeOutBifocal->Branch("TriggerTime", &triggerTimeBifocal);
-	treeOutTest->Branch("TriggerTime", &triggerTimeTest);
-
-	treeOutBifocal->Branch("TriggerRegion","BiFocal",bifocalInfo,64000,0);
-	treeOutTest->Branch("TriggerRegion","BiFocal",bifocalInfoTest,64000,0);
-
-
-	nEventsHLED = treeInHLED->GetEntries();
-	nEventsForced = treeInForced->GetEntries();
-	nEventsBiFocal = treeInBiFocal->GetEntries();
-	nEventsTest = treeInTest->GetEntries();
-
-
-	Pulse *pulse;
-
-	// Extract all of the HLED events in the included file
-	for(int i = 0; i<nEventsHLED; i++){
-		fileIn->cd();
-		treeInHLED->GetEntry(i);
+// Reader of one input tree for a pulse extraction worker, with its own file, Event and PulseBatch
+struct ExtractionWorker {
+	TFile *file;
+	TTree *tree;
+	Event *event;
+	PulseBatch *pulseBatch;
+};
+
+// Values a worker extracted from one entry, filled into the output tree in entry order
+struct ExtractedEntry {
+	vector<ExtractedData> pixels;
+	unsigned long long triggerTime;
+	vector<Int_t> roiPixelID;
+	vector<Int_t> roiMusicID;
+};
+
+// entries extracted by every worker between two fills of the output tree
+#define ExtractionChunkSize 64
+
+void ExtractEntries(ReadConfiguration *readConf, ExtractionWorker *worker, Long64_t first, Long64_t last, ExtractedEntry *entries){
+	for(Long64_t i = first; i<last; i++){
+		ExtractedEntry &entry = entries[i-first];
+		worker->tree->GetEntry(i);
+		worker->pulseBatch->Extract(worker->event);
+		entry.pixels.resize(readConf->nPixelsCamera);
 		for(int j = 0; j<readConf->nPixelsCamera; j++){
-			pulse = new Pulse(readConf,eventHLED->GetSignalValue(j));
 			if(readConf->amplitudeExtraction){
-				extractedDataHLED[j]->SetAmplitude(pulse->GetAmplitude());
-				extractedDataHLED[j]->SetTimePeak(pulse->GetTimePeak());
+				entry.pixels[j].SetAmplitude(worker->pulseBatch->GetAmplitude(j));
+				entry.pixels[j].SetTimePeak(worker->pulseBatch->GetTimePeak(j));
 			}
 			if(readConf->chargeExtraction){
-				extractedDataHLED[j]->SetCharge(pulse->GetCharge());
-			}
-			if(j==322){
-				//cout<<"Charge"<<pulse->GetAmplitude()<<endl;;
+				entry.pixels[j].SetCharge(worker->pulseBatch->GetCharge(j));
 			}
-			extractedDataHLED[j]->SetPedestal(round(pulse->GetPedestal()));
-			extractedDataHLED[j]->SetPedestalRMS((pulse->GetPedestalRMS()));
-			//extractedDataHLED[j]->SetEventTime(eventHLED->GetTBTime());
-			/*if(readConf->revolvingTimeWindow){
-				extractedData[j]->SetTimePeak(pulse->GetTimePeak());
-			}*/
+			entry.pixels[j].SetPedestal(round(worker->pulseBatch->GetPedestal(j)));
+			entry.pixels[j].SetPedestalRMS((worker->pulseBatch->GetPedestalRMS(j)));
 		}
+		entry.triggerTime = worker->event->GetTBTime();
+		entry.roiPixelID = worker->event->GetROIPixelID();
+		entry.roiMusicID = worker->event->GetROIMusicID();
+	}
+}
 
-		triggerTimeHLED = eventHLED->GetTBTime();
-
-		if (i%50 ==0){
-			cout << "Extracting Event: "<<i<<" from HLED tree"<<endl;
-		}
-		fileOut->cd();
-		treeOutHLED->Fill();
+/**
+ * Starts the workers on the entries [start, end), split in consecutive ranges.
+ * @param chunk receives the entries, chunk[0] is entry start
+ */
+void StartChunk(ReadConfiguration *readConf, vector<ExtractionWorker> &workers, Long64_t start, Long64_t end,
+		ExtractedEntry *chunk, vector<std::thread> &threads){
+	Long64_t nWorkers = workers.size();
+	Long64_t perWorker = (end - start + nWorkers - 1)/nWorkers;
+	for(int w = 0; w<nWorkers && start + w*perWorker<end; w++){
+		Long64_t first = start + w*perWorker;
+		Long64_t last = TMath::Min(end, first + perWorker);
+		threads.push_back(std::thread(ExtractEntries, readConf, &workers[w], first, last, chunk + (first - start)));
+	}
+}
 
+/**
+ * Extracts every entry of one tree of the EventBuilder file into treeOut.
+ * The entries are split in consecutive ranges over readConf->nThreads workers, each
+ * reading its own copy of the input tree. The output tree is filled in entry order
+ * while the workers extract the next chunk.
+ */
+void ExtractTree(ReadConfiguration *readConf, string dataFileName, string treeName, TDirectory *fileOut, IExtractedTree *treeOut){
+	Int_t nThreads = TMath::Max(readConf->nThreads, 1);
+	vector<ExtractionWorker> workers(nThreads);
+	for(int w = 0; w<nThreads; w++){
+		workers[w].file = new TFile(dataFileName.c_str(),"READ");
+		workers[w].tree = (TTree*)workers[w].file->Get(treeName.c_str());
+		workers[w].event = new Event();
+		workers[w].tree->SetBranchAddress("Events", &workers[w].event);
+		workers[w].pulseBatch = new PulseBatch(readConf);
 	}
+	Long64_t nEvents = workers[0].tree->GetEntries();
+
+	// two chunks: one being extracted while the other is written
+	Long64_t chunkSize = (Long64_t)nThreads*ExtractionChunkSize;
+	vector<ExtractedEntry> chunks[2];
+	chunks[0].resize(chunkSize);
+	chunks[1].resize(chunkSize);
+	vector<std::thread> threads;
+
+	StartChunk(readConf, workers, 0, TMath::Min(nEvents, chunkSize), &chunks[0][0], threads);
+	for(Long64_t chunkStart = 0; chunkStart<nEvents; chunkStart += chunkSize){
+		Long64_t chunkEnd = TMath::Min(nEvents, chunkStart + chunkSize);
+		ExtractedEntry *chunk = &chunks[(chunkStart/chunkSize)%2][0];
+		for(size_t t = 0; t<threads.size(); t++) threads[t].join();
+		threads.clear();
+		if(chunkEnd<nEvents){
+			StartChunk(readConf, workers, chunkEnd, TMath::Min(nEvents, chunkEnd + chunkSize), &chunks[(chunkEnd/chunkSize)%2][0], threads);
+		}
 
-	// Extract all Forced trigger events in file
-	for(int i = 0; i<nEventsForced; i++){
-		fileIn->cd();
-		treeInForced->GetEntry(i);
-		for(int j = 0; j<readConf->nPixelsCamera; j++){
-			pulse = new Pulse(readConf,eventForced->GetSignalValue(j));
-			if(readConf->amplitudeExtraction){
-				extractedDataForced[j]->SetAmplitude(pulse->GetAmplitude());
-				extractedDataForced[j]->SetTimePeak(pulse->GetTimePeak());
+		for(Long64_t i = chunkStart; i<chunkEnd; i++){
+			ExtractedEntry &entry = chunk[i - chunkStart];
+			for(int j = 0; j<readConf->nPixelsCamera; j++){
+				treeOut->SetPixel(j, &entry.pixels[j]);
 			}
-			if(readConf->chargeExtraction){
-				extractedDataForced[j]->SetCharge(pulse->GetCharge());
+			treeOut->SetTriggerTime(entry.triggerTime);
+			treeOut->SetTriggerRegion(entry.roiPixelID, entry.roiMusicID);
+			if (i%50 ==0){
+				cout << "Extracting Event: "<<i<<" from "<<treeName<<" tree"<<endl;
 			}
-			extractedDataForced[j]->SetPedestal(round(pulse->GetPedestal()));
-			extractedDataForced[j]->SetPedestalRMS((pulse->GetPedestalRMS()));
-			//extractedDataForced[j]->SetEventTime(eventHLED->GetTBTime());
-			/*if(readConf->revolvingTimeWindow){
-				extractedData[j]->SetTimePeak(pulse->GetTimePeak());
-			}*/
+			fileOut->cd();
+			treeOut->Fill();
 		}
-		triggerTimeForced = eventForced->GetTBTime();
-		if (i%50 ==0){
-			cout << "Extracting Event: "<<i<<" from Forced tree"<<endl;
-		}
-		fileOut->cd();
-		treeOutForced->Fill();
-
 	}
 
-	// Extract all BiFocal Events in file
-	for(int i = 0; i<nEventsBiFocal; i++){
-		fileIn->cd();
-		treeInBiFocal->GetEntry(i);
-		for(int j = 0; j<readConf->nPixelsCamera; j++){
-			pulse = new Pulse(readConf,eventBifocal->GetSignalValue(j));
-			//sleep(3);
-			//cout<<pulse->GetAmplitude()<<" "<<endl;
-
-			if(readConf->amplitudeExtraction){
-				
-				extractedDataBifocal[j]->SetAmplitude(pulse->GetAmplitude());
-				extractedDataBifocal[j]->SetTimePeak(pulse->GetTimePeak());
-			}
-			if(readConf->chargeExtraction){
-				extractedDataBifocal[j]->SetCharge(pulse->GetCharge());
-			}
-			extractedDataBifocal[j]->SetPedestal(round(pulse->GetPedestal()));
-			extractedDataBifocal[j]->SetPedestalRMS((pulse->GetPedestalRMS()));
-			//extractedDataBifocal[j]->SetEventTime(eventHLED->GetTBTime());
-			
-		}
+	for(int w = 0; w<nThreads; w++){
+		delete workers[w].pulseBatch;
+		workers[w].file->Close();
+		delete workers[w].file;
+		delete workers[w].event;
+	}
+}
 
-		//cout<<endl;
-		
-		triggerTimeBifocal = eventBifocal->GetTBTime();
-		bifocalInfo->SetROIPixelIDs(eventBifocal->GetROIPixelID());
-		bifocalInfo->SetTrigMUSICIDs(eventBifocal->GetROIMusicID());
-		if (i%50 ==0){
-			cout << "Extracting Event: "<<i<<" from BiFocal tree"<<endl;
-		}
-		fileOut->cd();
-		treeOutBifocal->Fill();
+/**
+ * Extracts the four trees of the EventBuilder file into fileOut, _Extracted.root or the
+ * in-memory file of the pipeline. The trees are left in fileOut, not written.
+ */
+void PulseExtraction(ReadConfiguration *readConf, string dataFilePrefix, TDirectory *fileOut){
+	string dataFileName = dataFilePrefix + ".root";
 
+	// workers read their own copies of the input trees
+	if(readConf->nThreads>1){
+		ROOT::EnableThreadSafety();
 	}
 
-	for(int i = 0; i<nEventsTest; i++){
-		fileIn->cd();
-		treeInTest->GetEntry(i);
-		for(int j = 0; j<readConf->nPixelsCamera; j++){
-			pulse = new Pulse(readConf,eventTest->GetSignalValue(j));
-			//sleep(3);
-			//cout<<pulse->GetAmplitude()<<" "<<endl;
+	fileOut->cd();
+	TTree *treeOutHLED = new TTree("HLED","Extracted Data");
+	TTree *treeOutForced = new TTree("Forced","Extracted Data");
+	TTree *treeOutBifocal = new TTree("BiFocal","Extracted Data");
+	TTree *treeOutTest = new TTree("Test","Extracted Data");
+	//TTree *treeOutCorrectionFactor = new TTree("Corrections", "Calibration Factors");
 
-			if(readConf->amplitudeExtraction){
-				
-				extractedDataTest[j]->SetAmplitude(pulse->GetAmplitude());
-				extractedDataTest[j]->SetTimePeak(pulse->GetTimePeak());
-			}
-			if(readConf->chargeExtraction){
-				extractedDataTest[j]->SetCharge(pulse->GetCharge());
-			}
-			extractedDataTest[j]->SetPedestal(round(pulse->GetPedestal()));
-			extractedDataTest[j]->SetPedestalRMS((pulse->GetPedestalRMS()));
-			//extractedDataBifocal[j]->SetEventTime(eventHLED->GetTBTime());
-			
-		}
+	//vector<float> corrFactor = vector<float>(readConf->nPixelsCamera);
 
-		//cout<<endl;
-		
-		triggerTimeTest = eventTest->GetTBTime();
-		bifocalInfoTest->SetROIPixelIDs(eventTest->GetROIPixelID());
-		bifocalInfoTest->SetTrigMUSICIDs(eventTest->GetROIMusicID());
-		if (i%50 ==0){
-			cout << "Extracting Event: "<<i<<" from Test tree"<<endl;
-		}
-		fileOut->cd();
-		treeOutTest->Fill();
+	// Pixel[i] branches or one array branch per quantity, see COLUMNAREXTRACTED
+	IExtractedTree *extractedHLED = new IExtractedTree(treeOutHLED, readConf->nPixelsCamera, readConf->columnarExtracted, false);
+	IExtractedTree *extractedForced = new IExtractedTree(treeOutForced, readConf->nPixelsCamera, readConf->columnarExtracted, false);
+	IExtractedTree *extractedBifocal = new IExtractedTree(treeOutBifocal, readConf->nPixelsCamera, readConf->columnarExtracted, true);
+	IExtractedTree *extractedTest = new IExtractedTree(treeOutTest, readConf->nPixelsCamera, readConf->columnarExtracted, true);
+
+	ExtractTree(readConf, dataFileName, "HLED", fileOut, extractedHLED);
+	ExtractTree(readConf, dataFileName, "Forced", fileOut, extractedForced);
+	ExtractTree(readConf, dataFileName, "BiFocal", fileOut, extractedBifocal);
+	ExtractTree(readConf, dataFileName, "Test", fileOut, extractedTest);
+
+	// later stages may read the trees in memory, they must not use the buffers of the writers
+	treeOutHLED->ResetBranchAddresses();
+	treeOutForced->ResetBranchAddresses();
+	treeOutBifocal->ResetBranchAddresses();
+	treeOutTest->ResetBranchAddresses();
+	delete extractedHLED;
+	delete extractedForced;
+	delete extractedBifocal;
+	delete extractedTest;
+}
 
-	}
+void PulseExtraction(ReadConfiguration *readConf,string dataFilePrefix){
+	string extractedFileName = dataFilePrefix + "_Extracted"+".root";
+
+	TFile *fileOut = new TFile	(extractedFileName.c_str(),"RECREATE");
+	PulseExtraction(readConf, dataFilePrefix, fileOut);
 	
+	fileOut->cd();
 	fileOut->Write();
 	fileOut->Close();
-	fileIn->Close();
 	//treeOut->Write();
 	cout<<"Done"<<endl;
 }
@@ -492,14 +429,11 @@ void CopyDataFromExtractedBiFocal(ExtractedData *ex, ExtractedData *bf){
 	
 }
 
-void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix){
-	string extractedFileName = dataFilePrefix + "_Extracted.root";
-	string downloadFileName = dataFilePrefix + "_Download.root";
-	
-	//cout<<"Here"<<endl;
-
-	TFile *fileExtractedData = new TFile(extractedFileName.c_str(), "READ");
-
+/**
+ * Discriminates the BiFocal and Test events of the extracted trees in fileExtractedData and
+ * creates the trees of _Download.root in fileDownloadReady, without writing them.
+ */
+void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix, TDirectory *fileExtractedData, TDirectory *fileDownloadReady){
 	TTree *treeInHLED = (TTree*)fileExtractedData->Get("HLED");
 	TTree *treeInBiFocal = (TTree*)fileExtractedData->Get("BiFocal");
 	TTree *treeInForced = (TTree*)fileExtractedData->Get("Forced");
@@ -511,38 +445,28 @@ void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix){
 	nEventsBiFocal = treeInBiFocal->GetEntries();
 	nEventsTest = treeInTest->GetEntries();
 
+	// reads both the Pixel[i] and the columnar layout
+	IExtractedTree *extractedBiFocal = new IExtractedTree(treeInBiFocal, readConf->nPixelsCamera);
+	IExtractedTree *extractedTest = new IExtractedTree(treeInTest, readConf->nPixelsCamera);
+
 	ExtractedData *extractedDataBifocal[readConf->nPixelsCamera];
 	ExtractedData *extractedDataTest[readConf->nPixelsCamera];
-	BiFocal *bifocalInfo = 0;
-	BiFocal *bifocalInfoTest = 0;
+	BiFocal *bifocalInfo = extractedBiFocal->GetTriggerRegion();
+	BiFocal *bifocalInfoTest = extractedTest->GetTriggerRegion();
 	unsigned long long triggerTimeBifocal = 0;
 	unsigned long long triggerTimeTest = 0;
 
 	for (int i = 0; i<readConf->nPixelsCamera; i++){
-		extractedDataBifocal[i] = 0;
-		extractedDataBifocal[i] = new ExtractedData();
-		treeInBiFocal->SetBranchAddress(TString::Format("Pixel[%d]",i),&extractedDataBifocal[i]);
-		
-		extractedDataTest[i] = 0;
-		extractedDataTest[i] = new ExtractedData();
-		treeInTest->SetBranchAddress(TString::Format("Pixel[%d]",i),&extractedDataTest[i]);
+		extractedDataBifocal[i] = extractedBiFocal->GetPixel(i);
+		extractedDataTest[i] = extractedTest->GetPixel(i);
 	}
 
-	bifocalInfo = new BiFocal();
-	bifocalInfoTest = new BiFocal();
-
-	treeInTest->SetBranchAddress("TriggerRegion",&bifocalInfoTest);
-	treeInTest->SetBranchAddress("TriggerTime",&triggerTimeTest);
-
-	treeInBiFocal->SetBranchAddress("TriggerRegion",&bifocalInfo);
-	treeInBiFocal->SetBranchAddress("TriggerTime", &triggerTimeBifocal);
-
 
 	
 
 
 	//cout<<"Here Again"<<endl;
-	TFile *fileDownloadReady = new TFile(downloadFileName.c_str(),"RECREATE");
+	fileDownloadReady->cd();
 
 	vector<unsigned short> pixIDsROI;
 	vector<unsigned short> musicIDsROI;
@@ -660,7 +584,8 @@ void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix){
 		//cout<<"Processing Event: "<<i<<endl;
 		
 		//fileExtractedData->cd();
-		treeInBiFocal->GetEntry(i);
+		extractedBiFocal->GetEntry(i);
+		triggerTimeBifocal = extractedBiFocal->GetTriggerTime();
 
 		pixIDsROI = bifocalInfo->GetROIPixelIDs();
 		musicIDsROI = bifocalInfo->GetTrigMUSICIDs();
@@ -735,7 +660,8 @@ void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix){
 	//cout<<"Next"<<endl;
 	for(int i = 0; i<nEventsTest;i++){
 		fileExtractedData->cd();
-		treeInTest->GetEntry(i);
+		extractedTest->GetEntry(i);
+		triggerTimeTest = extractedTest->GetTriggerTime();
 
 		pixIDsROI = bifocalInfoTest->GetROIPixelIDs();
 		musicIDsROI = bifocalInfoTest->GetTrigMUSICIDs();
@@ -804,13 +730,37 @@ void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix){
 	treeOutHLED->Fill();
 	treeOutForced->Fill();
 	treeOutCorrectionFactor->Fill();
+
+	// the pipeline reads the trees after this returns, they must not keep the local buffers
+	treeOutBiFocal->ResetBranchAddresses();
+	treeOutGoldPlated->ResetBranchAddresses();
+	treeOutTest->ResetBranchAddresses();
+	treeOutGoldPlatedTest->ResetBranchAddresses();
+	treeOutHLED->ResetBranchAddresses();
+	treeOutForced->ResetBranchAddresses();
+	treeOutCorrectionFactor->ResetBranchAddresses();
+	treeInBiFocal->ResetBranchAddresses();
+	treeInTest->ResetBranchAddresses();
+	delete extractedBiFocal;
+	delete extractedTest;
+	//f_Correction->Close();
+
+
+}
+
+void EventDiscrimination(ReadConfiguration *readConf, string dataFilePrefix){
+	string extractedFileName = dataFilePrefix + "_Extracted.root";
+	string downloadFileName = dataFilePrefix + "_Download.root";
+
+	TFile *fileExtractedData = new TFile(extractedFileName.c_str(), "READ");
+	TFile *fileDownloadReady = new TFile(downloadFileName.c_str(),"RECREATE");
+
+	EventDiscrimination(readConf, dataFilePrefix, fileExtractedData, fileDownloadReady);
+
 	fileDownloadReady->Write();
 	//cout<<"Write"<<endl;
 	fileDownloadReady->Close();
 	fileExtractedData->Close();
-	//f_Correction->Close();
-
-
 }
 
 void SaveCalibrationCoefficients(ReadConfiguration *readConf, vector<float> correctionFactors, string dataFilePrefix){
@@ -891,17 +841,14 @@ vector<float> CompareCalibrationCoefficients(ReadConfiguration *readConf, vector
 	return correctionFactors;
 }
 
-void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix){
+void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix, TDirectory *fileIn){
 	/* Software calibration of SiPMs.
 	The response of SiPMs biased to similar bias Voltage should be the same
 	with the only variation that arising from Poisson Statistics. 
 	The HLED has 5 different amplitudes. 
 	*/
 	
-	string dataFileName = dataFilePrefix + "_Extracted.root";
-	//cout<<dataFileName<<endl;
 	string mostRecentCalibrationFile;
-	TFile *fileIn = new TFile(dataFileName.c_str(),"READ");
 	TTree *treeInHLED = (TTree*)fileIn->Get("HLED");
 	TTree *treeInForced = (TTree*)fileIn->Get("Forced");
 	TTree *treeInBiFocal = (TTree*)fileIn->Get("BiFocal");
@@ -915,7 +862,7 @@ void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix){
 	nEventsForced = treeInForced->GetEntries();
 	nEventsBiFocal = treeInBiFocal->GetEntries();
 
-	ExtractedData *extractedDataHLED[readConf->nPixelsCamera];
+	IExtractedTree *extractedHLED = new IExtractedTree(treeInHLED, readConf->nPixelsCamera);
 
 	vector<float> corrFactor = vector<float>(readConf->nPixelsCamera, 1.0);
 
@@ -923,9 +870,6 @@ void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix){
 
 	for (int i = 0; i<readConf->nPixelsCamera; i++){
 		corrFactor[i] = 0.0;
-		extractedDataHLED[i] = 0;
-		extractedDataHLED[i] = new ExtractedData();
-		treeInHLED->SetBranchAddress(TString::Format("Pixel[%d]",i),&extractedDataHLED[i]);
 	}
 	
 
@@ -935,9 +879,9 @@ void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix){
 	cout<<"HLED Events"<<nEventsHLED<<endl;
 	if(nEventsHLED>0){
 		for (int i = 0; i<nEventsHLED; i++){
-			treeInHLED->GetEntry(i);
+			extractedHLED->GetEntry(i);
 			for(int j = 0; j<readConf->nPixelsCamera; j++){
-				corrFactor[j] += extractedDataHLED[j]->GetAmplitude();
+				corrFactor[j] += extractedHLED->GetAmplitude(j);
 			}
 		}
 		for(int i = 0; i<readConf->nPixelsCamera; i++){
@@ -976,11 +920,20 @@ void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix){
 	
 
 	cout<<"Closing CorrectionFactor File"<<endl;
-	fileIn->Close();
+	treeInHLED->ResetBranchAddresses();
+	delete extractedHLED;
 	
 	
 }
 
+void HLEDCalibration(ReadConfiguration *readConf, string dataFilePrefix){
+	string dataFileName = dataFilePrefix + "_Extracted.root";
+	//cout<<dataFileName<<endl;
+	TFile *fileIn = new TFile(dataFileName.c_str(),"READ");
+	HLEDCalibration(readConf, dataFilePrefix, fileIn);
+	fileIn->Close();
+}
+
 // void HLEDCalibration(ReadConfiguration *readConf, string correctionFilePrefix, Display *display){
 // 	/* Software calibration of SiPMs.
 // 	The response of SiPMs biased to similar bias Voltage should be the same
@@ -1140,9 +1093,10 @@ bool CheckFileExistsTString(TString fileName){
 	return isFileExists;
 }
 
-void EventPrioritizer(std::string dataFilePrefix, string outputFileDirectory){
-	string downloadFileName = dataFilePrefix + "_Download"+".root";
-
+/**
+ * Writes the CT_*.dat download files from the trees of _Download.root in f_data.
+ */
+void EventPrioritizer(TDirectory *f_data, string outputFileDirectory){
 	/*
 	used for trimming the date to the right format
 	TDatime returns YYYYMMDD which for this year is
@@ -1162,7 +1116,6 @@ void EventPrioritizer(std::string dataFilePrefix, string outputFileDirectory){
 
 	//cout<<outputFileDirectory<<endl;
 
-	TFile *f_data = new TFile(downloadFileName.c_str(),"READ");
 	TTree *treeInBiFocal, *treeInHLED, *treeInForced, *treeInGoldPlated, *treeInCorrectionFactor;
 	TTree *treeInTest, *treeInGoldPlatedTest;
 
@@ -1278,11 +1231,108 @@ void EventPrioritizer(std::string dataFilePrefix, string outputFileDirectory){
 	fileOutDownload->Write();
 	fileOutDownload->Close();
 
-	
+	//cout<<"Bye"<<endl;
+}
+
+void EventPrioritizer(std::string dataFilePrefix, string outputFileDirectory){
+	string downloadFileName = dataFilePrefix + "_Download"+".root";
+
+	TFile *f_data = new TFile(downloadFileName.c_str(),"READ");
+	EventPrioritizer(f_data, outputFileDirectory);
+
 	f_data->cd();
 	f_data->Close();
+}
 
-	//cout<<"Bye"<<endl;
+/**
+ * Upper bound of the memory the extracted trees of a run take, uncompressed, from the
+ * number of events in the HLED, Forced, BiFocal and Test trees of fileName.
+ */
+Long64_t EstimateExtractedBytes(ReadConfiguration *readConf, string fileName){
+	const char *treeNames[] = {"HLED", "Forced", "BiFocal", "Test"};
+	Long64_t nEvents = 0;
+
+	TFile *file = new TFile(fileName.c_str(),"READ");
+	if(!file->IsZombie()){
+		for(int i = 0; i<4; i++){
+			TTree *tree = (TTree*)file->Get(treeNames[i]);
+			if(tree) nEvents += tree->GetEntries();
+		}
+	}
+	file->Close();
+	delete file;
+	return nEvents*readConf->nPixelsCamera*(Long64_t)sizeof(ExtractedData);
+}
+
+/**
+ * File for the _Extracted.root or _Download.root trees of the pipeline: written to disk
+ * with KEEPINTERMEDIATE, a TMemFile if inMemory, a temporary file next to it otherwise.
+ */
+TFile *OpenIntermediateFile(ReadConfiguration *readConf, string fileName, bool inMemory){
+	TFile *file;
+	if(readConf->keepIntermediate){
+		file = new TFile(fileName.c_str(),"RECREATE");
+	}else if(inMemory){
+		file = new TMemFile(fileName.c_str(),"RECREATE");
+	}else{
+		// does not replace an _Extracted.root of an earlier run
+		file = new TFile((fileName + ".tmp").c_str(),"RECREATE");
+	}
+	return file;
+}
+
+void CloseIntermediateFile(ReadConfiguration *readConf, TFile *file){
+	bool isTemporary = !readConf->keepIntermediate && file->IsWritable() && !file->InheritsFrom("TMemFile");
+	string fileName = file->GetName();
+	if(readConf->keepIntermediate && file->IsWritable()){
+		file->cd();
+		file->Write();
+	}
+	file->Close();
+	delete file;
+	if(isTemporary){
+		remove(fileName.c_str());
+	}
+}
+
+/**
+ * Extraction, calibration, discrimination and prioritisation of a run in one process.
+ * Each stage takes the trees the previous one left in memory instead of reading them
+ * back from _Extracted.root and _Download.root, which are only written with KEEPINTERMEDIATE.
+ * The correction factors are still saved to and loaded from _CorrectionFactor.txt, later
+ * runs compare their calibration against it.
+ */
+void Pipeline(ReadConfiguration *readConf, string dataFilePrefix, string outputFileDirectory){
+	string extractedFileName = dataFilePrefix + "_Extracted.root";
+	string downloadFileName = dataFilePrefix + "_Download.root";
+
+	// the events of the run are counted in the file the extracted trees come from
+	bool isExtracting = readConf->pulseExtraction || !CheckFileExists(extractedFileName);
+	Long64_t expectedBytes = EstimateExtractedBytes(readConf, isExtracting ? dataFilePrefix + ".root" : extractedFileName);
+	bool inMemory = expectedBytes <= (Long64_t)readConf->memoryLimitMB*1024*1024;
+	if(!readConf->keepIntermediate && !inMemory){
+		cout << "Extracted events take up to " << expectedBytes/(1024*1024) << " MB, above MEMORYLIMITMB: intermediate trees written to temporary files" << endl;
+	}
+
+	TFile *fileExtracted;
+	if(isExtracting){
+		fileExtracted = OpenIntermediateFile(readConf, extractedFileName, inMemory);
+		PulseExtraction(readConf, dataFilePrefix, fileExtracted);
+	}else{
+		cout << "Using extracted data of " << extractedFileName << endl;
+		fileExtracted = new TFile(extractedFileName.c_str(),"READ");
+	}
+
+	HLEDCalibration(readConf, dataFilePrefix, fileExtracted);
+
+	TFile *fileDownload = OpenIntermediateFile(readConf, downloadFileName, inMemory);
+	EventDiscrimination(readConf, dataFilePrefix, fileExtracted, fileDownload);
+
+	EventPrioritizer(fileDownload, outputFileDirectory);
+
+	CloseIntermediateFile(readConf, fileDownload);
+	CloseIntermediateFile(readConf, fileExtracted);
+	cout<<"Done"<<endl;
 }
 
 
@@ -1500,37 +1550,49 @@ int main (int argc, char **argv){
 		// that fulfill bifocal condition.
 		StarlinkFileExtraction(readConf, dataFilePrefix);
 
-		// First Extract all fo the events obtained for the data arquisition
-		// run. Every event is reduced to charge and amplitude which will be
-		// calibrated, discriminated and prioritized in later steps.
+		// With PIPELINE the stages below run in one pass, sharing their trees in memory
+		if(readConf->isPipeline){
+			Pipeline(readConf, dataFilePrefix, outputFileDirectory);
+		}else{
+
+			// First Extract all fo the events obtained for the data arquisition
+			// run. Every event is reduced to charge and amplitude which will be
+			// calibrated, discriminated and prioritized in later steps.
 
-		PulseExtraction(readConf,dataFilePrefix);
+			// The EventBuilder extracts the pulses itself when run with --extract,
+			// PULSEEXTRACTION 0 then uses its _Extracted.root file.
+			if(readConf->pulseExtraction || !CheckFileExists(dataFilePrefix + "_Extracted.root")){
+				PulseExtraction(readConf,dataFilePrefix);
+			}else{
+				cout << "Using extracted data of " << dataFilePrefix << "_Extracted.root" << endl;
+			}
 
-		//Prepare HLED correction Factors for this run.
+			//Prepare HLED correction Factors for this run.
 
-		/*If HLED calibration finds only HLED events and # events exceeds
-		400 per amplitude. Will consider it an HLED calibration run and will 
-		generate a file with correction factors*/
+			/*If HLED calibration finds only HLED events and # events exceeds
+			400 per amplitude. Will consider it an HLED calibration run and will 
+			generate a file with correction factors*/
 
-		HLEDCalibration(readConf, dataFilePrefix);
+			HLEDCalibration(readConf, dataFilePrefix);
 
-		//Discriminator
+			//Discriminator
 
-		// Look at BiFocal events and remove accidental triggers from 
-		// dataset. Algorithm to looks at the triggered MUSICs,
-		// and find the maximum amplitude signal. Check if there is a corresponding
-		// signal in the pixel expected.
-		// Impose a software threshold to ensure that both signals are a copy of 
-		// each other.
+			// Look at BiFocal events and remove accidental triggers from 
+			// dataset. Algorithm to looks at the triggered MUSICs,
+			// and find the maximum amplitude signal. Check if there is a corresponding
+			// signal in the pixel expected.
+			// Impose a software threshold to ensure that both signals are a copy of 
+			// each other.
 
-		EventDiscrimination(readConf, dataFilePrefix);
+			EventDiscrimination(readConf, dataFilePrefix);
 
-		//Prioritizer
+			//Prioritizer
 
-		EventPrioritizer(dataFilePrefix, outputFileDirectory);
+			EventPrioritizer(dataFilePrefix, outputFileDirectory);
 
-		//File for download
-		// OutFilesDownload(readConf,dataFilePrefix,outputFileDirectory);
+			//File for download
+			// OutFilesDownload(readConf,dataFilePrefix,outputFileDirectory);
+		}
 	}else{
 		// Here is where you will write your own modular methods //
 		/* IPlotTools.h and IPlotTools.cpp show how modular methods for analysis should be 
@@ -90,6 +90,13 @@ DataRouter::DataRouter(const ::utl::net::SocketAddress& flowEndpoint, const std:
 		dataProcessor.reset(new FrameStorage());
 		dataReceiver->set_dataProcessorCore(dataProcessor);
 	}
+	else if (dataProcessorType == "IndexedFrameStorage")
+	{
+		FrameStorage* storage = new FrameStorage();
+		storage->setFrameIndexing(true);
+		dataProcessor.reset(storage);
+		dataReceiver->set_dataProcessorCore(dataProcessor);
+	}
 	else
 	{
 		throw "Unknown data processor type: '" + dataProcessorType + "'";
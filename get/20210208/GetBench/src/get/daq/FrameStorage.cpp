@@ -49,7 +49,7 @@ namespace get
 namespace daq
 {
 
-FrameStorage::FrameStorage() : maxFileSize_MiB(1024u), fileDirectory(".")
+FrameStorage::FrameStorage() : maxFileSize_MiB(1024u), fileDirectory("."), frameIndexing(false)
 {
 	LOG_DEBUG() << "Creating FrameStorage " << std::hex << this << std::dec;
 	// Load Cobo format
@@ -67,6 +67,7 @@ FrameStorage::StorageInfo::StorageInfo(const StorageInfo & r)
  :
 	previousEventIdx(r.previousEventIdx),
 	fileName(r.fileName),
+	indexFileName(r.indexFileName),
 	fileIndex(r.fileIndex)
 {
 }
@@ -95,6 +96,19 @@ void FrameStorage::setOutputDirectory(const std::string & dir)
 	fileDirectory = dir;
 }
 
+/**
+ * Enables writing of a sidecar frame index for each new file.
+ * The index of CoBo<n>_AsAd<m>_<timestamp>_<idx>.graw is CoBo<n>_AsAd<m>_<timestamp>_<idx>.gidx.
+ * It starts with a 16 byte header ("GIDX", version, record size, reserved) followed by one
+ * 24 byte record per frame: offset (64 bits), frame size in bytes, eventIdx (32 bits each),
+ * frame type (16 bits), CoBo index, AsAd index (8 bits each), reserved (32 bits), all little endian.
+ * The same layout is read by the EventBuilder GrawReader.
+ */
+void FrameStorage::setFrameIndexing(bool enable)
+{
+	frameIndexing = enable;
+}
+
 void FrameStorage::resetData()
 {
 	reset(); // Discard pending data frame chunks
@@ -190,6 +204,11 @@ void FrameStorage::processFrame(mfm::Frame& frame)
 	const size_t fileSize_B = file.tellp();
 	closeFile(sourceUID);
 
+	if (frameIndexing)
+	{
+		appendIndexRecord(sourceUID, fileSize_B - frame.header().frameSize_B(), frame, eventIdx);
+	}
+
 	// Create new file if maximum file size has been reached
 	if (fileSize_B > maxFileSize_MiB*0x100000)
 	{
@@ -197,6 +216,37 @@ void FrameStorage::processFrame(mfm::Frame& frame)
 	}
 }
 
+/**
+ * Appends the index record of a frame just written to the data file of a source.
+ * @param sourceIdx ID of AsAd board or MuTanT module.
+ * @param offset Position of the frame in the data file.
+ */
+void FrameStorage::appendIndexRecord(const SourceUID & sourceIdx, uint64_t offset, const mfm::Frame & frame, uint32_t eventIdx)
+{
+	StorageInfo & storage = storages[sourceIdx];
+	if (storage.indexFileName.empty()) return;
+
+	uint8_t record[24] = {};
+	const uint64_t frameSize_B = frame.header().frameSize_B();
+	const uint16_t frameType = frame.header().frameType();
+	for (size_t i = 0; i < 8; ++i) record[i] = (offset >> (8*i)) & 0xFF;
+	for (size_t i = 0; i < 4; ++i) record[8+i] = (frameSize_B >> (8*i)) & 0xFF;
+	for (size_t i = 0; i < 4; ++i) record[12+i] = (eventIdx >> (8*i)) & 0xFF;
+	record[16] = frameType & 0xFF;
+	record[17] = frameType >> 8;
+	record[18] = sourceIdx.first & 0xFF;
+	record[19] = sourceIdx.second & 0xFF;
+
+	storage.indexFile.clear();
+	storage.indexFile.open(storage.indexFileName.c_str(), std::ios::binary | std::ios::out | std::ios::app);
+	storage.indexFile.write(reinterpret_cast< const char* >(record), sizeof(record));
+	if (not storage.indexFile.good())
+	{
+		LOG_ERROR() << "Error writing frame index to file " << storage.indexFileName;
+	}
+	storage.indexFile.close();
+}
+
 void FrameStorage::processHeader(const mfm::PrimaryHeader & header)
 {
 	LOG_DEBUG() << "Building frame of " << header.frameSize_B() << " B";
@@ -305,6 +355,23 @@ void FrameStorage::createNewFile(const std::string & prefix, const SourceUID & s
 	}
 	closeFile(sourceIdx);
 	LOG_INFO() << "New file: " << storage.fileName;
+
+	// Sidecar frame index, header only until frames are stored
+	storage.indexFileName.clear();
+	if (frameIndexing)
+	{
+		storage.indexFileName = storage.fileName.substr(0, storage.fileName.size() - 5) + ".gidx";
+		const uint8_t header[16] = { 'G', 'I', 'D', 'X', 1, 0, 0, 0, 24, 0, 0, 0, 0, 0, 0, 0 };
+		storage.indexFile.clear();
+		storage.indexFile.open(storage.indexFileName.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
+		storage.indexFile.write(reinterpret_cast< const char* >(header), sizeof(header));
+		if (not storage.indexFile.good())
+		{
+			LOG_ERROR() << "Could not create frame index " << storage.indexFileName;
+			storage.indexFileName.clear();
+		}
+		storage.indexFile.close();
+	}
 }
 
 } // namespace daq
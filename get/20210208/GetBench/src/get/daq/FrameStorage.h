@@ -62,6 +62,7 @@ public:
 	std::ofstream & getFile(const SourceUID & sourceIdx, const size_t & eventIdx);
 	std::ofstream & openFile(const SourceUID & sourceIdx);
 	void setOutputDirectory(const std::string & dir);
+	void setFrameIndexing(bool enable);
 	void closeFile(const SourceUID & sourceIdx);
 	void createNewFile(const std::string & prefix, const SourceUID & asadIdx, bool newTimeStamp=false);
 	/**
@@ -72,6 +73,8 @@ public:
 		uint32_t previousEventIdx; ///< Event ID of last event.
 		std::ofstream dataFile; ///< File for storage.
 		std::string fileName; ///< File name.
+		std::ofstream indexFile; ///< Sidecar frame index of the file, if enabled.
+		std::string indexFileName; ///< Index file name.
 		size_t fileIndex; ///< Index of file.
 		StorageInfo();
 		StorageInfo(const StorageInfo &);
@@ -79,12 +82,14 @@ public:
 private:
 	FrameStorage(const FrameStorage& r);
 	FrameStorage& operator=(const FrameStorage& r);
+	void appendIndexRecord(const SourceUID & sourceIdx, uint64_t offset, const mfm::Frame & frame, uint32_t eventIdx);
 private:
 	std::map < SourceUID, StorageInfo > storages;
 	std::string filePrefix;
 	std::string fileTimestamp;
 	size_t maxFileSize_MiB;
 	std::string fileDirectory; ///< Path of directory to start the frames to.
+	bool frameIndexing; ///< Whether to write a .gidx frame index next to each .graw file.
 };
 
 } // namespace daq
@@ -56,7 +56,7 @@ int main(int argc, char* argv[])
 	::utl::BackendLogger::setBackend(::utl::LoggingBackendPtr(new ::mdaq::utl::ConsoleLoggingBackend));
 
 	std::ostringstream usage;
-	usage << "Usage: " << argv[0] << " <[ctrl-ipAddr]:[port]>  <[data-ipAddr]:[port]> [ICE|TCP|FDT] [ByteCounter|ByteStorage|FrameCounter|FrameStorage] [Ice arguments]";
+	usage << "Usage: " << argv[0] << " <[ctrl-ipAddr]:[port]>  <[data-ipAddr]:[port]> [ICE|TCP|FDT] [ByteCounter|ByteStorage|FrameCounter|FrameStorage|IndexedFrameStorage] [Ice arguments]";
 	try
 	{
 		CmdLineArgs args = CmdLineArgs::build(argc, argv);
@@ -83,7 +83,7 @@ int main(int argc, char* argv[])
 		const std::string processorType = args.size() > 4 ? args[4] : "FrameStorage";
 
 		// Load frame formats
-		if ("FrameStorage" == processorType)
+		if ("FrameStorage" == processorType or "IndexedFrameStorage" == processorType)
 		{
 			mfm::FrameDictionary::instance().addFormats("CoboFormats.xcfg");
 		}